@@ -14,6 +14,7 @@
 #include "esp_jpg_decode.h"
 
 #include "esp_system.h"
+#include "esp_camera_trace.h"
 #if ESP_IDF_VERSION_MAJOR >= 4 // IDF 4+
 #if CONFIG_IDF_TARGET_ESP32 // ESP32/PICO-D4
 #include "esp32/rom/tjpgd.h"
@@ -104,7 +105,9 @@ esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jp
     jpeg.scale = scale;
     jpeg.index = 0;
 
+    CAM_TRACE_BEGIN("jd_prepare");
     JRESULT jres = jd_prepare(&decoder, _jpg_read, work, 3100, &jpeg);
+    CAM_TRACE_END("jd_prepare");
     if(jres != JDR_OK){
         ESP_LOGE(TAG, "JPG Header Parse Failed! %s", jd_errors[jres]);
         return ESP_FAIL;
@@ -116,7 +119,9 @@ esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jp
     //output start
     writer(arg, 0, 0, output_width, output_height, NULL);
     //output write
+    CAM_TRACE_BEGIN("jd_decomp");
     jres = jd_decomp(&decoder, _jpg_write, (uint8_t)jpeg.scale);
+    CAM_TRACE_END("jd_decomp");
     //output end
     writer(arg, output_width, output_height, output_width, output_height, NULL);
 
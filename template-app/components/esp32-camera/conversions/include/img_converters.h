@@ -0,0 +1,301 @@
+// Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef _IMG_CONVERTERS_H_
+#define _IMG_CONVERTERS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_camera.h"
+#include "esp_jpg_decode.h"
+
+/**
+ * @brief JPEG output callback
+ *
+ * Called with consecutive pieces of the encoded image as they are produced, and
+ * once more with data == NULL and len == 0 when the image is complete.
+ *
+ * @param arg       Pointer passed to fmt2jpg_cb/frame2jpg_cb
+ * @param index     Offset of data in the output image
+ * @param data      Encoded bytes
+ * @param len       Number of bytes in data
+ *
+ * @return number of bytes consumed. Returning less than len aborts the encoding.
+ */
+typedef size_t (* jpg_out_cb)(void * arg, size_t index, const void* data, size_t len);
+
+/**
+ * @brief JPEG encoder forward DCT
+ */
+typedef enum {
+    JPG_DCT_ACCURATE,   /*!< Integer DCT with 12 multiplies per 1-D pass, quantization by division */
+    JPG_DCT_FAST,       /*!< AAN DCT with 5 multiplies per 1-D pass, scaling folded into the quantization */
+} jpg_dct_t;
+
+#if CONFIG_CAMERA_JPEG_ENCODER_FAST_DCT
+#define JPG_DCT_DEFAULT JPG_DCT_FAST
+#else
+#define JPG_DCT_DEFAULT JPG_DCT_ACCURATE
+#endif
+
+/**
+ * @brief JPEG encoder quantization profile
+ *
+ * Base quantization tables, and chroma subsampling, tuned for one use. The quality scales them
+ * like the standard tables: at quality 50 they are used as they are.
+ */
+typedef enum {
+    JPG_PROFILE_DEFAULT,    /*!< "default": the standard tables of ITU-T T.81 Annex K, 4:2:0 */
+    JPG_PROFILE_OCR_TEXT,   /*!< "ocr-text": fine luma steps up to the highest frequencies so thin strokes stay
+                                 sharp, chroma cut to one colour per 16x16 block, 4:2:0 */
+    JPG_PROFILE_THUMBNAIL,  /*!< "thumbnail": high frequencies and chroma quantized away, smallest files, 4:2:0 */
+    JPG_PROFILE_ARCHIVE,    /*!< "archive": a third of the standard luma steps for all components, 4:4:4 */
+    JPG_PROFILE_MAX,
+} jpg_profile_t;
+
+/**
+ * @brief JPEG encoder settings for fmt2jpg_cb_ex/fmt2jpg_ex/frame2jpg_cb_ex/frame2jpg_ex
+ */
+typedef struct {
+    uint8_t quality;                /*!< JPEG quality, 1-100 */
+    jpg_dct_t dct;                  /*!< Forward DCT */
+    int bands;                      /*!< Bands encoded in parallel as in fmt2jpg_cb_parallel, <= 1 for one */
+    jpg_profile_t profile;          /*!< Quantization profile, JPG_PROFILE_DEFAULT if out of range */
+    const uint8_t *luma_quant;      /*!< Custom base luma table instead of the profile's: 64 steps of 1-255 in
+                                         row major (not zigzag) order, scaled by quality, or NULL */
+    const uint8_t *chroma_quant;    /*!< Custom base chroma table instead of the profile's, as luma_quant, or NULL */
+    bool optimize_huffman;          /*!< Huffman tables optimized for the image, in two passes: typically 2-10% smaller,
+                                         at the cost of a symbol store (CONFIG_CAMERA_JPEG_HUFFMAN_STORE_KB) and
+                                         of encoding time. One set of tables per image: bands is then ignored */
+} jpg_encoder_config_t;
+
+#define JPG_ENCODER_CONFIG_DEFAULT(q) { (q), JPG_DCT_DEFAULT, 1, JPG_PROFILE_DEFAULT, NULL, NULL, false }
+
+/**
+ * @brief Look up a JPEG encoder profile by name
+ *
+ * @param name      "default", "ocr-text", "thumbnail" or "archive", may be NULL
+ *
+ * @return the profile, JPG_PROFILE_MAX for an unknown name
+ */
+jpg_profile_t jpg_profile_from_name(const char *name);
+
+/**
+ * @brief Convert image buffer to JPEG
+ *
+ * YUYV (PIXFORMAT_YUV422, BT.601 studio range) frames of even width are encoded from their YCbCr
+ * samples, without a conversion to RGB and back.
+ *
+ * @param src       Source buffer in RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param quality   JPEG quality of the resulting image
+ * @param cp        Callback to be called to write the bytes of the output JPEG
+ * @param arg       Pointer to be passed to the callback
+ *
+ * @return true on success
+ */
+bool fmt2jpg_cb(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, jpg_out_cb cb, void * arg);
+
+/**
+ * @brief Convert camera frame buffer to JPEG
+ *
+ * @param fb        Source camera frame buffer
+ * @param quality   JPEG quality of the resulting image
+ * @param cp        Callback to be called to write the bytes of the output JPEG
+ * @param arg       Pointer to be passed to the callback
+ *
+ * @return true on success
+ */
+bool frame2jpg_cb(camera_fb_t * fb, uint8_t quality, jpg_out_cb cb, void * arg);
+
+/**
+ * @brief Convert camera frame buffer to JPEG with the given encoder settings
+ *
+ * @param fb        Source camera frame buffer
+ * @param config    Encoder settings, see JPG_ENCODER_CONFIG_DEFAULT
+ * @param cp        Callback to be called to write the bytes of the output JPEG
+ * @param arg       Pointer to be passed to the callback
+ *
+ * @return true on success
+ */
+bool frame2jpg_cb_ex(camera_fb_t * fb, const jpg_encoder_config_t *config, jpg_out_cb cb, void * arg);
+
+/**
+ * @brief Convert image buffer to JPEG, encoding horizontal bands of the image in parallel
+ *
+ * The image is split into up to `bands` bands of whole MCU rows (at most 8). The calling task
+ * encodes the first band and one task per other band, pinned round-robin to the cores at the
+ * caller's priority, encodes the rest. The bands are joined with restart markers (DRI/RSTn)
+ * into one baseline JPEG, written to the callback in order. bands <= 1 is fmt2jpg_cb.
+ *
+ * @param src       Source buffer in RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param quality   JPEG quality of the resulting image
+ * @param bands     Number of bands encoded at the same time, e.g. 2 on a dual core ESP32
+ * @param cp        Callback to be called to write the bytes of the output JPEG
+ * @param arg       Pointer to be passed to the callback
+ *
+ * @return true on success
+ */
+bool fmt2jpg_cb_parallel(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, int bands, jpg_out_cb cb, void * arg);
+
+/**
+ * @brief Convert image buffer to JPEG with the given encoder settings
+ *
+ * @param src       Source buffer in RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param config    Encoder settings, see JPG_ENCODER_CONFIG_DEFAULT
+ * @param cp        Callback to be called to write the bytes of the output JPEG
+ * @param arg       Pointer to be passed to the callback
+ *
+ * @return true on success
+ */
+bool fmt2jpg_cb_ex(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, const jpg_encoder_config_t *config, jpg_out_cb cb, void * arg);
+
+/**
+ * @brief Convert image buffer to JPEG buffer
+ *
+ * @param src       Source buffer in RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param quality   JPEG quality of the resulting image
+ * @param out       Pointer to be populated with the address of the resulting buffer.
+ *                  You MUST free the pointer once you are done with it.
+ * @param out_len   Pointer to be populated with the length of the output buffer
+ *
+ * @return true on success
+ */
+bool fmt2jpg(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, uint8_t ** out, size_t * out_len);
+
+/**
+ * @brief Convert image buffer to JPEG buffer, encoding horizontal bands of the image in parallel
+ *
+ * See fmt2jpg_cb_parallel. bands <= 1 is fmt2jpg.
+ *
+ * @param src       Source buffer in RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param quality   JPEG quality of the resulting image
+ * @param bands     Number of bands encoded at the same time
+ * @param out       Pointer to be populated with the address of the resulting buffer.
+ *                  You MUST free the pointer once you are done with it.
+ * @param out_len   Pointer to be populated with the length of the output buffer
+ *
+ * @return true on success
+ */
+bool fmt2jpg_parallel(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, int bands, uint8_t ** out, size_t * out_len);
+
+/**
+ * @brief Convert image buffer to JPEG buffer with the given encoder settings
+ *
+ * @param src       Source buffer in RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param config    Encoder settings, see JPG_ENCODER_CONFIG_DEFAULT
+ * @param out       Pointer to be populated with the address of the resulting buffer.
+ *                  You MUST free the pointer once you are done with it.
+ * @param out_len   Pointer to be populated with the length of the output buffer
+ *
+ * @return true on success
+ */
+bool fmt2jpg_ex(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, const jpg_encoder_config_t *config, uint8_t ** out, size_t * out_len);
+
+/**
+ * @brief Convert camera frame buffer to JPEG buffer
+ *
+ * @param fb        Source camera frame buffer
+ * @param quality   JPEG quality of the resulting image
+ * @param out       Pointer to be populated with the address of the resulting buffer
+ * @param out_len   Pointer to be populated with the length of the output buffer
+ *
+ * @return true on success
+ */
+bool frame2jpg(camera_fb_t * fb, uint8_t quality, uint8_t ** out, size_t * out_len);
+
+/**
+ * @brief Convert camera frame buffer to JPEG buffer with the given encoder settings
+ *
+ * @param fb        Source camera frame buffer
+ * @param config    Encoder settings, see JPG_ENCODER_CONFIG_DEFAULT
+ * @param out       Pointer to be populated with the address of the resulting buffer
+ * @param out_len   Pointer to be populated with the length of the output buffer
+ *
+ * @return true on success
+ */
+bool frame2jpg_ex(camera_fb_t * fb, const jpg_encoder_config_t *config, uint8_t ** out, size_t * out_len);
+
+/**
+ * @brief Convert image buffer to BMP buffer
+ *
+ * @param src       Source buffer in JPEG, RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param out       Pointer to be populated with the address of the resulting buffer
+ * @param out_len   Pointer to be populated with the length of the output buffer
+ *
+ * @return true on success
+ */
+bool fmt2bmp(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t ** out, size_t * out_len);
+
+/**
+ * @brief Convert camera frame buffer to BMP buffer
+ *
+ * @param fb        Source camera frame buffer
+ * @param out       Pointer to be populated with the address of the resulting buffer
+ * @param out_len   Pointer to be populated with the length of the output buffer
+ *
+ * @return true on success
+ */
+bool frame2bmp(camera_fb_t * fb, uint8_t ** out, size_t * out_len);
+
+/**
+ * @brief Convert image buffer to RGB888 buffer (used for face detection)
+ *
+ * @param src       Source buffer in JPEG, RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param format    Format of the source image
+ * @param rgb_buf   Pointer to the output buffer (width * height * 3)
+ *
+ * @return true on success
+ */
+bool fmt2rgb888(const uint8_t *src_buf, size_t src_len, pixformat_t format, uint8_t * rgb_buf);
+
+bool jpg2rgb565(const uint8_t *src, size_t src_len, uint8_t * out, jpg_scale_t scale);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IMG_CONVERTERS_H_ */
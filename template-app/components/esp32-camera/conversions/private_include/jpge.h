@@ -0,0 +1,278 @@
+// jpge.h - C++ class for JPEG compression.
+// Public domain, Rich Geldreich <richgel99@gmail.com>
+// Alex Evans: Added RGBA support, linear memory allocator.
+#ifndef JPEG_ENCODER_H
+#define JPEG_ENCODER_H
+
+#include <stddef.h>
+
+namespace jpge
+{
+    typedef unsigned char  uint8;
+    typedef signed short   int16;
+    typedef signed int     int32;
+    typedef unsigned short uint16;
+    typedef unsigned int   uint32;
+    typedef unsigned int   uint;
+
+    // JPEG chroma subsampling factors. Y_ONLY (grayscale images) and H2V2 (color images) are the most common.
+    enum subsampling_t { Y_ONLY = 0, H1V1 = 1, H2V1 = 2, H2V2 = 3 };
+
+    // Forward DCT. DCT_LLM: the accurate jfdctint-derived DCT (12 multiplies per 1-D pass) and
+    // quantization by division. DCT_AAN: the jfdctfst-style AAN DCT (5 multiplies per 1-D pass)
+    // whose output scaling is folded into the quantization, done as multiply and shift.
+    enum dct_t { DCT_LLM = 0, DCT_AAN = 1 };
+
+    // Layout of the scanlines passed to process_scanline().
+    // INPUT_CHANNELS: src_channels (1, 3 or 4) bytes per pixel, Y, RGB or RGBA.
+    // INPUT_YUYV: YUV 4:2:2 as Y0 Cb Y1 Cr, src_channels 2 and an even width, in the BT.601 studio range
+    // (Y 16-235, Cb/Cr 16-240) the camera sensors deliver. The samples are range expanded into the MCU
+    // lines and the blocks, chroma subsampling included, are loaded straight from there: no RGB round trip.
+    enum input_t { INPUT_CHANNELS = 0, INPUT_YUYV = 1 };
+
+    // Quantization tables for one quality, scaled from the standard tables or
+    // from custom base tables (see params::m_luma_quant).
+    // Immutable once built, so several encoders (e.g. one per task) can share
+    // one through params::m_tables.
+    struct quality_tables {
+            int m_quality;
+            const uint8 *m_luma_base, *m_chroma_base;   // as passed to init()
+            int32 m_quant[2][64];   // luma, chroma; zigzag order, as in DQT
+            // DCT_AAN: coefficient / (quant * AAN scale) as (coefficient * m_recip) >> m_shift
+            uint16 m_recip[2][64];
+            uint8 m_shift[2][64];
+
+            void init(int quality, const uint8 *luma_base = NULL, const uint8 *chroma_base = NULL);
+    };
+
+    // Canonical Huffman table: the DHT contents and the code of every symbol.
+    struct huffman_table {
+            uint8 m_bits[17];
+            uint8 m_val[256];
+            uint m_codes[256];
+            uint8 m_code_sizes[256];
+    };
+
+    // JPEG compression parameters structure.
+    struct params {
+            inline params() : m_quality(85), m_subsampling(H2V2), m_tables(NULL), m_restart_interval(0), m_dct(DCT_LLM), m_input(INPUT_CHANNELS),
+                m_luma_quant(NULL), m_chroma_quant(NULL), m_optimize_huffman(false), m_huffman_store_size(0) { }
+
+            inline bool check() const {
+                if ((m_quality < 1) || (m_quality > 100)) {
+                    return false;
+                }
+                if ((uint)m_subsampling > (uint)H2V2) {
+                    return false;
+                }
+                if (m_tables && (m_tables->m_quality != m_quality || m_tables->m_luma_base != m_luma_quant ||
+                                 m_tables->m_chroma_base != m_chroma_quant)) {
+                    return false;
+                }
+                if ((m_restart_interval < 0) || (m_restart_interval > 0xFFFF)) {
+                    return false;
+                }
+                if ((uint)m_dct > (uint)DCT_AAN) {
+                    return false;
+                }
+                if ((uint)m_input > (uint)INPUT_YUYV) {
+                    return false;
+                }
+                return true;
+            }
+
+            // MCU size in pixels for m_subsampling
+            inline int mcu_width() const { return (m_subsampling == H2V1 || m_subsampling == H2V2) ? 16 : 8; }
+            inline int mcu_height() const { return (m_subsampling == H2V2) ? 16 : 8; }
+
+            // Quality: 1-100, higher is better. Typical values are around 50-95.
+            int m_quality;
+
+            // m_subsampling:
+            // 0 = Y (grayscale) only
+            // 1 = H1V1 subsampling (YCbCr 1x1x1, 3 blocks per MCU)
+            // 2 = H2V1 subsampling (YCbCr 2x1x1, 4 blocks per MCU)
+            // 3 = H2V2 subsampling (YCbCr 4x1x1, 6 blocks per MCU-- very common)
+            subsampling_t m_subsampling;
+
+            // Optional tables built for m_quality (and m_luma_quant, m_chroma_quant) and shared between encoders.
+            // NULL: the encoder builds its own in init().
+            const quality_tables *m_tables;
+
+            // Restart interval in MCUs (DRI), 0 for none. After every interval the
+            // encoder emits an RSTn marker and the decoder can resynchronize.
+            int m_restart_interval;
+
+            // Forward DCT, see dct_t
+            dct_t m_dct;
+
+            // Scanline layout, see input_t
+            input_t m_input;
+
+            // Optional base quantization tables, 64 entries in row major (not zigzag) order, scaled by
+            // m_quality like the standard ones (50: as given, clamped to 1-255). NULL: the standard table.
+            const uint8 *m_luma_quant;
+            const uint8 *m_chroma_quant;
+
+            // Optimized Huffman tables. The first pass quantizes the image and keeps its Huffman symbols, about
+            // two bytes each, in a store of at most m_huffman_store_size bytes while counting them; at the end of
+            // the image (or when the store is full) the tables are built from the counts, the headers written and
+            // the stored symbols coded. After a full store the rest of the image is coded in one pass with those
+            // tables, which then have a code for every symbol. Whole images only (init(), not a band).
+            bool m_optimize_huffman;
+            uint m_huffman_store_size;
+    };
+    
+    // Output stream abstract class - used by the jpeg_encoder class to write to the output stream.
+    // put_buf() is generally called with len==JPGE_OUT_BUF_SIZE bytes, but for headers it'll be called with smaller amounts.
+    class output_stream {
+        public:
+            virtual ~output_stream() { };
+            virtual bool put_buf(const void* Pbuf, int len) = 0;
+            virtual size_t get_size() const = 0;
+    };
+    
+    // Lower level jpeg_encoder class - useful if more control is needed than the above helper functions.
+    // All state is per instance: separate instances may encode concurrently.
+    class jpeg_encoder {
+        public:
+            jpeg_encoder();
+            ~jpeg_encoder();
+
+            // Initializes the compressor.
+            // pStream: The stream object to use for writing compressed data.
+            // params - Compression parameters structure, defined above.
+            // width, height  - Image dimensions.
+            // channels - May be 1, or 3. 1 indicates grayscale, 3 indicates RGB source data.
+            //            2 with comp_params.m_input == INPUT_YUYV.
+            // Returns false on out of memory or if a stream write fails.
+            bool init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params = params());
+
+            // Initializes the compressor for one horizontal band of the image: the mcu_rows MCU rows
+            // (of comp_params.mcu_height() pixel lines each) starting at first_mcu_row. Several encoders,
+            // e.g. one per core, can then encode the bands of one image at the same time.
+            // comp_params.m_restart_interval must be set and both ends of the band must fall on restart
+            // interval boundaries (the end of the image always does). Only the first band emits the headers
+            // and only the last one the EOI; a band before the last ends with its RSTn marker. The outputs
+            // of all bands, concatenated in order, are the JPEG one encoder with the same params writes.
+            // Feed the band's scanlines, then NULL.
+            bool init_band(output_stream *pStream, int width, int height, int src_channels, const params &comp_params,
+                           int first_mcu_row, int mcu_rows);
+
+            // Call this method with each source scanline.
+            // width * src_channels bytes per scanline is expected (RGB, Y or YUYV format).
+            // You must call with NULL after all scanlines are processed to finish compression.
+            // Returns false on out of memory or if a stream write fails.
+            bool process_scanline(const void* pScanline);
+
+            // Deinitializes the compressor, freeing any allocated memory. May be called at any time.
+            void deinit();
+
+        private:
+            jpeg_encoder(const jpeg_encoder &);
+            jpeg_encoder &operator =(const jpeg_encoder &);
+
+            typedef int32 sample_array_t;
+            enum { JPGE_OUT_BUF_SIZE = 512 };
+
+            output_stream *m_pStream;
+            params m_params;
+            void *m_mem;                        // one allocation: own quality tables, optimized Huffman tables, MCU lines
+            const quality_tables *m_tables;
+            const huffman_table *m_huff[4];     // DC luma, DC chroma, AC luma, AC chroma
+
+            // m_params.m_optimize_huffman: symbol counts per table in m_huff order and the tables built from them
+            struct huffman_optimizer {
+                    uint32 m_count[4][256];
+                    huffman_table m_tables[4];
+            };
+            huffman_optimizer *m_optimizer;
+            uint8 *m_store;                     // first pass: symbol, then 0-2 bytes of its extra bits
+            uint m_store_len, m_store_size;
+            int m_stored_mcus;
+            uint8 m_num_components;
+            uint8 m_comp_h_samp[3], m_comp_v_samp[3];
+            int m_image_x, m_image_y, m_image_bpp, m_image_bpl;
+            int m_image_x_mcu, m_image_y_mcu;
+            int m_image_bpl_xlt, m_image_bpl_mcu;
+            int m_mcus_per_row;
+            int m_mcu_x, m_mcu_y;
+            uint8 *m_mcu_lines[16];
+            uint8 m_mcu_y_ofs;
+            sample_array_t m_sample_array[64];
+            int16 m_coefficient_array[64];
+
+            int m_last_dc_val[3];
+            uint8 m_out_buf[JPGE_OUT_BUF_SIZE];
+            uint8 *m_pOut_buf;
+            uint m_out_buf_left;
+            uint32 m_bit_buffer;
+            uint m_bits_in;
+            uint8 m_pass_num;                   // 1: first pass of m_optimize_huffman, 2: coding
+            bool m_all_stream_writes_succeeded;
+
+            int m_first_mcu_row, m_band_mcu_rows;  // the band this encoder writes
+            bool m_last_band;
+            int m_restart_mcus_left;                // MCUs before the next RSTn
+            uint m_restart_num;                     // n of the next RSTn
+
+            bool jpg_open(int p_x_res, int p_y_res, int src_channels);
+
+            void flush_output_buffer();
+            void put_bits(uint bits, uint len);
+
+            void emit_byte(uint8 i);
+            void emit_word(uint i);
+            void emit_marker(int marker);
+
+            void emit_jfif_app0();
+            void emit_dqt();
+            void emit_sof();
+            void emit_dht(const huffman_table *table, int index, bool ac_flag);
+            void emit_dhts();
+            void emit_sos();
+            void emit_dri();
+            void emit_restart();
+            void emit_start_of_image();
+            inline void start_mcu() {
+                if (m_pass_num == 1) {
+                    start_stored_mcu();
+                }
+                if (m_params.m_restart_interval) {
+                    if (!m_restart_mcus_left) {
+                        emit_restart();
+                    }
+                    m_restart_mcus_left--;
+                }
+            }
+
+            void load_quantized_coefficients(int component_num);
+            void load_quantized_coefficients_aan(int component_num);
+
+            void load_block_8_8_grey(int x);
+            void load_block_8_8(int x, int y, int c);
+            void load_block_16_8(int x, int c);
+            void load_block_16_8_8(int x, int c);
+            void load_block_yuyv_y(int x, int y);
+            void load_block_yuyv_8_8(int x, int c);
+            void load_block_yuyv_16_8(int x, int c);
+            void load_block_yuyv_16_8_8(int x, int c);
+
+            void code_coefficients_pass_one(int component_num);
+            void code_coefficients_pass_two(int component_num);
+            const uint8 *code_stored_block(const uint8 *pSrc, int component_num);
+            void start_stored_mcu();
+            void end_pass_one(bool every_symbol);
+            void code_block(int component_num);
+
+            void process_mcu_row();
+            void process_mcu_row_yuyv();
+            bool process_end_of_image();
+            void load_mcu(const void* src);
+            void clear();
+            void init();
+    };
+    
+} // namespace jpge
+
+#endif // JPEG_ENCODER
@@ -0,0 +1,643 @@
+// Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stddef.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "soc/efuse_reg.h"
+#include "esp_heap_caps.h"
+#include "esp_camera.h"
+#include "esp_camera_trace.h"
+#include "img_converters.h"
+#include "jpge.h"
+#include "yuv.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#else
+#include <pthread.h>
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define TAG ""
+#else
+#include "esp_log.h"
+static const char* TAG = "to_jpg";
+#endif
+
+static void *_malloc(size_t size)
+{
+    void * res = malloc(size);
+    if(res) {
+        return res;
+    }
+
+    // check if SPIRAM is enabled and is allocatable
+#if (CONFIG_SPIRAM_SUPPORT && (CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC))
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+    return NULL;
+}
+
+static IRAM_ATTR void convert_line_format(uint8_t * src, pixformat_t format, uint8_t * dst, size_t width, size_t in_channels, size_t line)
+{
+    int i=0, o=0, l=0;
+    if(format == PIXFORMAT_GRAYSCALE) {
+        memcpy(dst, src + line * width, width);
+    } else if(format == PIXFORMAT_RGB888) {
+        l = width * 3;
+        src += l * line;
+        for(i=0; i<l; i+=3) {
+            dst[o++] = src[i+2];
+            dst[o++] = src[i+1];
+            dst[o++] = src[i];
+        }
+    } else if(format == PIXFORMAT_RGB565) {
+        l = width * 2;
+        src += l * line;
+        for(i=0; i<l; i+=2) {
+            dst[o++] = src[i] & 0xF8;
+            dst[o++] = (src[i] & 0x07) << 5 | (src[i+1] & 0xE0) >> 3;
+            dst[o++] = (src[i+1] & 0x1F) << 3;
+        }
+    } else if(format == PIXFORMAT_YUV422) {
+        uint8_t y0, y1, u, v;
+        uint8_t r, g, b;
+        l = width * 2;
+        src += l * line;
+        for(i=0; i<l; i+=4) {
+            y0 = src[i];
+            u = src[i+1];
+            y1 = src[i+2];
+            v = src[i+3];
+
+            yuv2rgb(y0, u, v, &r, &g, &b);
+            dst[o++] = r;
+            dst[o++] = g;
+            dst[o++] = b;
+
+            yuv2rgb(y1, u, v, &r, &g, &b);
+            dst[o++] = r;
+            dst[o++] = g;
+            dst[o++] = b;
+        }
+    }
+}
+
+// Base quantization tables of the jpg_profile_t profiles, row major, for quality 50
+// ocr-text: a shallow ramp, so stroke edges (high frequencies) are not quantized away
+static const uint8_t s_ocr_luma_quant[64] = {
+     10,  12,  15,  18,  20,  22,  25,  28,
+     12,  15,  18,  20,  22,  25,  28,  30,
+     15,  18,  20,  22,  25,  28,  30,  32,
+     18,  20,  22,  25,  28,  30,  32,  35,
+     20,  22,  25,  28,  30,  32,  35,  38,
+     22,  25,  28,  30,  32,  35,  38,  40,
+     25,  28,  30,  32,  35,  38,  40,  42,
+     28,  30,  32,  35,  38,  40,  42,  45
+};
+
+// ocr-text: the block colour only
+static const uint8_t s_ocr_chroma_quant[64] = {
+     24, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255
+};
+
+// thumbnail: the standard luma steps, growing to 2.4x towards the highest frequencies
+static const uint8_t s_thumbnail_luma_quant[64] = {
+     16,  13,  14,  26,  43,  80, 112, 146,
+     14,  17,  22,  34,  52, 128, 144, 143,
+     20,  21,  29,  48,  88, 137, 179, 157,
+     22,  31,  44,  64, 122, 226, 224, 186,
+     32,  44,  81, 134, 177, 255, 255, 246,
+     48,  77, 132, 166, 227, 255, 255, 255,
+    108, 154, 203, 244, 255, 255, 255, 255,
+    173, 239, 255, 255, 255, 255, 255, 255
+};
+
+// thumbnail: twice the standard chroma steps
+static const uint8_t s_thumbnail_chroma_quant[64] = {
+     34,  36,  48,  94, 198, 198, 198, 198,
+     36,  42,  52, 132, 198, 198, 198, 198,
+     48,  52, 112, 198, 198, 198, 198, 198,
+     94, 132, 198, 198, 198, 198, 198, 198,
+    198, 198, 198, 198, 198, 198, 198, 198,
+    198, 198, 198, 198, 198, 198, 198, 198,
+    198, 198, 198, 198, 198, 198, 198, 198,
+    198, 198, 198, 198, 198, 198, 198, 198
+};
+
+// archive: a third of the standard luma steps, for chroma too
+static const uint8_t s_archive_quant[64] = {
+      5,   4,   3,   5,   8,  13,  17,  20,
+      4,   4,   5,   6,   9,  19,  20,  18,
+      5,   4,   5,   8,  13,  19,  23,  19,
+      5,   6,   7,  10,  17,  29,  27,  21,
+      6,   7,  12,  19,  23,  36,  34,  26,
+      8,  12,  18,  21,  27,  35,  38,  31,
+     16,  21,  26,  29,  34,  40,  40,  34,
+     24,  31,  32,  33,  37,  33,  34,  33
+};
+
+static const struct {
+    const char *name;
+    const uint8_t *luma_quant;      // NULL: the standard table
+    const uint8_t *chroma_quant;
+    jpge::subsampling_t subsampling;
+} s_profiles[JPG_PROFILE_MAX] = {
+    { "default", NULL, NULL, jpge::H2V2 },
+    { "ocr-text", s_ocr_luma_quant, s_ocr_chroma_quant, jpge::H2V2 },
+    { "thumbnail", s_thumbnail_luma_quant, s_thumbnail_chroma_quant, jpge::H2V2 },
+    { "archive", s_archive_quant, s_archive_quant, jpge::H1V1 },
+};
+
+jpg_profile_t jpg_profile_from_name(const char *name)
+{
+    if (!name) {
+        return JPG_PROFILE_MAX;
+    }
+    int i = 0;
+    while (i < JPG_PROFILE_MAX && strcmp(name, s_profiles[i].name)) {
+        i++;
+    }
+    return (jpg_profile_t)i;
+}
+
+// YUYV lines go to the encoder as they are, the other formats through convert_line_format
+static inline const uint8_t *source_line(uint8_t *src, pixformat_t format, const jpge::params &params, uint8_t *line, size_t width, size_t in_channels, size_t i)
+{
+    if (params.m_input == jpge::INPUT_YUYV) {
+        return src + i * width * 2;
+    }
+    convert_line_format(src, format, line, width, in_channels, i);
+    return line;
+}
+
+#if CONFIG_CAMERA_JPEG_HUFFMAN_STORE_KB
+#define JPG_HUFFMAN_STORE_SIZE  (CONFIG_CAMERA_JPEG_HUFFMAN_STORE_KB * 1024)
+#else
+#define JPG_HUFFMAN_STORE_SIZE  (256 * 1024)
+#endif
+
+// ends a trace span on every return path
+struct trace_span {
+    const char *name;
+    trace_span(const char *n) : name(n) { CAM_TRACE_BEGIN(name); }
+    ~trace_span() { CAM_TRACE_END(name); }
+};
+
+static int jpeg_params(pixformat_t format, uint16_t width, const jpg_encoder_config_t *config, jpge::params *comp_params)
+{
+    int num_channels = 3;
+    uint8_t quality = config->quality;
+    int profile = (unsigned)config->profile < JPG_PROFILE_MAX ? config->profile : JPG_PROFILE_DEFAULT;
+    jpge::subsampling_t subsampling = s_profiles[profile].subsampling;
+    jpge::input_t input = jpge::INPUT_CHANNELS;
+
+    if(format == PIXFORMAT_GRAYSCALE) {
+        num_channels = 1;
+        subsampling = jpge::Y_ONLY;
+    } else if(format == PIXFORMAT_YUV422 && !(width & 1)) {
+        // encoded from the YCbCr samples, not converted to RGB and back
+        num_channels = 2;
+        input = jpge::INPUT_YUYV;
+    }
+
+    if(!quality) {
+        quality = 1;
+    } else if(quality > 100) {
+        quality = 100;
+    }
+
+    *comp_params = jpge::params();
+    comp_params->m_subsampling = subsampling;
+    comp_params->m_quality = quality;
+    comp_params->m_input = input;
+    if (config->luma_quant || config->chroma_quant) {
+        comp_params->m_luma_quant = config->luma_quant;
+        comp_params->m_chroma_quant = config->chroma_quant ? config->chroma_quant : config->luma_quant;
+    } else {
+        comp_params->m_luma_quant = s_profiles[profile].luma_quant;
+        comp_params->m_chroma_quant = s_profiles[profile].chroma_quant;
+    }
+    comp_params->m_dct = config->dct == JPG_DCT_FAST ? jpge::DCT_AAN : jpge::DCT_LLM;
+    comp_params->m_optimize_huffman = config->optimize_huffman;
+    comp_params->m_huffman_store_size = JPG_HUFFMAN_STORE_SIZE;
+    return num_channels;
+}
+
+static bool convert_image_config(uint8_t *src, uint16_t width, uint16_t height, pixformat_t format, const jpg_encoder_config_t *config, jpge::output_stream *dst_stream)
+{
+    trace_span span("convert_image");
+    jpge::params comp_params;
+    int num_channels = jpeg_params(format, width, config, &comp_params);
+
+    jpge::jpeg_encoder dst_image;
+
+    if (!dst_image.init(dst_stream, width, height, num_channels, comp_params)) {
+        ESP_LOGE(TAG, "JPG encoder init failed");
+        return false;
+    }
+
+    uint8_t* line = NULL;
+    if (comp_params.m_input != jpge::INPUT_YUYV) {
+        line = (uint8_t*)_malloc(width * num_channels);
+        if(!line) {
+            ESP_LOGE(TAG, "Scan line malloc failed");
+            return false;
+        }
+    }
+
+    for (int i = 0; i < height; i++) {
+        if (!dst_image.process_scanline(source_line(src, format, comp_params, line, width, num_channels, i))) {
+            ESP_LOGE(TAG, "JPG process line %u failed", i);
+            free(line);
+            return false;
+        }
+    }
+    free(line);
+
+    if (!dst_image.process_scanline(NULL)) {
+        ESP_LOGE(TAG, "JPG image finish failed");
+        return false;
+    }
+    dst_image.deinit();
+    return true;
+}
+
+bool convert_image(uint8_t *src, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, jpge::output_stream *dst_stream)
+{
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(quality);
+    return convert_image_config(src, width, height, format, &config, dst_stream);
+}
+
+#define JPG_MAX_BANDS       8
+#define JPG_BAND_TASK_STACK 4096
+
+// Output of a band encoded on another task, kept until the bands before it are written
+class band_stream : public jpge::output_stream {
+protected:
+    uint8_t *buf;
+    size_t len, cap;
+
+public:
+    band_stream() : buf(NULL), len(0), cap(0) { }
+    virtual ~band_stream()
+    {
+        free(buf);
+    }
+    virtual bool put_buf(const void* data, int size)
+    {
+        if (!data) {
+            return true;
+        }
+        if (len + size > cap) {
+            size_t new_cap = cap ? cap * 2 : 8192;
+            while (new_cap < len + size) {
+                new_cap *= 2;
+            }
+            uint8_t *new_buf = (uint8_t *)_malloc(new_cap);
+            if (!new_buf) {
+                ESP_LOGE(TAG, "JPG band buffer malloc failed");
+                return false;
+            }
+            if (len) {
+                memcpy(new_buf, buf, len);
+            }
+            free(buf);
+            buf = new_buf;
+            cap = new_cap;
+        }
+        memcpy(buf + len, data, size);
+        len += size;
+        return true;
+    }
+    virtual size_t get_size() const
+    {
+        return len;
+    }
+    const uint8_t *data() const
+    {
+        return buf;
+    }
+};
+
+typedef struct {
+    uint8_t *src;
+    uint16_t width;
+    uint16_t height;
+    pixformat_t format;
+    int num_channels;
+    const jpge::params *params;
+    int first_mcu_row;
+    int mcu_rows;
+    jpge::output_stream *stream;
+    bool ok;
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t done;
+#else
+    pthread_t thread;
+#endif
+} band_job_t;
+
+static bool encode_band(band_job_t *job)
+{
+    trace_span span("jpg band");
+    jpge::jpeg_encoder dst_image;
+    if (!dst_image.init_band(job->stream, job->width, job->height, job->num_channels, *job->params, job->first_mcu_row, job->mcu_rows)) {
+        ESP_LOGE(TAG, "JPG band encoder init failed");
+        return false;
+    }
+
+    uint8_t* line = NULL;
+    if (job->params->m_input != jpge::INPUT_YUYV) {
+        line = (uint8_t*)_malloc(job->width * job->num_channels);
+        if(!line) {
+            ESP_LOGE(TAG, "Scan line malloc failed");
+            return false;
+        }
+    }
+
+    int mcu_height = job->params->mcu_height();
+    int end = (job->first_mcu_row + job->mcu_rows) * mcu_height;
+    if (end > job->height) {
+        end = job->height;
+    }
+    for (int i = job->first_mcu_row * mcu_height; i < end; i++) {
+        if (!dst_image.process_scanline(source_line(job->src, job->format, *job->params, line, job->width, job->num_channels, i))) {
+            free(line);
+            return false;
+        }
+    }
+    free(line);
+    return dst_image.process_scanline(NULL);
+}
+
+#ifdef ESP_PLATFORM
+static void band_task(void *arg)
+{
+    band_job_t *job = (band_job_t *)arg;
+    job->ok = encode_band(job);
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+// the n-th helper runs on the n-th core after the caller's, at the caller's priority
+static bool band_start(band_job_t *job, int n)
+{
+    job->done = xSemaphoreCreateBinary();
+    if (!job->done) {
+        return false;
+    }
+    BaseType_t core = (xPortGetCoreID() + n) % portNUM_PROCESSORS;
+    if (xTaskCreatePinnedToCore(band_task, "jpg_band", JPG_BAND_TASK_STACK, job, uxTaskPriorityGet(NULL), NULL, core) != pdPASS) {
+        vSemaphoreDelete(job->done);
+        job->done = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void band_wait(band_job_t *job)
+{
+    xSemaphoreTake(job->done, portMAX_DELAY);
+    vSemaphoreDelete(job->done);
+}
+#else
+static void *band_thread(void *arg)
+{
+    band_job_t *job = (band_job_t *)arg;
+    job->ok = encode_band(job);
+    return NULL;
+}
+
+static bool band_start(band_job_t *job, int n)
+{
+    return pthread_create(&job->thread, NULL, band_thread, job) == 0;
+}
+
+static void band_wait(band_job_t *job)
+{
+    pthread_join(job->thread, NULL);
+}
+#endif
+
+/*
+ * Encode the image in horizontal bands of whole MCU rows, the first on the calling task straight
+ * into dst_stream and each other one on a task of its own into a buffer. The restart interval is
+ * one band, so the bands join with an RSTn marker each into a single baseline JPEG.
+ */
+static bool convert_image_bands(uint8_t *src, uint16_t width, uint16_t height, pixformat_t format, const jpg_encoder_config_t *config, jpge::output_stream *dst_stream)
+{
+    jpge::params comp_params;
+    int num_channels = jpeg_params(format, width, config, &comp_params);
+    int bands = config->bands;
+    int mcu_rows = (height + comp_params.mcu_height() - 1) / comp_params.mcu_height();
+    int mcus_per_row = (width + comp_params.mcu_width() - 1) / comp_params.mcu_width();
+
+    if (bands > JPG_MAX_BANDS) {
+        bands = JPG_MAX_BANDS;
+    }
+    if (bands > mcu_rows) {
+        bands = mcu_rows;
+    }
+    // optimized Huffman tables are built from the whole image, before the first band can be written
+    if (bands <= 1 || comp_params.m_optimize_huffman) {
+        return convert_image_config(src, width, height, format, config, dst_stream);
+    }
+    trace_span span("convert_image bands");
+    int rows_per_band = (mcu_rows + bands - 1) / bands;
+    bands = (mcu_rows + rows_per_band - 1) / rows_per_band;
+    comp_params.m_restart_interval = rows_per_band * mcus_per_row;
+    if (comp_params.m_restart_interval > 0xFFFF) {
+        comp_params.m_restart_interval = mcus_per_row;
+    }
+    // every band uses the same quantization tables
+    jpge::quality_tables tables;
+    tables.init(comp_params.m_quality, comp_params.m_luma_quant, comp_params.m_chroma_quant);
+    comp_params.m_tables = &tables;
+
+    band_job_t jobs[JPG_MAX_BANDS];
+    band_stream streams[JPG_MAX_BANDS];
+    bool started[JPG_MAX_BANDS] = { false };
+    for (int i = 0; i < bands; i++) {
+        band_job_t *job = &jobs[i];
+        job->src = src;
+        job->width = width;
+        job->height = height;
+        job->format = format;
+        job->num_channels = num_channels;
+        job->params = &comp_params;
+        job->first_mcu_row = i * rows_per_band;
+        job->mcu_rows = rows_per_band;
+        job->stream = i ? static_cast<jpge::output_stream *>(&streams[i]) : dst_stream;
+        job->ok = false;
+        if (i) {
+            started[i] = band_start(job, i);
+        }
+    }
+
+    bool ok = encode_band(&jobs[0]);
+    for (int i = 1; i < bands; i++) {
+        if (started[i]) {
+            band_wait(&jobs[i]);
+        } else if (ok) {
+            // no task for this band: encode it here
+            jobs[i].ok = encode_band(&jobs[i]);
+        }
+        ok = ok && jobs[i].ok && dst_stream->put_buf(streams[i].data(), streams[i].get_size());
+    }
+    return ok && dst_stream->put_buf(NULL, 0);
+}
+
+class callback_stream : public jpge::output_stream {
+protected:
+    jpg_out_cb ocb;
+    void * oarg;
+    size_t index;
+
+public:
+    callback_stream(jpg_out_cb cb, void * arg) : ocb(cb), oarg(arg), index(0) { }
+    virtual ~callback_stream() { }
+    virtual bool put_buf(const void* data, int len)
+    {
+        size_t written = ocb(oarg, index, data, len);
+        index += written;
+        // a short write (e.g. the socket behind the callback closed) stops the encoder
+        return written == (size_t)len;
+    }
+    virtual size_t get_size() const
+    {
+        return index;
+    }
+};
+
+bool fmt2jpg_cb(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, jpg_out_cb cb, void * arg)
+{
+    callback_stream dst_stream(cb, arg);
+    return convert_image(src, width, height, format, quality, &dst_stream);
+}
+
+bool frame2jpg_cb(camera_fb_t * fb, uint8_t quality, jpg_out_cb cb, void * arg)
+{
+    return fmt2jpg_cb(fb->buf, fb->len, fb->width, fb->height, fb->format, quality, cb, arg);
+}
+
+bool frame2jpg_cb_ex(camera_fb_t * fb, const jpg_encoder_config_t *config, jpg_out_cb cb, void * arg)
+{
+    return fmt2jpg_cb_ex(fb->buf, fb->len, fb->width, fb->height, fb->format, config, cb, arg);
+}
+
+bool fmt2jpg_cb_parallel(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, int bands, jpg_out_cb cb, void * arg)
+{
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(quality);
+    config.bands = bands;
+    return fmt2jpg_cb_ex(src, src_len, width, height, format, &config, cb, arg);
+}
+
+bool fmt2jpg_cb_ex(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, const jpg_encoder_config_t *config, jpg_out_cb cb, void * arg)
+{
+    callback_stream dst_stream(cb, arg);
+    return convert_image_bands(src, width, height, format, config, &dst_stream);
+}
+
+
+
+class memory_stream : public jpge::output_stream {
+protected:
+    uint8_t *out_buf;
+    size_t max_len, index;
+
+public:
+    memory_stream(void *pBuf, uint buf_size) : out_buf(static_cast<uint8_t*>(pBuf)), max_len(buf_size), index(0) { }
+
+    virtual ~memory_stream() { }
+
+    virtual bool put_buf(const void* pBuf, int len)
+    {
+        if (!pBuf) {
+            //end of image
+            return true;
+        }
+        if ((size_t)len > (max_len - index)) {
+            //ESP_LOGW(TAG, "JPG output overflow: %d bytes (%d,%d,%d)", len - (max_len - index), len, index, max_len);
+            len = max_len - index;
+        }
+        if (len) {
+            memcpy(out_buf + index, pBuf, len);
+            index += len;
+        }
+        return true;
+    }
+
+    virtual size_t get_size() const
+    {
+        return index;
+    }
+};
+
+bool fmt2jpg_ex(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, const jpg_encoder_config_t *config, uint8_t ** out, size_t * out_len)
+{
+    //todo: allocate proper buffer for holding JPEG data
+    //this should be enough for CIF frame size
+    int jpg_buf_len = 128*1024;
+
+
+    uint8_t * jpg_buf = (uint8_t *)_malloc(jpg_buf_len);
+    if(jpg_buf == NULL) {
+        ESP_LOGE(TAG, "JPG buffer malloc failed");
+        return false;
+    }
+    memory_stream dst_stream(jpg_buf, jpg_buf_len);
+
+    if(!convert_image_bands(src, width, height, format, config, &dst_stream)) {
+        free(jpg_buf);
+        return false;
+    }
+
+    *out = jpg_buf;
+    *out_len = dst_stream.get_size();
+    return true;
+}
+
+bool fmt2jpg(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, uint8_t ** out, size_t * out_len)
+{
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(quality);
+    return fmt2jpg_ex(src, src_len, width, height, format, &config, out, out_len);
+}
+
+bool fmt2jpg_parallel(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, int bands, uint8_t ** out, size_t * out_len)
+{
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(quality);
+    config.bands = bands;
+    return fmt2jpg_ex(src, src_len, width, height, format, &config, out, out_len);
+}
+
+bool frame2jpg(camera_fb_t * fb, uint8_t quality, uint8_t ** out, size_t * out_len)
+{
+    return fmt2jpg(fb->buf, fb->len, fb->width, fb->height, fb->format, quality, out, out_len);
+}
+
+bool frame2jpg_ex(camera_fb_t * fb, const jpg_encoder_config_t *config, uint8_t ** out, size_t * out_len)
+{
+    return fmt2jpg_ex(fb->buf, fb->len, fb->width, fb->height, fb->format, config, out, out_len);
+}
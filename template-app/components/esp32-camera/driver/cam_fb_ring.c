@@ -0,0 +1,97 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "cam_fb_ring.h"
+
+esp_err_t cam_fb_ring_init(cam_fb_ring_t *ring, uint32_t size, bool latest)
+{
+    memset(ring, 0, sizeof(*ring));
+    uint32_t slots = 1;
+    while (slots < size) {
+        slots *= 2;
+    }
+    ring->slots = (camera_fb_t **)heap_caps_calloc(slots, sizeof(camera_fb_t *), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!ring->slots) {
+        return ESP_ERR_NO_MEM;
+    }
+    ring->size = size;
+    ring->mask = slots - 1;
+    ring->latest = latest;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->slot, NULL);
+    return ESP_OK;
+}
+
+void cam_fb_ring_deinit(cam_fb_ring_t *ring)
+{
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+bool cam_fb_ring_push(cam_fb_ring_t *ring, camera_fb_t *fb, camera_fb_t **evicted)
+{
+    *evicted = NULL;
+    if (ring->latest) {
+        *evicted = atomic_exchange(&ring->slot, fb);
+        ring->pushed++;
+        ring->high_water = 1;
+        if (*evicted) {
+            ring->evicted++;
+        }
+        return true;
+    }
+
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= ring->size) {
+        return false;
+    }
+    ring->slots[head & ring->mask] = fb;
+    // publish the slot before the consumer can see the new head
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    ring->pushed++;
+    if (head + 1 - tail > ring->high_water) {
+        ring->high_water = head + 1 - tail;
+    }
+    return true;
+}
+
+camera_fb_t *cam_fb_ring_pop(cam_fb_ring_t *ring)
+{
+    if (ring->latest) {
+        return atomic_exchange(&ring->slot, NULL);
+    }
+
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head == tail) {
+        return NULL;
+    }
+    camera_fb_t *fb = ring->slots[tail & ring->mask];
+    // the slot is read before the producer may reuse it
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return fb;
+}
+
+uint32_t cam_fb_ring_count(cam_fb_ring_t *ring)
+{
+    if (ring->latest) {
+        return atomic_load(&ring->slot) != NULL;
+    }
+    return atomic_load(&ring->head) - atomic_load(&ring->tail);
+}
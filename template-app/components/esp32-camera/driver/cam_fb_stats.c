@@ -0,0 +1,94 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include "cam_fb_stats.h"
+
+#define BUCKET_BASE 1024
+
+/* largest size that falls in bucket b */
+static size_t bucket_limit(int b)
+{
+    if (b == 0) {
+        return BUCKET_BASE;
+    }
+    int octave = (b - 1) / CAM_FB_STATS_STEPS;
+    int step = (b - 1) % CAM_FB_STATS_STEPS + 1;
+    return ((size_t)BUCKET_BASE << octave) * (CAM_FB_STATS_STEPS + step) / CAM_FB_STATS_STEPS;
+}
+
+static int bucket_of(size_t len)
+{
+    int b = 0;
+    size_t base = BUCKET_BASE;
+    // find the octave, then the step inside it
+    while (len > 2 * base && b + CAM_FB_STATS_STEPS < CAM_FB_STATS_BUCKETS - 1) {
+        base *= 2;
+        b += CAM_FB_STATS_STEPS;
+    }
+    while (b < CAM_FB_STATS_BUCKETS - 1 && len > bucket_limit(b)) {
+        b++;
+    }
+    return b;
+}
+
+static void stats_record(cam_fb_stats_t *stats, size_t len)
+{
+    if (stats->hist_total >= CAM_FB_STATS_WINDOW) {
+        stats->hist_total = 0;
+        for (int b = 0; b < CAM_FB_STATS_BUCKETS; b++) {
+            stats->hist[b] /= 2;
+            stats->hist_total += stats->hist[b];
+        }
+    }
+    stats->hist[bucket_of(len)]++;
+    stats->hist_total++;
+}
+
+void cam_fb_stats_init(cam_fb_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void cam_fb_stats_add(cam_fb_stats_t *stats, size_t len)
+{
+    stats_record(stats, len);
+    stats->frames++;
+    if (len > stats->max) {
+        stats->max = len;
+    }
+}
+
+void cam_fb_stats_overflow(cam_fb_stats_t *stats, size_t fb_size)
+{
+    // the frame was bigger than the buffer by an unknown amount; count it half again as big
+    stats_record(stats, fb_size + fb_size / 2);
+    stats->overflows++;
+}
+
+size_t cam_fb_stats_percentile(const cam_fb_stats_t *stats, uint32_t permille)
+{
+    if (!stats->hist_total) {
+        return 0;
+    }
+    uint32_t need = (stats->hist_total * permille + 999) / 1000;
+    uint32_t seen = 0;
+    for (int b = 0; b < CAM_FB_STATS_BUCKETS; b++) {
+        seen += stats->hist[b];
+        if (seen >= need && seen) {
+            return bucket_limit(b);
+        }
+    }
+    return bucket_limit(CAM_FB_STATS_BUCKETS - 1);
+}
@@ -18,6 +18,7 @@
 #include "esp_heap_caps.h"
 #include "ll_cam.h"
 #include "cam_hal.h"
+#include "esp_camera_trace.h"
 
 #if (ESP_IDF_VERSION_MAJOR == 3) && (ESP_IDF_VERSION_MINOR == 3)
 #include "rom/ets_sys.h"
@@ -41,35 +42,103 @@
 
 static const char *TAG = "cam_hal";
 static cam_obj_t *cam_obj = NULL;
+static portMUX_TYPE fb_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static portMUX_TYPE fb_ref_lock = portMUX_INITIALIZER_UNLOCKED;
 
-static const uint32_t JPEG_SOI_MARKER = 0xFFD8FF;  // written in little-endian for esp32
-static const uint16_t JPEG_EOI_MARKER = 0xD9FF;  // written in little-endian for esp32
+// frames measured before the adaptive JPEG frame buffers may shrink
+#define CAM_FB_ADAPT_MIN_FRAMES 16
 
 static int cam_verify_jpeg_soi(const uint8_t *inbuf, uint32_t length)
 {
-    for (uint32_t i = 0; i < length; i++) {
-        if (memcmp(&inbuf[i], &JPEG_SOI_MARKER, 3) == 0) {
-            //ESP_LOGW(TAG, "SOI: %d", (int) i);
-            return i;
-        }
+    int offset = cam_jpeg_find_soi(inbuf, length);
+    if (offset < 0) {
+        ESP_LOGW(TAG, "NO-SOI");
     }
-    ESP_LOGW(TAG, "NO-SOI");
-    return -1;
+    return offset;
 }
 
-static int cam_verify_jpeg_eoi(const uint8_t *inbuf, uint32_t length)
+// Follow the JPEG structure of the data that just landed in the frame buffer
+static void cam_track_jpeg(cam_frame_t *frame, size_t offset, size_t length)
 {
-    int offset = -1;
-    uint8_t *dptr = (uint8_t *)inbuf + length - 2;
-    while (dptr > inbuf) {
-        if (memcmp(dptr, &JPEG_EOI_MARKER, 2) == 0) {
-            offset = dptr - inbuf;
-            //ESP_LOGW(TAG, "EOI: %d", length - (offset + 2));
-            return offset;
+    if (cam_obj->jpeg_mode) {
+        cam_jpeg_scan_feed(&frame->jpeg_scan, &frame->fb.buf[offset], length);
+    }
+}
+
+static uint8_t *cam_alloc_fb(size_t size, uint32_t caps)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0)
+    // In IDF v4.2 and earlier, memory returned by heap_caps_aligned_alloc must be freed using heap_caps_aligned_free.
+    // And heap_caps_aligned_free is deprecated on v4.3.
+    return (uint8_t *)heap_caps_aligned_alloc(16, size, caps);
+#else
+    return (uint8_t *)heap_caps_malloc(size, caps);
+#endif
+}
+
+#if CONFIG_CAMERA_JPEG_FB_ADAPTIVE
+// Bring a free frame buffer to the current adaptive size before the DMA fills it
+static void cam_jpeg_fb_resize(cam_frame_t *frame)
+{
+    if (frame->buf_size == cam_obj->fb_size) {
+        return;
+    }
+    uint8_t *buf = cam_alloc_fb(cam_obj->fb_size, cam_obj->fb_caps);
+    uint8_t *old_buf = frame->fb.buf;
+    portENTER_CRITICAL(&fb_stats_lock);
+    if (buf) {
+        frame->fb.buf = buf;
+        frame->buf_size = cam_obj->fb_size;
+    } else {
+        // keep the old buffer, and capture into it at its size
+        cam_obj->fb_size = frame->buf_size;
+    }
+    portEXIT_CRITICAL(&fb_stats_lock);
+    if (buf) {
+        free(old_buf);
+    } else {
+        ESP_LOGW(TAG, "FB-RESIZE failed, largest free block: %u", (unsigned) heap_caps_get_largest_free_block(cam_obj->fb_caps));
+    }
+}
+#endif
+
+// Record the size of a finished JPEG frame and pick the adaptive frame buffer size
+static void cam_jpeg_fb_measure(const camera_fb_t *fb, bool overflow)
+{
+    portENTER_CRITICAL(&fb_stats_lock);
+    if (overflow) {
+        cam_fb_stats_overflow(&cam_obj->fb_stats, cam_obj->fb_size);
+    } else if (!fb->partial) {
+        cam_fb_stats_add(&cam_obj->fb_stats, fb->len);
+    }
+    portEXIT_CRITICAL(&fb_stats_lock);
+
+#if CONFIG_CAMERA_JPEG_FB_ADAPTIVE
+    if (!cam_obj->jpeg_fb_adaptive || (!overflow && cam_obj->fb_stats.hist_total < CAM_FB_ADAPT_MIN_FRAMES)) {
+        return;
+    }
+    // the copy needs room for a whole DMA half buffer after the data
+    size_t pixels_per_dma = (cam_obj->dma_half_buffer_size * cam_obj->fb_bytes_per_pixel) / (cam_obj->dma_bytes_per_item * cam_obj->in_bytes_per_pixel);
+    size_t size = cam_fb_stats_percentile(&cam_obj->fb_stats, 1000 - CONFIG_CAMERA_JPEG_FB_OVERFLOW_PERMILLE);
+    size = (size + pixels_per_dma + 1023) & ~1023;
+    if (size > (size_t)cam_obj->width * cam_obj->height) {
+        size = (size_t)cam_obj->width * cam_obj->height;
+    }
+    // grow at once, shrink only by more than an eighth
+    if (size > cam_obj->fb_size || size < cam_obj->fb_size - cam_obj->fb_size / 8) {
+        ESP_LOGD(TAG, "FB-ADAPT: %u -> %u", (unsigned) cam_obj->fb_size, (unsigned) size);
+        portENTER_CRITICAL(&fb_stats_lock);
+        cam_obj->fb_size = size;
+        cam_obj->fb_resizes++;
+        portEXIT_CRITICAL(&fb_stats_lock);
+        // free buffers now, the others when they are captured into next
+        for (int x = 0; x < cam_obj->frame_cnt; x++) {
+            if (cam_obj->frames[x].en) {
+                cam_jpeg_fb_resize(&cam_obj->frames[x]);
+            }
         }
-        dptr--;
     }
-    return -1;
+#endif
 }
 
 static bool cam_get_next_frame(int * frame_pos)
@@ -90,12 +159,19 @@ static bool cam_get_next_frame(int * frame_pos)
 static bool cam_start_frame(int * frame_pos)
 {
     if (cam_get_next_frame(frame_pos)) {
+#if CONFIG_CAMERA_JPEG_FB_ADAPTIVE
+        if (cam_obj->jpeg_fb_adaptive) {
+            cam_jpeg_fb_resize(&cam_obj->frames[*frame_pos]);
+        }
+#endif
         if(ll_cam_start(cam_obj, *frame_pos)){
             // Vsync the frame manually
             ll_cam_do_vsync(cam_obj);
+            cam_obj->frames[*frame_pos].start_us = cam_obj->vsync_us;
             uint64_t us = (uint64_t)esp_timer_get_time();
             cam_obj->frames[*frame_pos].fb.timestamp.tv_sec = us / 1000000UL;
             cam_obj->frames[*frame_pos].fb.timestamp.tv_usec = us % 1000000UL;
+            cam_jpeg_scan_init(&cam_obj->frames[*frame_pos].jpeg_scan);
             return true;
         }
     }
@@ -104,6 +180,9 @@ static bool cam_start_frame(int * frame_pos)
 
 void IRAM_ATTR ll_cam_send_event(cam_obj_t *cam, cam_event_t cam_event, BaseType_t * HPTaskAwoken)
 {
+    if (cam_event == CAM_VSYNC_EVENT) {
+        cam->vsync_us = esp_timer_get_time();
+    }
     if (xQueueSendFromISR(cam->event_queue, (void *)&cam_event, HPTaskAwoken) != pdTRUE) {
         ll_cam_stop(cam);
         cam->state = CAM_STATE_IDLE;
@@ -111,6 +190,36 @@ void IRAM_ATTR ll_cam_send_event(cam_obj_t *cam, cam_event_t cam_event, BaseType
     }
 }
 
+// Hand a finished frame to cam_take without taking a lock
+static void cam_send_frame(cam_frame_t *frame)
+{
+    camera_fb_t *evicted = NULL;
+    frame->ready_us = esp_timer_get_time();
+    frame->fb.capture_us = frame->end_us - frame->start_us;
+    frame->fb.deliver_us = frame->ready_us - frame->end_us;
+    if (!cam_fb_ring_push(&cam_obj->frame_ring, &frame->fb, &evicted)) {
+        frame->en = 1;
+        frame->refs = 0;
+        ESP_LOGE(TAG, "FBQ-SND");
+        return;
+    }
+    if (evicted) {
+        // GRAB_LATEST: the application did not take the previous frame in time
+        cam_give(evicted);
+    }
+    if (atomic_exchange(&cam_obj->frame_waiting, false)) {
+        xSemaphoreGive(cam_obj->frame_ready);
+    }
+}
+
+static size_t cam_memcpy(uint8_t *out, const uint8_t *in, size_t len)
+{
+    CAM_TRACE_BEGIN("ll_cam_memcpy");
+    len = ll_cam_memcpy(cam_obj, out, in, len);
+    CAM_TRACE_END("ll_cam_memcpy");
+    return len;
+}
+
 //Copy fram from DMA dma_buffer to fram dma_buffer
 static void cam_task(void *arg)
 {
@@ -124,6 +233,7 @@ static void cam_task(void *arg)
     while (1) {
         xQueueReceive(cam_obj->event_queue, (void *)&cam_event, portMAX_DELAY);
         DBG_PIN_SET(1);
+        CAM_TRACE_BEGIN(cam_event == CAM_VSYNC_EVENT ? "cam_task VSYNC" : "cam_task EOF");
         switch (cam_obj->state) {
 
             case CAM_STATE_IDLE: {
@@ -146,14 +256,22 @@ static void cam_task(void *arg)
                     if(!cam_obj->psram_mode){
                         if (cam_obj->fb_size < (frame_buffer_event->len + pixels_per_dma)) {
                             ESP_LOGW(TAG, "FB-OVF");
+                            CAM_TRACE_INSTANT("FB-OVF", frame_pos);
                             ll_cam_stop(cam_obj);
                             DBG_PIN_SET(0);
+                            CAM_TRACE_END(cam_event == CAM_VSYNC_EVENT ? "cam_task VSYNC" : "cam_task EOF");
                             continue;
                         }
-                        frame_buffer_event->len += ll_cam_memcpy(cam_obj,
+                        size_t offset = frame_buffer_event->len;
+                        frame_buffer_event->len += cam_memcpy(
                             &frame_buffer_event->buf[frame_buffer_event->len],
                             &cam_obj->dma_buffer[(cnt % cam_obj->dma_half_buffer_cnt) * cam_obj->dma_half_buffer_size],
                             cam_obj->dma_half_buffer_size);
+                        cam_track_jpeg(&cam_obj->frames[frame_pos], offset, frame_buffer_event->len - offset);
+                    } else {
+                        // the DMA wrote this chunk straight into the frame buffer
+                        frame_buffer_event->len += cam_obj->dma_half_buffer_size;
+                        cam_track_jpeg(&cam_obj->frames[frame_pos], cnt * cam_obj->dma_half_buffer_size, cam_obj->dma_half_buffer_size);
                     }
                     //Check for JPEG SOI in the first buffer. stop if not found
                     if (cam_obj->jpeg_mode && cnt == 0 && cam_verify_jpeg_soi(frame_buffer_event->buf, frame_buffer_event->len) != 0) {
@@ -165,54 +283,58 @@ static void cam_task(void *arg)
                 } else if (cam_event == CAM_VSYNC_EVENT) {
                     //DBG_PIN_SET(1);
                     ll_cam_stop(cam_obj);
+                    cam_obj->frames[frame_pos].end_us = cam_obj->vsync_us;
 
                     if (cnt || !cam_obj->jpeg_mode || cam_obj->psram_mode) {
+                        bool overflow = false;
                         if (cam_obj->jpeg_mode) {
                             if (!cam_obj->psram_mode) {
                                 if (cam_obj->fb_size < (frame_buffer_event->len + pixels_per_dma)) {
                                     ESP_LOGW(TAG, "FB-OVF");
+                                    CAM_TRACE_INSTANT("FB-OVF", frame_pos);
+                                    overflow = true;
                                     cnt--;
                                 } else {
-                                    frame_buffer_event->len += ll_cam_memcpy(cam_obj,
+                                    size_t offset = frame_buffer_event->len;
+                                    frame_buffer_event->len += cam_memcpy(
                                         &frame_buffer_event->buf[frame_buffer_event->len],
                                         &cam_obj->dma_buffer[(cnt % cam_obj->dma_half_buffer_cnt) * cam_obj->dma_half_buffer_size],
                                         cam_obj->dma_half_buffer_size);
+                                    cam_track_jpeg(&cam_obj->frames[frame_pos], offset, frame_buffer_event->len - offset);
                                 }
+                            } else {
+                                frame_buffer_event->len += cam_obj->dma_half_buffer_size;
+                                cam_track_jpeg(&cam_obj->frames[frame_pos], cnt * cam_obj->dma_half_buffer_size, cam_obj->dma_half_buffer_size);
                             }
                             cnt++;
                         }
 
+                        // from here the frame queue holds the only reference
                         cam_obj->frames[frame_pos].en = 0;
+                        cam_obj->frames[frame_pos].refs = 1;
 
-                        if (cam_obj->psram_mode) {
-                            if (cam_obj->jpeg_mode) {
-                                frame_buffer_event->len = cnt * cam_obj->dma_half_buffer_size;
-                            } else {
-                                frame_buffer_event->len = cam_obj->recv_size;
+                        if (cam_obj->psram_mode && !cam_obj->jpeg_mode) {
+                            frame_buffer_event->len = cam_obj->recv_size;
+                        }
+                        if (cam_obj->jpeg_mode) {
+                            // the EOI was found while the data arrived: drop whatever follows it
+                            int32_t jpeg_end = cam_jpeg_scan_end(&cam_obj->frames[frame_pos].jpeg_scan);
+                            frame_buffer_event->partial = jpeg_end < 0 || jpeg_end > frame_buffer_event->len;
+                            if (!frame_buffer_event->partial) {
+                                frame_buffer_event->len = jpeg_end;
                             }
-                        } else if (!cam_obj->jpeg_mode) {
+                            cam_jpeg_fb_measure(frame_buffer_event, overflow);
+                        } else if (!cam_obj->psram_mode) {
                             if (frame_buffer_event->len != cam_obj->fb_size) {
                                 cam_obj->frames[frame_pos].en = 1;
+                                cam_obj->frames[frame_pos].refs = 0;
                                 ESP_LOGE(TAG, "FB-SIZE: %u != %u", frame_buffer_event->len, (unsigned) cam_obj->fb_size);
                             }
                         }
                         //send frame
-                        if(!cam_obj->frames[frame_pos].en && xQueueSend(cam_obj->frame_buffer_queue, (void *)&frame_buffer_event, 0) != pdTRUE) {
-                            //pop frame buffer from the queue
-                            camera_fb_t * fb2 = NULL;
-                            if(xQueueReceive(cam_obj->frame_buffer_queue, &fb2, 0) == pdTRUE) {
-                                //push the new frame to the end of the queue
-                                if (xQueueSend(cam_obj->frame_buffer_queue, (void *)&frame_buffer_event, 0) != pdTRUE) {
-                                    cam_obj->frames[frame_pos].en = 1;
-                                    ESP_LOGE(TAG, "FBQ-SND");
-                                }
-                                //free the popped buffer
-                                cam_give(fb2);
-                            } else {
-                                //queue is full and we could not pop a frame from it
-                                cam_obj->frames[frame_pos].en = 1;
-                                ESP_LOGE(TAG, "FBQ-RCV");
-                            }
+                        if (!cam_obj->frames[frame_pos].en) {
+                            CAM_TRACE_INSTANT("frame", frame_buffer_event->len);
+                            cam_send_frame(&cam_obj->frames[frame_pos]);
                         }
                     }
 
@@ -226,6 +348,8 @@ static void cam_task(void *arg)
             }
             break;
         }
+        CAM_TRACE_COUNTER("cam_state", cam_obj->state);
+        CAM_TRACE_END(cam_event == CAM_VSYNC_EVENT ? "cam_task VSYNC" : "cam_task EOF");
         DBG_PIN_SET(0);
     }
 }
@@ -286,19 +410,15 @@ static esp_err_t cam_dma_config(const camera_config_t *config)
     } else {
         _caps |= MALLOC_CAP_SPIRAM;
     }
+    cam_obj->fb_caps = _caps;
     for (int x = 0; x < cam_obj->frame_cnt; x++) {
         cam_obj->frames[x].dma = NULL;
         cam_obj->frames[x].fb_offset = 0;
         cam_obj->frames[x].en = 0;
         ESP_LOGI(TAG, "Allocating %d Byte frame buffer in %s", alloc_size, _caps & MALLOC_CAP_SPIRAM ? "PSRAM" : "OnBoard RAM");
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0)
-        // In IDF v4.2 and earlier, memory returned by heap_caps_aligned_alloc must be freed using heap_caps_aligned_free.
-        // And heap_caps_aligned_free is deprecated on v4.3.
-        cam_obj->frames[x].fb.buf = (uint8_t *)heap_caps_aligned_alloc(16, alloc_size, _caps);
-#else
-        cam_obj->frames[x].fb.buf = (uint8_t *)heap_caps_malloc(alloc_size, _caps);
-#endif
+        cam_obj->frames[x].fb.buf = cam_alloc_fb(alloc_size, _caps);
         CAM_CHECK(cam_obj->frames[x].fb.buf != NULL, "frame buffer malloc failed", ESP_FAIL);
+        cam_obj->frames[x].buf_size = alloc_size;
         if (cam_obj->psram_mode) {
             //align PSRAM buffer. TODO: save the offset so proper address can be freed later
             cam_obj->frames[x].fb_offset = dma_align - ((uint32_t)cam_obj->frames[x].fb.buf & (dma_align - 1));
@@ -381,11 +501,15 @@ esp_err_t cam_config(const camera_config_t *config, framesize_t frame_size, uint
         cam_obj->recv_size = CONFIG_CAMERA_JPEG_MODE_FRAME_SIZE;
 #endif
         cam_obj->fb_size = cam_obj->recv_size;
+#if CONFIG_CAMERA_JPEG_FB_ADAPTIVE
+        cam_obj->jpeg_fb_adaptive = !cam_obj->psram_mode;
+#endif
     } else {
         cam_obj->recv_size = cam_obj->width * cam_obj->height * cam_obj->in_bytes_per_pixel;
         cam_obj->fb_size = cam_obj->width * cam_obj->height * cam_obj->fb_bytes_per_pixel;
     }
 
+    cam_fb_stats_init(&cam_obj->fb_stats);
     ret = cam_dma_config(config);
     CAM_CHECK_GOTO(ret == ESP_OK, "cam_dma_config failed", err);
 
@@ -396,12 +520,13 @@ esp_err_t cam_config(const camera_config_t *config, framesize_t frame_size, uint
     cam_obj->event_queue = xQueueCreate(queue_size, sizeof(cam_event_t));
     CAM_CHECK_GOTO(cam_obj->event_queue != NULL, "event_queue create failed", err);
 
-    size_t frame_buffer_queue_len = cam_obj->frame_cnt;
-    if (config->grab_mode == CAMERA_GRAB_LATEST && cam_obj->frame_cnt > 1) {
-        frame_buffer_queue_len = cam_obj->frame_cnt - 1;
-    }
-    cam_obj->frame_buffer_queue = xQueueCreate(frame_buffer_queue_len, sizeof(camera_fb_t*));
-    CAM_CHECK_GOTO(cam_obj->frame_buffer_queue != NULL, "frame_buffer_queue create failed", err);
+    ret = cam_fb_ring_init(&cam_obj->frame_ring, cam_obj->frame_cnt, config->grab_mode == CAMERA_GRAB_LATEST);
+    CAM_CHECK_GOTO(ret == ESP_OK, "frame_ring create failed", err);
+    cam_obj->frame_ready = xSemaphoreCreateBinary();
+    CAM_CHECK_GOTO(cam_obj->frame_ready != NULL, "frame_ready create failed", err);
+    atomic_init(&cam_obj->frame_waiting, false);
+    cam_obj->consumer_lock = xSemaphoreCreateMutex();
+    CAM_CHECK_GOTO(cam_obj->consumer_lock != NULL, "consumer_lock create failed", err);
 
     ret = ll_cam_init_isr(cam_obj);
     CAM_CHECK_GOTO(ret == ESP_OK, "cam intr alloc failed", err);
@@ -436,9 +561,13 @@ esp_err_t cam_deinit(void)
     if (cam_obj->event_queue) {
         vQueueDelete(cam_obj->event_queue);
     }
-    if (cam_obj->frame_buffer_queue) {
-        vQueueDelete(cam_obj->frame_buffer_queue);
+    if (cam_obj->frame_ready) {
+        vSemaphoreDelete(cam_obj->frame_ready);
     }
+    if (cam_obj->consumer_lock) {
+        vSemaphoreDelete(cam_obj->consumer_lock);
+    }
+    cam_fb_ring_deinit(&cam_obj->frame_ring);
 
     ll_cam_deinit(cam_obj);
 
@@ -474,11 +603,59 @@ void cam_start(void)
     ll_cam_vsync_intr_enable(cam_obj, true);
 }
 
+static cam_frame_t *cam_find_frame(const camera_fb_t *fb)
+{
+    for (int x = 0; x < cam_obj->frame_cnt; x++) {
+        if (&cam_obj->frames[x].fb == fb) {
+            return &cam_obj->frames[x];
+        }
+    }
+    return NULL;
+}
+
+// A frame leaves cam_take: note how long it waited and account all its stages
+static camera_fb_t *cam_fb_taken(camera_fb_t *fb)
+{
+    cam_frame_t *frame = cam_find_frame(fb);
+    fb->wait_us = esp_timer_get_time() - frame->ready_us;
+    esp_camera_latency_add(&cam_obj->latency[CAMERA_LATENCY_CAPTURE], fb->capture_us);
+    esp_camera_latency_add(&cam_obj->latency[CAMERA_LATENCY_DELIVER], fb->deliver_us);
+    esp_camera_latency_add(&cam_obj->latency[CAMERA_LATENCY_WAIT], fb->wait_us);
+    return fb;
+}
+
+// Wait up to timeout for cam_task to finish a frame. The ring and the
+// frame_ready wake-up serve one consumer, so concurrent esp_camera_fb_get
+// callers take turns on consumer_lock (a take and a give when uncontended).
+static camera_fb_t *cam_wait_frame(TickType_t timeout)
+{
+    TickType_t start = xTaskGetTickCount();
+    if (xSemaphoreTake(cam_obj->consumer_lock, timeout) != pdTRUE) {
+        return NULL;
+    }
+    camera_fb_t *fb = cam_fb_ring_pop(&cam_obj->frame_ring);
+    while (!fb) {
+        TickType_t ticks_spent = xTaskGetTickCount() - start;
+        if (timeout != portMAX_DELAY && ticks_spent >= timeout) {
+            break;
+        }
+        // ask cam_task for a wake-up, then look again: the frame may have come before the flag was seen
+        atomic_store(&cam_obj->frame_waiting, true);
+        fb = cam_fb_ring_pop(&cam_obj->frame_ring);
+        if (!fb) {
+            xSemaphoreTake(cam_obj->frame_ready, timeout == portMAX_DELAY ? portMAX_DELAY : timeout - ticks_spent);
+            fb = cam_fb_ring_pop(&cam_obj->frame_ring);
+        }
+        atomic_store(&cam_obj->frame_waiting, false);
+    }
+    xSemaphoreGive(cam_obj->consumer_lock);
+    return fb;
+}
+
 camera_fb_t *cam_take(TickType_t timeout)
 {
-    camera_fb_t *dma_buffer = NULL;
     TickType_t start = xTaskGetTickCount();
-    xQueueReceive(cam_obj->frame_buffer_queue, (void *)&dma_buffer, timeout);
+    camera_fb_t *dma_buffer = cam_wait_frame(timeout);
 #if CONFIG_IDF_TARGET_ESP32S3
     // Currently (22.01.2024) there is a bug in ESP-IDF v5.2, that causes
     // GDMA to fall into a strange state if it is running while WiFi STA is connecting.
@@ -486,17 +663,17 @@ camera_fb_t *cam_take(TickType_t timeout)
     // this case. It is possible to have some side effects too, though none come to mind
     if (!dma_buffer) {
         ll_cam_dma_reset(cam_obj);
-        xQueueReceive(cam_obj->frame_buffer_queue, (void *)&dma_buffer, timeout);
+        dma_buffer = cam_wait_frame(timeout);
     }
 #endif
     if (dma_buffer) {
         if(cam_obj->jpeg_mode){
-            // find the end marker for JPEG. Data after that can be discarded
-            int offset_e = cam_verify_jpeg_eoi(dma_buffer->buf, dma_buffer->len);
-            if (offset_e >= 0) {
-                // adjust buffer length
-                dma_buffer->len = offset_e + sizeof(JPEG_EOI_MARKER);
-                return dma_buffer;
+            // cam_task already cut the frame at its EOI
+#if CONFIG_CAMERA_JPEG_PARTIAL_FRAMES
+            return cam_fb_taken(dma_buffer);
+#else
+            if (!dma_buffer->partial) {
+                return cam_fb_taken(dma_buffer);
             } else {
                 ESP_LOGW(TAG, "NO-EOI");
                 cam_give(dma_buffer);
@@ -506,11 +683,12 @@ camera_fb_t *cam_take(TickType_t timeout)
                 }
                 return cam_take(timeout - ticks_spent);//recurse!!!!
             }
+#endif
         } else if(cam_obj->psram_mode && cam_obj->in_bytes_per_pixel != cam_obj->fb_bytes_per_pixel){
             //currently this is used only for YUV to GRAYSCALE
-            dma_buffer->len = ll_cam_memcpy(cam_obj, dma_buffer->buf, dma_buffer->buf, dma_buffer->len);
+            dma_buffer->len = cam_memcpy(dma_buffer->buf, dma_buffer->buf, dma_buffer->len);
         }
-        return dma_buffer;
+        return cam_fb_taken(dma_buffer);
     } else {
         ESP_LOGW(TAG, "Failed to get the frame on time!");
 // #if CONFIG_IDF_TARGET_ESP32S3
@@ -520,18 +698,85 @@ camera_fb_t *cam_take(TickType_t timeout)
     return NULL;
 }
 
+camera_fb_t *cam_ref(camera_fb_t *dma_buffer)
+{
+    cam_frame_t *frame = cam_find_frame(dma_buffer);
+    bool held = false;
+    if (frame) {
+        portENTER_CRITICAL(&fb_ref_lock);
+        held = frame->refs && frame->refs < UINT8_MAX;
+        if (held) {
+            frame->refs++;
+        }
+        portEXIT_CRITICAL(&fb_ref_lock);
+    }
+    if (!held) {
+        ESP_LOGE(TAG, "FB-REF: %p is not a frame buffer in use", dma_buffer);
+        return NULL;
+    }
+    return dma_buffer;
+}
+
 void cam_give(camera_fb_t *dma_buffer)
 {
-    for (int x = 0; x < cam_obj->frame_cnt; x++) {
-        if (&cam_obj->frames[x].fb == dma_buffer) {
-            cam_obj->frames[x].en = 1;
-            break;
+    cam_frame_t *frame = cam_find_frame(dma_buffer);
+    bool held = false;
+    if (frame) {
+        portENTER_CRITICAL(&fb_ref_lock);
+        held = frame->refs != 0;
+        if (held && --frame->refs == 0) {
+            // last reference: back to cam_task
+            frame->en = 1;
         }
+        portEXIT_CRITICAL(&fb_ref_lock);
+    }
+    if (!held) {
+        ESP_LOGE(TAG, "FB-RET: %p is not a frame buffer in use", dma_buffer);
     }
 }
 
 void cam_give_all(void) {
+    portENTER_CRITICAL(&fb_ref_lock);
     for (int x = 0; x < cam_obj->frame_cnt; x++) {
+        cam_obj->frames[x].refs = 0;
         cam_obj->frames[x].en = 1;
     }
+    portEXIT_CRITICAL(&fb_ref_lock);
+}
+
+esp_err_t cam_get_fb_stats(camera_fb_stats_t *stats)
+{
+    cam_fb_stats_t fb_stats;
+    size_t fb_total = 0;
+
+    portENTER_CRITICAL(&fb_stats_lock);
+    fb_stats = cam_obj->fb_stats;
+    stats->resizes = cam_obj->fb_resizes;
+    stats->fb_size = cam_obj->fb_size;
+    for (int x = 0; x < cam_obj->frame_cnt; x++) {
+        fb_total += cam_obj->frames[x].buf_size;
+    }
+    portEXIT_CRITICAL(&fb_stats_lock);
+
+    stats->frames = fb_stats.frames;
+    stats->overflows = fb_stats.overflows;
+    stats->p50 = cam_fb_stats_percentile(&fb_stats, 500);
+    stats->p90 = cam_fb_stats_percentile(&fb_stats, 900);
+    stats->p99 = cam_fb_stats_percentile(&fb_stats, 990);
+    stats->max = fb_stats.max;
+    stats->fb_total = fb_total;
+    return ESP_OK;
+}
+
+esp_err_t cam_get_latency_stats(camera_latency_stage_t stage, camera_latency_stats_t *stats)
+{
+    esp_camera_latency_get(&cam_obj->latency[stage], stats);
+    return ESP_OK;
+}
+
+void cam_reset_latency_stats(void)
+{
+    for (int stage = 0; stage < CAMERA_LATENCY_STAGE_MAX; stage++) {
+        esp_camera_latency_reset(&cam_obj->latency[stage]);
+    }
 }
@@ -0,0 +1,193 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include "cam_jpeg_scan.h"
+
+#define JPEG_MARKER_SOI 0xD8
+#define JPEG_MARKER_EOI 0xD9
+#define JPEG_MARKER_SOS 0xDA
+#define JPEG_MARKER_TEM 0x01
+
+enum {
+    SCAN_SOI,           // expecting FF D8
+    SCAN_SOI_CODE,
+    SCAN_MARKER,        // expecting the FF of the next header marker
+    SCAN_MARKER_CODE,
+    SCAN_LENGTH_HI,
+    SCAN_LENGTH_LO,
+    SCAN_SEGMENT,       // skipping the rest of a marker segment
+    SCAN_ENTROPY,       // compressed data after SOS
+    SCAN_ENTROPY_FF,
+    SCAN_LOOSE,         // not parseable as JPEG: remember the last EOI
+    SCAN_LOOSE_FF,
+    SCAN_DONE,
+};
+
+typedef uint32_t __attribute__((__may_alias__)) jpeg_word_t;
+
+/* true if any byte of w is 0xFF */
+static inline bool word_has_ff(uint32_t w)
+{
+    return ((~w - 0x01010101u) & w & 0x80808080u) != 0;
+}
+
+static const uint8_t *find_ff(const uint8_t *p, const uint8_t *end)
+{
+    while (p < end && ((uintptr_t)p & 3)) {
+        if (*p == 0xFF) {
+            return p;
+        }
+        p++;
+    }
+    while (end - p >= 4 && !word_has_ff(*(const jpeg_word_t *)p)) {
+        p += 4;
+    }
+    while (p < end && *p != 0xFF) {
+        p++;
+    }
+    return p;
+}
+
+static inline bool marker_has_length(uint8_t code)
+{
+    return !(code == JPEG_MARKER_SOI || code == JPEG_MARKER_TEM || (code >= 0xD0 && code <= 0xD7));
+}
+
+void cam_jpeg_scan_init(cam_jpeg_scan_t *scan)
+{
+    scan->offset = 0;
+    scan->end = -1;
+    scan->remaining = 0;
+    scan->marker = 0;
+    scan->state = SCAN_SOI;
+}
+
+void cam_jpeg_scan_feed(cam_jpeg_scan_t *scan, const uint8_t *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    const uint8_t *end = buf + len;
+    uint8_t c;
+
+    while (p < end && scan->state != SCAN_DONE) {
+        switch (scan->state) {
+        case SCAN_SOI:
+            scan->state = *p++ == 0xFF ? SCAN_SOI_CODE : SCAN_LOOSE;
+            break;
+        case SCAN_SOI_CODE:
+            scan->state = *p++ == JPEG_MARKER_SOI ? SCAN_MARKER : SCAN_LOOSE;
+            break;
+        case SCAN_MARKER:
+            scan->state = *p++ == 0xFF ? SCAN_MARKER_CODE : SCAN_LOOSE;
+            break;
+        case SCAN_MARKER_CODE:
+            c = *p++;
+            if (c == 0xFF) {
+                // fill byte
+            } else if (c == JPEG_MARKER_EOI) {
+                scan->end = scan->offset + (p - buf);
+                scan->state = SCAN_DONE;
+            } else if (c == 0x00) {
+                scan->state = SCAN_LOOSE;
+            } else if (marker_has_length(c)) {
+                scan->marker = c;
+                scan->state = SCAN_LENGTH_HI;
+            } else {
+                scan->state = SCAN_MARKER;
+            }
+            break;
+        case SCAN_LENGTH_HI:
+            scan->remaining = *p++ << 8;
+            scan->state = SCAN_LENGTH_LO;
+            break;
+        case SCAN_LENGTH_LO:
+            scan->remaining |= *p++;
+            if (scan->remaining < 2) {
+                scan->state = SCAN_LOOSE;
+                break;
+            }
+            scan->remaining -= 2;
+            scan->state = SCAN_SEGMENT;
+            break;
+        case SCAN_SEGMENT: {
+            size_t n = end - p;
+            if (n > scan->remaining) {
+                n = scan->remaining;
+            }
+            p += n;
+            scan->remaining -= n;
+            if (scan->remaining == 0) {
+                scan->state = scan->marker == JPEG_MARKER_SOS ? SCAN_ENTROPY : SCAN_MARKER;
+            }
+            break;
+        }
+        case SCAN_ENTROPY:
+            p = find_ff(p, end);
+            if (p < end) {
+                p++;
+                scan->state = SCAN_ENTROPY_FF;
+            }
+            break;
+        case SCAN_ENTROPY_FF:
+            c = *p++;
+            if (c == 0x00 || (c >= 0xD0 && c <= 0xD7)) {
+                // stuffed 0xFF or restart marker
+                scan->state = SCAN_ENTROPY;
+            } else if (c == 0xFF) {
+                // fill byte
+            } else if (c == JPEG_MARKER_EOI) {
+                scan->end = scan->offset + (p - buf);
+                scan->state = SCAN_DONE;
+            } else if (marker_has_length(c)) {
+                // tables or the next scan of a progressive JPEG
+                scan->marker = c;
+                scan->state = SCAN_LENGTH_HI;
+            } else {
+                scan->state = SCAN_LOOSE;
+            }
+            break;
+        case SCAN_LOOSE:
+            p = find_ff(p, end);
+            if (p < end) {
+                p++;
+                scan->state = SCAN_LOOSE_FF;
+            }
+            break;
+        case SCAN_LOOSE_FF:
+            c = *p++;
+            if (c == JPEG_MARKER_EOI) {
+                scan->end = scan->offset + (p - buf);
+            }
+            scan->state = c == 0xFF ? SCAN_LOOSE_FF : SCAN_LOOSE;
+            break;
+        }
+    }
+    scan->offset += len;
+}
+
+int cam_jpeg_find_soi(const uint8_t *buf, size_t len)
+{
+    const uint8_t *end = buf + len;
+    const uint8_t *p = buf;
+    while (1) {
+        p = find_ff(p, end);
+        if (end - p < 3) {
+            return -1;
+        }
+        if (p[1] == JPEG_MARKER_SOI && p[2] == 0xFF) {
+            return p - buf;
+        }
+        p++;
+    }
+}
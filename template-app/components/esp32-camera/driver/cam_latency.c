@@ -0,0 +1,98 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include "esp_camera.h"
+
+/*
+ * Buckets 0-7 hold 0-7 us exactly. From 8 us on, every power of two is split
+ * into 8 buckets by the 3 bits below the leading one. The counters are only
+ * touched with 32-bit atomics, which need no lock on the ESP32 targets.
+ */
+#define STEPS_LOG2  3
+#define STEPS       (1 << STEPS_LOG2)
+
+static int bucket_of(uint32_t us)
+{
+    if (us < STEPS) {
+        return us;
+    }
+    int msb = 31 - __builtin_clz(us);
+    int shift = msb - STEPS_LOG2;
+    int b = STEPS + shift * STEPS + ((us >> shift) & (STEPS - 1));
+    return b < CAMERA_LATENCY_BUCKETS ? b : CAMERA_LATENCY_BUCKETS - 1;
+}
+
+/* largest latency that falls in bucket b */
+static uint32_t bucket_limit(int b)
+{
+    if (b < STEPS) {
+        return b;
+    }
+    int shift = (b - STEPS) / STEPS;
+    uint32_t step = (b - STEPS) % STEPS;
+    return ((STEPS + step + 1) << shift) - 1;
+}
+
+void esp_camera_latency_add(camera_latency_hist_t *hist, uint32_t us)
+{
+    __atomic_fetch_add(&hist->bucket[bucket_of(us)], 1, __ATOMIC_RELAXED);
+    uint32_t max = __atomic_load_n(&hist->max_us, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&hist->max_us, &max, us, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static uint32_t percentile(const uint32_t *bucket, uint32_t total, uint32_t max, uint32_t permille)
+{
+    uint32_t need = ((uint64_t)total * permille + 999) / 1000;
+    uint32_t seen = 0;
+    for (int b = 0; b < CAMERA_LATENCY_BUCKETS; b++) {
+        seen += bucket[b];
+        if (seen >= need && seen) {
+            uint32_t limit = bucket_limit(b);
+            return limit < max ? limit : max;
+        }
+    }
+    return max;
+}
+
+void esp_camera_latency_get(const camera_latency_hist_t *hist, camera_latency_stats_t *stats)
+{
+    uint32_t bucket[CAMERA_LATENCY_BUCKETS];
+    uint32_t total = 0;
+    // a snapshot: samples added meanwhile may or may not be counted
+    for (int b = 0; b < CAMERA_LATENCY_BUCKETS; b++) {
+        bucket[b] = __atomic_load_n(&hist->bucket[b], __ATOMIC_RELAXED);
+        total += bucket[b];
+    }
+    uint32_t max = __atomic_load_n(&hist->max_us, __ATOMIC_RELAXED);
+
+    memset(stats, 0, sizeof(*stats));
+    if (!total) {
+        return;
+    }
+    stats->count = total;
+    stats->p50_us = percentile(bucket, total, max, 500);
+    stats->p90_us = percentile(bucket, total, max, 900);
+    stats->p99_us = percentile(bucket, total, max, 990);
+    stats->max_us = max;
+}
+
+void esp_camera_latency_reset(camera_latency_hist_t *hist)
+{
+    for (int b = 0; b < CAMERA_LATENCY_BUCKETS; b++) {
+        __atomic_store_n(&hist->bucket[b], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&hist->max_us, 0, __ATOMIC_RELAXED);
+}
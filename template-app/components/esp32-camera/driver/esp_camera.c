@@ -387,6 +387,14 @@ void esp_camera_fb_return(camera_fb_t *fb)
     cam_give(fb);
 }
 
+camera_fb_t *esp_camera_fb_ref(camera_fb_t *fb)
+{
+    if (s_state == NULL || fb == NULL) {
+        return NULL;
+    }
+    return cam_ref(fb);
+}
+
 sensor_t *esp_camera_sensor_get()
 {
     if (s_state == NULL) {
@@ -490,3 +498,33 @@ void esp_camera_return_all(void) {
     cam_give_all();
 }
 
+
+esp_err_t esp_camera_get_fb_stats(camera_fb_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_state == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return cam_get_fb_stats(stats);
+}
+
+esp_err_t esp_camera_get_latency_stats(camera_latency_stage_t stage, camera_latency_stats_t *stats)
+{
+    if (stats == NULL || stage < 0 || stage >= CAMERA_LATENCY_STAGE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_state == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return cam_get_latency_stats(stage, stats);
+}
+
+void esp_camera_reset_latency_stats(void)
+{
+    if (s_state == NULL) {
+        return;
+    }
+    cam_reset_latency_stats();
+}
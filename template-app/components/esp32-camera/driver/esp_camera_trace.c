@@ -0,0 +1,241 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ESP_PLATFORM
+#define _GNU_SOURCE // pthread_getname_np
+#endif
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_camera_trace.h"
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#define TRACE_TASK_NAME_LEN configMAX_TASK_NAME_LEN
+#else
+#include <pthread.h>
+#define TRACE_TASK_NAME_LEN 16
+#endif
+
+#if CONFIG_CAMERA_TRACE
+
+#define TRACE_MAX_TASKS 16
+#define TRACE_TASK_ISR  0               // events recorded from an interrupt
+#define TRACE_TASK_MORE TRACE_MAX_TASKS // the tasks that found the table full
+
+typedef struct {
+    const char *name;
+    uint32_t ts;        // esp_timer_get_time(), low 32 bits
+    int32_t arg;
+    char ph;
+    uint8_t task;       // index into s_task_names
+} trace_event_t;
+
+static trace_event_t *s_events; // CONFIG_CAMERA_TRACE_EVENTS, allocated by the first esp_camera_trace_start()
+static uint32_t s_next;         // events recorded since the start, the ring holds the last ones
+static volatile bool s_enabled;
+
+// task names by id, a copy: the task may be deleted before the export. Tasks
+// with the same name share an id, so short-lived band tasks do not fill it up.
+static char s_task_names[TRACE_MAX_TASKS + 1][TRACE_TASK_NAME_LEN] = {
+    [TRACE_TASK_ISR] = "ISR",
+    [TRACE_TASK_MORE] = "other",
+};
+static int s_task_count = TRACE_TASK_ISR + 1;
+static __thread uint8_t s_task_id;      // id + 1 of the calling task, 0 until its first event
+#ifdef ESP_PLATFORM
+static portMUX_TYPE s_task_lock = portMUX_INITIALIZER_UNLOCKED;
+#define TRACE_TASK_LOCK()   taskENTER_CRITICAL(&s_task_lock)
+#define TRACE_TASK_UNLOCK() taskEXIT_CRITICAL(&s_task_lock)
+#else
+static pthread_mutex_t s_task_lock = PTHREAD_MUTEX_INITIALIZER;
+#define TRACE_TASK_LOCK()   pthread_mutex_lock(&s_task_lock)
+#define TRACE_TASK_UNLOCK() pthread_mutex_unlock(&s_task_lock)
+#endif
+
+// the calling task's name, looked up in the table once per task
+static uint8_t trace_task_register(void)
+{
+    char name[TRACE_TASK_NAME_LEN];
+#ifdef ESP_PLATFORM
+    strncpy(name, pcTaskGetName(NULL), TRACE_TASK_NAME_LEN - 1);
+    name[TRACE_TASK_NAME_LEN - 1] = 0;
+#else
+    if (pthread_getname_np(pthread_self(), name, TRACE_TASK_NAME_LEN)) {
+        strcpy(name, "main");
+    }
+#endif
+    int id = TRACE_TASK_MORE;
+    TRACE_TASK_LOCK();
+    for (int t = TRACE_TASK_ISR + 1; t < s_task_count; t++) {
+        if (!strcmp(s_task_names[t], name)) {
+            id = t;
+            break;
+        }
+    }
+    if (id == TRACE_TASK_MORE && s_task_count < TRACE_MAX_TASKS) {
+        id = s_task_count++;
+        memcpy(s_task_names[id], name, TRACE_TASK_NAME_LEN);
+    }
+    TRACE_TASK_UNLOCK();
+    s_task_id = id + 1;
+    return id;
+}
+
+static inline uint8_t trace_task(void)
+{
+#ifdef ESP_PLATFORM
+    if (xPortInIsrContext()) {
+        return TRACE_TASK_ISR;
+    }
+#endif
+    return s_task_id ? s_task_id - 1 : trace_task_register();
+}
+
+void esp_camera_trace_event(const char *name, char ph, int32_t arg)
+{
+    if (!s_enabled) {
+        return;
+    }
+    // every caller gets its own slot, no lock needed
+    uint32_t n = __atomic_fetch_add(&s_next, 1, __ATOMIC_RELAXED);
+    trace_event_t *e = &s_events[n % CONFIG_CAMERA_TRACE_EVENTS];
+    e->ts = (uint32_t)esp_timer_get_time();
+    e->name = name;
+    e->task = trace_task();
+    e->arg = arg;
+    e->ph = ph;
+}
+
+esp_err_t esp_camera_trace_start(void)
+{
+    s_enabled = false;
+    if (!s_events) {
+        // kept until reboot: the export reads it after the stop
+        size_t size = CONFIG_CAMERA_TRACE_EVENTS * sizeof(trace_event_t);
+        s_events = (trace_event_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!s_events) {
+            s_events = (trace_event_t *)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (!s_events) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    __atomic_store_n(&s_next, 0, __ATOMIC_RELAXED);
+    s_enabled = true;
+    return ESP_OK;
+}
+
+void esp_camera_trace_stop(void)
+{
+    s_enabled = false;
+}
+
+typedef struct {
+    esp_camera_trace_write_cb write;
+    void *arg;
+    bool failed;
+    int depth[TRACE_MAX_TASKS + 1];
+    bool seen[TRACE_MAX_TASKS + 1];
+} trace_export_t;
+
+static void export_printf(trace_export_t *x, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void export_printf(trace_export_t *x, const char *fmt, ...)
+{
+    char line[192];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (len >= (int)sizeof(line)) {
+        len = sizeof(line) - 1;
+    }
+    if (!x->failed && len > 0 && !x->write(x->arg, line, len)) {
+        x->failed = true;
+    }
+}
+
+esp_err_t esp_camera_trace_export(esp_camera_trace_write_cb write, void *arg)
+{
+    esp_camera_trace_stop();
+    trace_export_t x = {
+        .write = write,
+        .arg = arg,
+    };
+    uint32_t next = __atomic_load_n(&s_next, __ATOMIC_RELAXED);
+    uint32_t count = next < CONFIG_CAMERA_TRACE_EVENTS ? next : CONFIG_CAMERA_TRACE_EVENTS;
+    uint32_t t0 = count ? s_events[(next - count) % CONFIG_CAMERA_TRACE_EVENTS].ts : 0;
+    const char *sep = "";
+
+    export_printf(&x, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (uint32_t n = next - count; n != next && !x.failed; n++) {
+        const trace_event_t *e = &s_events[n % CONFIG_CAMERA_TRACE_EVENTS];
+        int tid = e->task;
+        x.seen[tid] = true;
+        uint32_t ts = e->ts - t0;   // also right across one wrap of the 32-bit clock
+        if (e->ph == 'B') {
+            x.depth[tid]++;
+        } else if (e->ph == 'E') {
+            // its begin was overwritten
+            if (!x.depth[tid]) {
+                continue;
+            }
+            x.depth[tid]--;
+        }
+        export_printf(&x, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%u,\"pid\":1,\"tid\":%d", sep, e->name, e->ph, (unsigned)ts, tid);
+        if (e->ph == 'i') {
+            export_printf(&x, ",\"s\":\"t\",\"args\":{\"v\":%d}}", (int)e->arg);
+        } else if (e->ph == 'C') {
+            export_printf(&x, ",\"args\":{\"value\":%d}}", (int)e->arg);
+        } else {
+            export_printf(&x, "}");
+        }
+        sep = ",\n";
+    }
+    // names of the tasks in the exported events; the table only grows, no lock needed to read them
+    for (int t = 0; t <= TRACE_MAX_TASKS; t++) {
+        if (!x.seen[t]) {
+            continue;
+        }
+        export_printf(&x, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", sep, t, s_task_names[t]);
+        sep = ",\n";
+    }
+    export_printf(&x, "\n]}\n");
+    return x.failed ? ESP_FAIL : ESP_OK;
+}
+
+#else
+
+void esp_camera_trace_event(const char *name, char ph, int32_t arg)
+{
+}
+
+esp_err_t esp_camera_trace_start(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void esp_camera_trace_stop(void)
+{
+}
+
+esp_err_t esp_camera_trace_export(esp_camera_trace_write_cb write, void *arg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_CAMERA_TRACE
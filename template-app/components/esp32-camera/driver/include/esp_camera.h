@@ -167,8 +167,64 @@ typedef struct {
     size_t height;              /*!< Height of the buffer in pixels */
     pixformat_t format;         /*!< Format of the pixel data */
     struct timeval timestamp;   /*!< Timestamp since boot of the first DMA buffer of the frame */
+    bool partial;               /*!< JPEG frame that ended without an EOI marker, len is what was received. Only returned with CONFIG_CAMERA_JPEG_PARTIAL_FRAMES */
+    uint32_t capture_us;        /*!< VSYNC at the start of the frame to VSYNC at its end */
+    uint32_t deliver_us;        /*!< VSYNC at the end of the frame until the driver handed it over */
+    uint32_t wait_us;           /*!< Handed over until esp_camera_fb_get returned it */
 } camera_fb_t;
 
+/**
+ * @brief JPEG frame size statistics
+ *
+ * The percentiles follow the last few hundred frames.
+ */
+typedef struct {
+    uint32_t frames;            /*!< JPEG frames measured since init */
+    uint32_t overflows;         /*!< Frames that did not fit their frame buffer (FB-OVF) */
+    uint32_t resizes;           /*!< Frame buffer size changes (CONFIG_CAMERA_JPEG_FB_ADAPTIVE) */
+    size_t p50;                 /*!< Median frame size in bytes */
+    size_t p90;                 /*!< 90th percentile of the frame size */
+    size_t p99;                 /*!< 99th percentile of the frame size */
+    size_t max;                 /*!< Largest frame since init */
+    size_t fb_size;             /*!< Current frame buffer size */
+    size_t fb_total;            /*!< Memory held by all frame buffers */
+} camera_fb_stats_t;
+
+/**
+ * @brief Stages of a frame's way from the sensor to esp_camera_fb_get
+ */
+typedef enum {
+    CAMERA_LATENCY_CAPTURE,     /*!< camera_fb_t.capture_us */
+    CAMERA_LATENCY_DELIVER,     /*!< camera_fb_t.deliver_us */
+    CAMERA_LATENCY_WAIT,        /*!< camera_fb_t.wait_us */
+    CAMERA_LATENCY_STAGE_MAX,
+} camera_latency_stage_t;
+
+#define CAMERA_LATENCY_BUCKETS  184
+
+/**
+ * @brief Latency histogram
+ *
+ * Eight buckets per octave from 1 us to 30 s, so a percentile is at most
+ * 1/8 above the true value. Adding a sample takes no lock and may be done
+ * from one task while another reads the histogram.
+ */
+typedef struct {
+    uint32_t bucket[CAMERA_LATENCY_BUCKETS];
+    uint32_t max_us;
+} camera_latency_hist_t;
+
+/**
+ * @brief Latency percentiles read from a camera_latency_hist_t
+ */
+typedef struct {
+    uint32_t count;             /*!< Samples in the histogram */
+    uint32_t p50_us;            /*!< Median */
+    uint32_t p90_us;            /*!< 90th percentile */
+    uint32_t p99_us;            /*!< 99th percentile */
+    uint32_t max_us;            /*!< Largest sample */
+} camera_latency_stats_t;
+
 #define ESP_ERR_CAMERA_BASE 0x20000
 #define ESP_ERR_CAMERA_NOT_DETECTED             (ESP_ERR_CAMERA_BASE + 1)
 #define ESP_ERR_CAMERA_FAILED_TO_SET_FRAME_SIZE (ESP_ERR_CAMERA_BASE + 2)
@@ -205,6 +261,12 @@ esp_err_t esp_camera_deinit(void);
 /**
  * @brief Obtain pointer to a frame buffer.
  *
+ * Frames are handed over through a single-consumer ring. Calls from several
+ * tasks at once are safe but take turns: each frame goes to one caller, and
+ * a caller waits, within the same 4 second timeout, while another one is
+ * waiting for a frame. Have one task take the frames and pass them on
+ * (esp_camera_fb_ref shares one between consumers).
+ *
  * @return pointer to the frame buffer
  */
 camera_fb_t* esp_camera_fb_get(void);
@@ -216,6 +278,20 @@ camera_fb_t* esp_camera_fb_get(void);
  */
 void esp_camera_fb_return(camera_fb_t * fb);
 
+/**
+ * @brief Take an extra reference to a frame buffer obtained from esp_camera_fb_get.
+ *
+ * Lets several consumers read the same frame without copying it. Every
+ * reference is released with esp_camera_fb_return; the buffer goes back to
+ * the driver when the last one is released. Do not modify the frame while
+ * it is shared.
+ *
+ * @param fb    Pointer to a frame buffer that is currently held
+ *
+ * @return fb, or NULL if fb is not held or has too many references
+ */
+camera_fb_t* esp_camera_fb_ref(camera_fb_t * fb);
+
 /**
  * @brief Get a pointer to the image sensor control structure
  *
@@ -242,6 +318,62 @@ esp_err_t esp_camera_load_from_nvs(const char *key);
  */
 void esp_camera_return_all(void);
 
+/**
+ * @brief Get the JPEG frame size statistics
+ *
+ * @param stats  Filled in with the current statistics
+ *
+ * @return
+ *     - ESP_OK on success
+ *     - ESP_ERR_INVALID_ARG if stats is NULL
+ *     - ESP_ERR_INVALID_STATE if the camera is not initialized
+ */
+esp_err_t esp_camera_get_fb_stats(camera_fb_stats_t *stats);
+
+/**
+ * @brief Get the latency of one stage over the frames returned by esp_camera_fb_get
+ *
+ * @param stage  Stage to read
+ * @param stats  Filled in with the percentiles
+ *
+ * @return
+ *     - ESP_OK on success
+ *     - ESP_ERR_INVALID_ARG if stage is out of range or stats is NULL
+ *     - ESP_ERR_INVALID_STATE if the camera is not initialized
+ */
+esp_err_t esp_camera_get_latency_stats(camera_latency_stage_t stage, camera_latency_stats_t *stats);
+
+/**
+ * @brief Clear the driver's latency histograms
+ */
+void esp_camera_reset_latency_stats(void);
+
+/**
+ * @brief Add a sample to a latency histogram
+ *
+ * The application can keep its own histograms, e.g. for upload time, and
+ * report them alongside the driver's stages.
+ *
+ * @param hist  Histogram, zero-initialized or cleared with esp_camera_latency_reset
+ * @param us    Latency in microseconds
+ */
+void esp_camera_latency_add(camera_latency_hist_t *hist, uint32_t us);
+
+/**
+ * @brief Read percentiles from a latency histogram
+ *
+ * @param hist   Histogram
+ * @param stats  Filled in with the percentiles, all zero if there are no samples
+ */
+void esp_camera_latency_get(const camera_latency_hist_t *hist, camera_latency_stats_t *stats);
+
+/**
+ * @brief Clear a latency histogram. Samples added at the same time may be lost.
+ *
+ * @param hist  Histogram
+ */
+void esp_camera_latency_reset(camera_latency_hist_t *hist);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,106 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * Trace ring buffer for profiling the capture, conversion and upload path.
+ *
+ * With CONFIG_CAMERA_TRACE the CAM_TRACE_* macros record a timestamped event
+ * into a ring of CONFIG_CAMERA_TRACE_EVENTS entries, overwriting the oldest;
+ * without it they compile to nothing. Recording is off until
+ * esp_camera_trace_start(), which allocates the ring on its first call. Each
+ * event then costs an atomic increment, an esp_timer_get_time() call, an
+ * interrupt-context check and a few stores. The task is kept as a small id:
+ * its name is looked up and copied once, on the first event the task records.
+ * Names must be string literals (only the pointer is kept).
+ *
+ * esp_camera_trace_export() writes the events as Chrome trace JSON, which
+ * chrome://tracing and https://ui.perfetto.dev open directly.
+ *
+ *     CAM_TRACE_BEGIN("encode");
+ *     ...
+ *     CAM_TRACE_END("encode");
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_CAMERA_TRACE
+#define CAM_TRACE_BEGIN(name)           esp_camera_trace_event((name), 'B', 0)
+#define CAM_TRACE_END(name)             esp_camera_trace_event((name), 'E', 0)
+#define CAM_TRACE_INSTANT(name, arg)    esp_camera_trace_event((name), 'i', (arg))
+#define CAM_TRACE_COUNTER(name, value)  esp_camera_trace_event((name), 'C', (value))
+#else
+#define CAM_TRACE_BEGIN(name)           do { } while (0)
+#define CAM_TRACE_END(name)             do { } while (0)
+#define CAM_TRACE_INSTANT(name, arg)    do { (void)(arg); } while (0)
+#define CAM_TRACE_COUNTER(name, value)  do { (void)(value); } while (0)
+#endif
+
+/**
+ * @brief Receives the exported JSON piece by piece
+ *
+ * @return false to stop the export
+ */
+typedef bool (*esp_camera_trace_write_cb)(void *arg, const char *data, size_t len);
+
+/**
+ * @brief Record one event. Use the CAM_TRACE_* macros instead.
+ *
+ * @param name  String literal
+ * @param ph    Chrome trace phase: 'B' begin, 'E' end, 'i' instant, 'C' counter
+ * @param arg   Value of an instant or counter event
+ */
+void esp_camera_trace_event(const char *name, char ph, int32_t arg);
+
+/**
+ * @brief Clear the ring and start recording
+ *
+ * The first call allocates the ring, in PSRAM when there is some and in
+ * internal RAM otherwise. It is kept until reboot.
+ *
+ * @return
+ *     - ESP_OK on success
+ *     - ESP_ERR_NO_MEM if the ring could not be allocated
+ *     - ESP_ERR_NOT_SUPPORTED if CONFIG_CAMERA_TRACE is disabled
+ */
+esp_err_t esp_camera_trace_start(void);
+
+/**
+ * @brief Stop recording. The recorded events are kept for export.
+ */
+void esp_camera_trace_stop(void);
+
+/**
+ * @brief Stop recording and write the recorded events as Chrome trace JSON
+ *
+ * @param write  Called with consecutive pieces of the JSON document
+ * @param arg    Passed to write
+ *
+ * @return
+ *     - ESP_OK on success
+ *     - ESP_FAIL if write returned false
+ *     - ESP_ERR_NOT_SUPPORTED if CONFIG_CAMERA_TRACE is disabled
+ */
+esp_err_t esp_camera_trace_export(esp_camera_trace_write_cb write, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_camera.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lock-free hand-off of finished frames from cam_task to esp_camera_fb_get.
+ *
+ * There is exactly one producer (cam_task) and one consumer at a time (the
+ * task calling esp_camera_fb_get; cam_hal serializes concurrent callers with
+ * its consumer lock), so the ring itself needs no critical section:
+ *
+ *  - CAMERA_GRAB_WHEN_EMPTY: a ring of frame pointers. Only the producer
+ *    writes head and only the consumer writes tail.
+ *  - CAMERA_GRAB_LATEST: a single slot. The producer swaps the new frame in
+ *    and gets back the unread one, if any, to recycle; the consumer swaps in
+ *    NULL. The consumer always gets the newest finished frame.
+ */
+
+typedef struct {
+    camera_fb_t **slots;
+    uint32_t size;                  // frames the ring holds
+    uint32_t mask;                  // slots - 1, slots is a power of two
+    bool latest;
+    atomic_uint head;               // frames pushed
+    atomic_uint tail;               // frames popped
+    _Atomic(camera_fb_t *) slot;    // latest mode
+    // written by the producer only
+    uint32_t pushed;
+    uint32_t evicted;               // unread frames replaced in latest mode
+    uint32_t high_water;
+} cam_fb_ring_t;
+
+esp_err_t cam_fb_ring_init(cam_fb_ring_t *ring, uint32_t size, bool latest);
+
+void cam_fb_ring_deinit(cam_fb_ring_t *ring);
+
+/*
+ * Producer: queue fb. In latest mode the unread frame it replaces, if any, is
+ * returned in *evicted and belongs to the caller. Returns false if the ring
+ * is full.
+ */
+bool cam_fb_ring_push(cam_fb_ring_t *ring, camera_fb_t *fb, camera_fb_t **evicted);
+
+/* Consumer: the next frame, or NULL if there is none */
+camera_fb_t *cam_fb_ring_pop(cam_fb_ring_t *ring);
+
+/* frames waiting; exact only when called from the producer or the consumer */
+uint32_t cam_fb_ring_count(cam_fb_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
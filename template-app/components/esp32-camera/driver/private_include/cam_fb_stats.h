@@ -0,0 +1,58 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * JPEG frame size statistics for sizing the frame buffers.
+ *
+ * Sizes go into a histogram with 16 buckets per octave from 1 KiB to 1 MiB,
+ * so a percentile is at most 1/16 above the true value. Once the histogram
+ * holds CAM_FB_STATS_WINDOW frames every bucket is halved, which keeps the
+ * percentiles following the last few hundred frames when the scene changes.
+ */
+
+#define CAM_FB_STATS_STEPS      16
+#define CAM_FB_STATS_BUCKETS    (10 * CAM_FB_STATS_STEPS + 1)
+#define CAM_FB_STATS_WINDOW     256
+
+typedef struct {
+    uint16_t hist[CAM_FB_STATS_BUCKETS];
+    uint16_t hist_total;
+    uint32_t frames;        // frames added since init
+    uint32_t overflows;     // frames that did not fit their buffer
+    size_t max;             // largest frame since init
+} cam_fb_stats_t;
+
+void cam_fb_stats_init(cam_fb_stats_t *stats);
+
+/* a complete frame of len bytes */
+void cam_fb_stats_add(cam_fb_stats_t *stats, size_t len);
+
+/* a frame that overflowed a buffer of fb_size bytes; its real size is unknown */
+void cam_fb_stats_overflow(cam_fb_stats_t *stats, size_t fb_size);
+
+/* smallest size that holds permille/1000 of the recent frames, 0 if there are none */
+size_t cam_fb_stats_percentile(const cam_fb_stats_t *stats, uint32_t permille);
+
+#ifdef __cplusplus
+}
+#endif
@@ -53,10 +53,18 @@ void cam_start(void);
 
 camera_fb_t *cam_take(TickType_t timeout);
 
+camera_fb_t *cam_ref(camera_fb_t *dma_buffer);
+
 void cam_give(camera_fb_t *dma_buffer);
 
 void cam_give_all(void);
 
+esp_err_t cam_get_fb_stats(camera_fb_stats_t *stats);
+
+esp_err_t cam_get_latency_stats(camera_latency_stage_t stage, camera_latency_stats_t *stats);
+
+void cam_reset_latency_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,63 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * JPEG marker scanning for the camera frame buffers.
+ *
+ * Markers start with 0xFF, which is rare in compressed data, so the scanners
+ * look for 0xFF a 32-bit word at a time and only then check the marker.
+ *
+ * cam_jpeg_scan_feed() follows the JPEG structure as the frame arrives in
+ * chunks: header segments are skipped by their length, and in the entropy
+ * coded data the first EOI ends the frame. Bytes after it (stale DMA data
+ * from earlier frames) are never looked at, so a leftover EOI can't be
+ * mistaken for the end. If the data doesn't parse as JPEG the scanner falls
+ * back to remembering the last EOI it saw, which is what a backwards search
+ * of the whole buffer would find.
+ */
+
+typedef struct {
+    uint32_t offset;        // bytes fed so far
+    int32_t end;            // offset just past the EOI, -1 until one is found
+    uint16_t remaining;     // bytes left in the current marker segment
+    uint8_t marker;         // current marker segment
+    uint8_t state;
+} cam_jpeg_scan_t;
+
+void cam_jpeg_scan_init(cam_jpeg_scan_t *scan);
+
+/* buf holds the next len bytes of the frame */
+void cam_jpeg_scan_feed(cam_jpeg_scan_t *scan, const uint8_t *buf, size_t len);
+
+/* frame length up to and including the EOI, or -1 if none was seen */
+static inline int32_t cam_jpeg_scan_end(const cam_jpeg_scan_t *scan)
+{
+    return scan->end;
+}
+
+/* offset of the first SOI (FF D8 FF) in buf, or -1 */
+int cam_jpeg_find_soi(const uint8_t *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -22,8 +22,8 @@ const camera_sensor_info_t camera_sensor[CAMERA_MODEL_MAX] = {
 
 const resolution_info_t resolution[FRAMESIZE_INVALID] = {
     {   96,   96, ASPECT_RATIO_1X1   }, /* 96x96 */
-    {   128,  128, ASPECT_RATIO_1X1   }, /* 128x128 */
     {  160,  120, ASPECT_RATIO_4X3   }, /* QQVGA */
+    {   128,  128, ASPECT_RATIO_1X1   }, /* 128x128 */
     {  176,  144, ASPECT_RATIO_5X4   }, /* QCIF  */
     {  240,  176, ASPECT_RATIO_4X3   }, /* HQVGA */
     {  240,  240, ASPECT_RATIO_1X1   }, /* 240x240 */
@@ -0,0 +1,248 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "esp_attr.h"
+#include "ll_cam_dma_filter.h"
+
+/* byte-at-a-time filters */
+
+size_t IRAM_ATTR ll_cam_dma_filter_jpeg(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    // manually unrolling 4 iterations of the loop here
+    for (size_t i = 0; i < end; ++i) {
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[1].sample1;
+        dst[2] = dma_el[2].sample1;
+        dst[3] = dma_el[3].sample1;
+        dma_el += 4;
+        dst += 4;
+    }
+    return elements;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        // manually unrolling 4 iterations of the loop here
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[1].sample1;
+        dst[2] = dma_el[2].sample1;
+        dst[3] = dma_el[3].sample1;
+        dma_el += 4;
+        dst += 4;
+    }
+    return elements;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        // manually unrolling 4 iterations of the loop here
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[2].sample1;
+        dst[2] = dma_el[4].sample1;
+        dst[3] = dma_el[6].sample1;
+        dma_el += 8;
+        dst += 4;
+    }
+    // the final sample of a line in SM_0A0B_0B0C sampling mode needs special handling
+    if ((elements & 0x7) != 0) {
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[2].sample1;
+        elements += 1;
+    }
+    return elements / 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        dst[0] = dma_el[0].sample1;//y0
+        dst[1] = dma_el[0].sample2;//u
+        dst[2] = dma_el[1].sample1;//y1
+        dst[3] = dma_el[1].sample2;//v
+
+        dst[4] = dma_el[2].sample1;//y0
+        dst[5] = dma_el[2].sample2;//u
+        dst[6] = dma_el[3].sample1;//y1
+        dst[7] = dma_el[3].sample2;//v
+        dma_el += 4;
+        dst += 8;
+    }
+    return elements * 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        dst[0] = dma_el[0].sample1;//y0
+        dst[1] = dma_el[1].sample1;//u
+        dst[2] = dma_el[2].sample1;//y1
+        dst[3] = dma_el[3].sample1;//v
+
+        dst[4] = dma_el[4].sample1;//y0
+        dst[5] = dma_el[5].sample1;//u
+        dst[6] = dma_el[6].sample1;//y1
+        dst[7] = dma_el[7].sample1;//v
+        dma_el += 8;
+        dst += 8;
+    }
+    if ((elements & 0x7) != 0) {
+        dst[0] = dma_el[0].sample1;//y0
+        dst[1] = dma_el[1].sample1;//u
+        dst[2] = dma_el[2].sample1;//y1
+        dst[3] = dma_el[2].sample2;//v
+        elements += 4;
+    }
+    return elements;
+}
+
+/*
+ * 32-bit filters
+ *
+ * sample1 sits in bits 16..23 and sample2 in bits 0..7 of each DMA word, so
+ * four sample1 bytes (or two sample1/sample2 pairs) can be shifted into one
+ * output word and written with a single store instead of four byte stores.
+ * Output is little endian, matching the byte filters on the ESP32.
+ *
+ * Each group of DMA words is loaded before its output word is stored, which
+ * keeps in-place filtering (dst == src) correct: the write position never
+ * passes the read position.
+ */
+
+#define DMA_WORD_ALIGNED(p) ((((uintptr_t)(p)) & 3) == 0)
+
+// sample1 of four DMA words -> 4 bytes
+static inline uint32_t pack_sample1(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    return ((a >> 16) & 0x000000FF) |
+           ((b >> 8)  & 0x0000FF00) |
+           ( c        & 0x00FF0000) |
+           ((d << 8)  & 0xFF000000);
+}
+
+// sample1, sample2 of two DMA words -> 4 bytes
+static inline uint32_t pack_sample12(uint32_t a, uint32_t b)
+{
+    return ((a >> 16) & 0x000000FF) |
+           ((a << 8)  & 0x0000FF00) |
+           ( b        & 0x00FF0000) |
+           ((b << 24) & 0xFF000000);
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_jpeg_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    if (!DMA_WORD_ALIGNED(dst)) {
+        return ll_cam_dma_filter_jpeg(dst, src, len);
+    }
+    const uint32_t* in = (const uint32_t*)src;
+    uint32_t* out = (uint32_t*)dst;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        uint32_t a = in[0], b = in[1], c = in[2], d = in[3];
+        out[0] = pack_sample1(a, b, c, d);
+        in += 4;
+        out += 1;
+    }
+    return elements;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    return ll_cam_dma_filter_jpeg_word(dst, src, len);
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale_highspeed_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    if (!DMA_WORD_ALIGNED(dst)) {
+        return ll_cam_dma_filter_grayscale_highspeed(dst, src, len);
+    }
+    const uint32_t* in = (const uint32_t*)src;
+    uint32_t* out = (uint32_t*)dst;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        uint32_t a = in[0], b = in[2], c = in[4], d = in[6];
+        out[0] = pack_sample1(a, b, c, d);
+        in += 8;
+        out += 1;
+    }
+    if ((elements & 0x7) != 0) {
+        uint8_t* tail = (uint8_t*)out;
+        tail[0] = (in[0] >> 16) & 0xFF;
+        tail[1] = (in[2] >> 16) & 0xFF;
+        elements += 1;
+    }
+    return elements / 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    if (!DMA_WORD_ALIGNED(dst)) {
+        return ll_cam_dma_filter_yuyv(dst, src, len);
+    }
+    const uint32_t* in = (const uint32_t*)src;
+    uint32_t* out = (uint32_t*)dst;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        uint32_t a = in[0], b = in[1], c = in[2], d = in[3];
+        out[0] = pack_sample12(a, b);//y0 u y1 v
+        out[1] = pack_sample12(c, d);//y0 u y1 v
+        in += 4;
+        out += 2;
+    }
+    return elements * 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv_highspeed_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    if (!DMA_WORD_ALIGNED(dst)) {
+        return ll_cam_dma_filter_yuyv_highspeed(dst, src, len);
+    }
+    const uint32_t* in = (const uint32_t*)src;
+    uint32_t* out = (uint32_t*)dst;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        uint32_t a = in[0], b = in[1], c = in[2], d = in[3];
+        uint32_t e = in[4], f = in[5], g = in[6], h = in[7];
+        out[0] = pack_sample1(a, b, c, d);//y0 u y1 v
+        out[1] = pack_sample1(e, f, g, h);//y0 u y1 v
+        in += 8;
+        out += 2;
+    }
+    if ((elements & 0x7) != 0) {
+        uint32_t a = in[0], b = in[1], c = in[2];
+        out[0] = pack_sample1(a, b, c, c << 16);//y0 u y1 v(sample2 of the third word)
+        elements += 4;
+    }
+    return elements;
+}
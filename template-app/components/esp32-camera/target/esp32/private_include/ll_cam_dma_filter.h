@@ -0,0 +1,62 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * I2S DMA sample unpacking for the ESP32 camera interface.
+ *
+ * Every 32-bit word the I2S peripheral writes holds up to two camera bytes
+ * (see dma_elem_t). A filter copies the wanted bytes of len bytes of DMA data
+ * from src to dst and returns the number of bytes it produced. dst may equal
+ * src (in-place filtering of a DMA buffer); src must be 32-bit aligned.
+ *
+ * The *_word variants produce exactly the same output using 32-bit loads and
+ * stores. They fall back to the byte variants when dst is not 32-bit aligned.
+ */
+
+typedef union {
+    struct {
+        uint32_t sample2:8;
+        uint32_t unused2:8;
+        uint32_t sample1:8;
+        uint32_t unused1:8;
+    };
+    uint32_t val;
+} dma_elem_t;
+
+typedef size_t (*dma_filter_t)(uint8_t* dst, const uint8_t* src, size_t len);
+
+size_t ll_cam_dma_filter_jpeg(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale_highspeed(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv_highspeed(uint8_t* dst, const uint8_t* src, size_t len);
+
+size_t ll_cam_dma_filter_jpeg_word(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale_word(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale_highspeed_word(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv_word(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv_highspeed_word(uint8_t* dst, const uint8_t* src, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -30,6 +30,9 @@
 #endif
 #include "esp_log.h"
 #include "esp_camera.h"
+#include "cam_jpeg_scan.h"
+#include "cam_fb_stats.h"
+#include "cam_fb_ring.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
@@ -91,6 +94,13 @@ typedef struct {
     //for RGB/YUV modes
     lldesc_t *dma;
     size_t fb_offset;
+    //for JPEG mode, fed as the frame arrives
+    cam_jpeg_scan_t jpeg_scan;
+    size_t buf_size;    // bytes allocated for fb.buf
+    uint8_t refs;       // references held by the frame queue and the application
+    int64_t start_us;   // VSYNC that started the frame
+    int64_t end_us;     // VSYNC that ended it
+    int64_t ready_us;   // handed over to cam_take
 } cam_frame_t;
 
 typedef struct {
@@ -109,7 +119,10 @@ typedef struct {
     cam_frame_t *frames;
 
     QueueHandle_t event_queue;
-    QueueHandle_t frame_buffer_queue;
+    cam_fb_ring_t frame_ring;       // finished frames for cam_take
+    SemaphoreHandle_t frame_ready;  // given when cam_take is waiting on an empty ring
+    atomic_bool frame_waiting;
+    SemaphoreHandle_t consumer_lock; // one cam_take at a time on the ring's consumer side
     TaskHandle_t task_handle;
     intr_handle_t cam_intr_handle;
 
@@ -139,6 +152,16 @@ typedef struct {
     uint8_t fb_bytes_per_pixel;
 #endif
     uint32_t fb_size;
+    uint32_t fb_caps;
+
+    //JPEG frame sizes, and CONFIG_CAMERA_JPEG_FB_ADAPTIVE
+    cam_fb_stats_t fb_stats;
+    bool jpeg_fb_adaptive;
+    uint32_t fb_resizes;
+
+    //frame latency, stamped in the VSYNC interrupt
+    volatile int64_t vsync_us;
+    camera_latency_hist_t latency[CAMERA_LATENCY_STAGE_MAX];
 
     cam_state_t state;
 } cam_obj_t;
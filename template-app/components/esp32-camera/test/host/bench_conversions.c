@@ -0,0 +1,358 @@
+/*
+ * Host microbenchmark for the image conversions in conversions/.
+ *
+ * A test picture is decoded once, scaled to every framesize_t resolution and
+ * turned into the raw formats the camera can produce. Each conversion is then
+ * timed at each resolution and reported as milliseconds per frame and MB/s of
+ * uncompressed pixel data (the raw side of the conversion).
+ *
+ * Usage: conversions_bench [--quick] [--min-ms N] [--picture file.jpeg] [--max-size framesize] [--bands N]
+ *                          [--trace out.json]
+ *   --quick     one iteration per case (used by ctest as a smoke test)
+ *   --min-ms    minimum measuring time per case, default 200 ms
+ *   --picture   source picture, default test/pictures/test_outside.jpeg
+ *   --max-size  last framesize_t index to run, default all
+ *   --bands     bands (threads) of the "par" cases, fmt2jpg_parallel(), default 2
+ *   --trace     write the last CAM_TRACE events (encoder MCU rows, decoder
+ *               stages) as Chrome trace JSON, for chrome://tracing or Perfetto
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "esp_camera_trace.h"
+#include "img_converters.h"
+#include "test_util.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t *rgb888;    // BGR, as produced by fmt2rgb888
+    uint8_t *rgb565;    // big endian, as produced by the sensor
+    uint8_t *yuv422;    // YUYV
+    uint8_t *gray;
+    uint8_t *jpeg;      // encoded from rgb888 at JPEG_QUALITY
+    size_t jpeg_len;
+} frame_set_t;
+
+typedef bool (*bench_fn_t)(frame_set_t *f);
+
+typedef struct {
+    const char *name;
+    bench_fn_t fn;
+    int raw_bpp;        // bytes per pixel on the uncompressed side
+} bench_case_t;
+
+#define JPEG_QUALITY 80
+#define FMT2JPG_BUF_LEN (128 * 1024) // fixed output buffer inside fmt2jpg(), larger images are cut off
+
+static double s_min_ms = 200.0;
+static bool s_quick = false;
+static bool s_truncated = false; // set when an fmt2jpg() result filled its whole buffer
+static int s_bands = 2;
+
+static void rgb_to_yuv(uint8_t r, uint8_t g, uint8_t b, uint8_t *y, uint8_t *u, uint8_t *v)
+{
+    int yy = (77 * r + 150 * g + 29 * b) >> 8;
+    int uu = ((-43 * r - 85 * g + 128 * b) >> 8) + 128;
+    int vv = ((128 * r - 107 * g - 21 * b) >> 8) + 128;
+    *y = yy < 0 ? 0 : (yy > 255 ? 255 : yy);
+    *u = uu < 0 ? 0 : (uu > 255 ? 255 : uu);
+    *v = vv < 0 ? 0 : (vv > 255 ? 255 : vv);
+}
+
+/* Nearest-neighbour scale of the source picture plus every raw format derived from it */
+static bool frame_set_init(frame_set_t *f, const uint8_t *src_bgr, uint16_t src_w, uint16_t src_h, uint16_t w, uint16_t h)
+{
+    size_t pixels = (size_t)w * h;
+    memset(f, 0, sizeof(*f));
+    f->width = w;
+    f->height = h;
+    f->rgb888 = (uint8_t *)malloc(pixels * 3);
+    f->rgb565 = (uint8_t *)malloc(pixels * 2);
+    f->yuv422 = (uint8_t *)malloc(pixels * 2);
+    f->gray = (uint8_t *)malloc(pixels);
+    if (!f->rgb888 || !f->rgb565 || !f->yuv422 || !f->gray) {
+        return false;
+    }
+
+    for (int y = 0; y < h; y++) {
+        const uint8_t *srow = src_bgr + (size_t)(y * src_h / h) * src_w * 3;
+        for (int x = 0; x < w; x++) {
+            const uint8_t *s = srow + (size_t)(x * src_w / w) * 3;
+            size_t i = (size_t)y * w + x;
+            uint8_t b = s[0], g = s[1], r = s[2];
+            memcpy(f->rgb888 + i * 3, s, 3);
+
+            uint16_t c = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+            f->rgb565[i * 2] = c >> 8;
+            f->rgb565[i * 2 + 1] = c & 0xFF;
+
+            uint8_t yy, u, v;
+            rgb_to_yuv(r, g, b, &yy, &u, &v);
+            f->gray[i] = yy;
+            f->yuv422[i * 2] = yy;
+            f->yuv422[i * 2 + 1] = (x & 1) ? v : u;
+        }
+    }
+
+    // Decoder input goes through the callback API so it is never cut off at FMT2JPG_BUF_LEN
+    grow_buf_t out = { 0 };
+    if (!fmt2jpg_cb(f->rgb888, pixels * 3, w, h, PIXFORMAT_RGB888, JPEG_QUALITY, grow_buf_cb, &out)) {
+        free(out.buf);
+        return false;
+    }
+    f->jpeg = out.buf;
+    f->jpeg_len = out.len;
+    return true;
+}
+
+static void frame_set_free(frame_set_t *f)
+{
+    free(f->rgb888);
+    free(f->rgb565);
+    free(f->yuv422);
+    free(f->gray);
+    free(f->jpeg);
+}
+
+static bool jpg_out(uint8_t *src, size_t src_len, uint16_t w, uint16_t h, pixformat_t format)
+{
+    uint8_t *out = NULL;
+    size_t out_len = 0;
+    bool ok = fmt2jpg(src, src_len, w, h, format, JPEG_QUALITY, &out, &out_len);
+    ok = ok && out_len > 4 && out[0] == 0xFF && out[1] == 0xD8;
+    if (ok && out_len >= FMT2JPG_BUF_LEN) {
+        s_truncated = true;
+    }
+    free(out);
+    return ok;
+}
+
+static bool jpg_out_parallel(uint8_t *src, size_t src_len, uint16_t w, uint16_t h, pixformat_t format)
+{
+    uint8_t *out = NULL;
+    size_t out_len = 0;
+    bool ok = fmt2jpg_parallel(src, src_len, w, h, format, JPEG_QUALITY, s_bands, &out, &out_len);
+    ok = ok && out_len > 4 && out[0] == 0xFF && out[1] == 0xD8;
+    if (ok && out_len >= FMT2JPG_BUF_LEN) {
+        s_truncated = true;
+    }
+    free(out);
+    return ok;
+}
+
+static bool bench_fmt2jpg_yuv422(frame_set_t *f)
+{
+    return jpg_out(f->yuv422, (size_t)f->width * f->height * 2, f->width, f->height, PIXFORMAT_YUV422);
+}
+
+/* The route fmt2jpg took for YUV422 before the encoder read YUYV itself: to RGB and back to YCbCr */
+static bool bench_fmt2jpg_yuv422_rgb(frame_set_t *f)
+{
+    size_t pixels = (size_t)f->width * f->height;
+    uint8_t *rgb = (uint8_t *)malloc(pixels * 3);
+    bool ok = rgb && fmt2rgb888(f->yuv422, pixels * 2, PIXFORMAT_YUV422, rgb)
+              && jpg_out(rgb, pixels * 3, f->width, f->height, PIXFORMAT_RGB888);
+    free(rgb);
+    return ok;
+}
+
+static bool bench_fmt2jpg_rgb565(frame_set_t *f)
+{
+    return jpg_out(f->rgb565, (size_t)f->width * f->height * 2, f->width, f->height, PIXFORMAT_RGB565);
+}
+
+static bool bench_fmt2jpg_gray(frame_set_t *f)
+{
+    return jpg_out(f->gray, (size_t)f->width * f->height, f->width, f->height, PIXFORMAT_GRAYSCALE);
+}
+
+static bool bench_fmt2jpg_yuv422_parallel(frame_set_t *f)
+{
+    return jpg_out_parallel(f->yuv422, (size_t)f->width * f->height * 2, f->width, f->height, PIXFORMAT_YUV422);
+}
+
+static bool bench_fmt2jpg_rgb565_parallel(frame_set_t *f)
+{
+    return jpg_out_parallel(f->rgb565, (size_t)f->width * f->height * 2, f->width, f->height, PIXFORMAT_RGB565);
+}
+
+static bool bench_jpg2rgb565(frame_set_t *f)
+{
+    uint8_t *out = (uint8_t *)malloc((size_t)f->width * f->height * 2);
+    bool ok = out && jpg2rgb565(f->jpeg, f->jpeg_len, out, JPG_SCALE_NONE);
+    free(out);
+    return ok;
+}
+
+static bool bench_fmt2rgb888_jpeg(frame_set_t *f)
+{
+    uint8_t *out = (uint8_t *)malloc((size_t)f->width * f->height * 3);
+    bool ok = out && fmt2rgb888(f->jpeg, f->jpeg_len, PIXFORMAT_JPEG, out);
+    free(out);
+    return ok;
+}
+
+static bool bench_fmt2rgb888_yuv422(frame_set_t *f)
+{
+    uint8_t *out = (uint8_t *)malloc((size_t)f->width * f->height * 3);
+    bool ok = out && fmt2rgb888(f->yuv422, (size_t)f->width * f->height * 2, PIXFORMAT_YUV422, out);
+    free(out);
+    return ok;
+}
+
+static bool bench_fmt2bmp_jpeg(frame_set_t *f)
+{
+    uint8_t *out = NULL;
+    size_t out_len = 0;
+    bool ok = fmt2bmp(f->jpeg, f->jpeg_len, f->width, f->height, PIXFORMAT_JPEG, &out, &out_len);
+    ok = ok && out_len > (size_t)f->width * f->height * 3;
+    free(out);
+    return ok;
+}
+
+static bool bench_fmt2bmp_rgb565(frame_set_t *f)
+{
+    uint8_t *out = NULL;
+    size_t out_len = 0;
+    bool ok = fmt2bmp(f->rgb565, (size_t)f->width * f->height * 2, f->width, f->height, PIXFORMAT_RGB565, &out, &out_len);
+    ok = ok && out_len > (size_t)f->width * f->height * 3;
+    free(out);
+    return ok;
+}
+
+static const bench_case_t s_cases[] = {
+    { "fmt2jpg yuv422",    bench_fmt2jpg_yuv422,    2 },
+    { "fmt2jpg yuv422 rgb", bench_fmt2jpg_yuv422_rgb, 2 },
+    { "fmt2jpg rgb565",    bench_fmt2jpg_rgb565,    2 },
+    { "fmt2jpg gray",      bench_fmt2jpg_gray,      1 },
+    { "fmt2jpg yuv422 par", bench_fmt2jpg_yuv422_parallel, 2 },
+    { "fmt2jpg rgb565 par", bench_fmt2jpg_rgb565_parallel, 2 },
+    { "jpg2rgb565",        bench_jpg2rgb565,        2 },
+    { "fmt2rgb888 jpeg",   bench_fmt2rgb888_jpeg,   3 },
+    { "fmt2rgb888 yuv422", bench_fmt2rgb888_yuv422, 3 },
+    { "fmt2bmp jpeg",      bench_fmt2bmp_jpeg,      3 },
+    { "fmt2bmp rgb565",    bench_fmt2bmp_rgb565,    2 },
+};
+
+#define CASE_COUNT (sizeof(s_cases) / sizeof(s_cases[0]))
+
+/* Runs one case until s_min_ms has elapsed (at least 3 runs), returns ms per frame or -1 on failure */
+static double run_case(const bench_case_t *c, frame_set_t *f)
+{
+    int runs = 0;
+    double start = now_ms(), elapsed = 0;
+    do {
+        if (!c->fn(f)) {
+            return -1;
+        }
+        runs++;
+        elapsed = now_ms() - start;
+    } while (!s_quick && (runs < 3 || elapsed < s_min_ms));
+    return elapsed / runs;
+}
+
+static bool trace_write(void *arg, const char *data, size_t len)
+{
+    return fwrite(data, 1, len, (FILE *)arg) == len;
+}
+
+int main(int argc, char **argv)
+{
+    const char *picture = TEST_PICTURES_DIR "/test_outside.jpeg";
+    const char *trace = NULL;
+    int max_size = FRAMESIZE_INVALID - 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            s_quick = true;
+        } else if (!strcmp(argv[i], "--min-ms") && i + 1 < argc) {
+            s_min_ms = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--picture") && i + 1 < argc) {
+            picture = argv[++i];
+        } else if (!strcmp(argv[i], "--max-size") && i + 1 < argc) {
+            max_size = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--bands") && i + 1 < argc) {
+            s_bands = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace = argv[++i];
+        } else {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (max_size >= FRAMESIZE_INVALID) {
+        max_size = FRAMESIZE_INVALID - 1;
+    }
+
+    size_t jpg_len = 0;
+    int src_w = 0, src_h = 0;
+    uint8_t *jpg = read_file(picture, &jpg_len);
+    if (!jpg || !jpeg_size(jpg, jpg_len, &src_w, &src_h)) {
+        fprintf(stderr, "cannot read %s\n", picture);
+        return 1;
+    }
+    uint8_t *src_bgr = (uint8_t *)malloc((size_t)src_w * src_h * 3);
+    if (!src_bgr || !fmt2rgb888(jpg, jpg_len, PIXFORMAT_JPEG, src_bgr)) {
+        fprintf(stderr, "cannot decode %s\n", picture);
+        return 1;
+    }
+
+    printf("source %s (%dx%d), JPEG quality %d, %d bands in the par cases%s\n", picture, src_w, src_h, JPEG_QUALITY, s_bands,
+           s_quick ? ", quick" : "");
+    printf("%-18s  %11s  %9s  %8s\n", "conversion", "resolution", "ms/frame", "raw MB/s");
+
+    if (trace && esp_camera_trace_start() != ESP_OK) {
+        fprintf(stderr, "tracing is not built in\n");
+        return 2;
+    }
+
+    int failures = 0;
+    for (int fs = 0; fs <= max_size; fs++) {
+        frame_set_t f;
+        uint16_t w = resolution[fs].width, h = resolution[fs].height;
+        if (!frame_set_init(&f, src_bgr, src_w, src_h, w, h)) {
+            fprintf(stderr, "cannot prepare %ux%u\n", w, h);
+            frame_set_free(&f);
+            failures++;
+            continue;
+        }
+        for (size_t c = 0; c < CASE_COUNT; c++) {
+            s_truncated = false;
+            double ms = run_case(&s_cases[c], &f);
+            if (ms < 0) {
+                printf("%-18s  %5u x %-4u  %9s\n", s_cases[c].name, w, h, "FAILED");
+                failures++;
+                continue;
+            }
+            double mb = (double)w * h * s_cases[c].raw_bpp / (1024.0 * 1024.0);
+            printf("%-18s  %5u x %-4u  %9.3f  %8.1f%s\n", s_cases[c].name, w, h, ms, mb / (ms / 1000.0),
+                   s_truncated ? "  (output cut at 128 KiB)" : "");
+        }
+        frame_set_free(&f);
+    }
+
+    if (trace) {
+        FILE *out = fopen(trace, "w");
+        if (!out || esp_camera_trace_export(trace_write, out) != ESP_OK) {
+            fprintf(stderr, "cannot write %s\n", trace);
+            failures++;
+        }
+        if (out) {
+            fclose(out);
+        }
+    }
+
+    free(src_bgr);
+    free(jpg);
+    if (failures) {
+        fprintf(stderr, "%d conversion(s) failed\n", failures);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Host microbenchmark for the ll_cam DMA filters: byte-wise vs 32-bit.
+ *
+ * Each filter unpacks one DMA half buffer (CONFIG_CAMERA_DMA_BUFFER_SIZE_MAX / 2
+ * by default) into a separate frame buffer, repeated until the time budget is
+ * used. Reported as output bytes per CPU cycle (TSC on x86, otherwise
+ * nanoseconds are shown instead of cycles) and the speedup of the word filter.
+ *
+ * Usage: dma_filter_bench [--quick] [--len bytes]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ll_cam_dma_filter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycle"
+static inline uint64_t bench_ticks(void)
+{
+    return __rdtsc();
+}
+#else
+#define BENCH_UNIT "ns"
+static inline uint64_t bench_ticks(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+#endif
+
+typedef struct {
+    const char *name;
+    dma_filter_t byte_fn;
+    dma_filter_t word_fn;
+} filter_pair_t;
+
+static const filter_pair_t s_filters[] = {
+    { "jpeg",                ll_cam_dma_filter_jpeg,                ll_cam_dma_filter_jpeg_word },
+    { "grayscale",           ll_cam_dma_filter_grayscale,           ll_cam_dma_filter_grayscale_word },
+    { "grayscale_highspeed", ll_cam_dma_filter_grayscale_highspeed, ll_cam_dma_filter_grayscale_highspeed_word },
+    { "yuyv",                ll_cam_dma_filter_yuyv,                ll_cam_dma_filter_yuyv_word },
+    { "yuyv_highspeed",      ll_cam_dma_filter_yuyv_highspeed,      ll_cam_dma_filter_yuyv_highspeed_word },
+};
+
+#define FILTER_COUNT (sizeof(s_filters) / sizeof(s_filters[0]))
+
+static double s_min_ms = 200.0;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* output bytes per tick */
+static double run(dma_filter_t fn, uint8_t *dst, const uint8_t *src, size_t len)
+{
+    uint64_t ticks = 0, bytes = 0;
+    double start = now_ms();
+    int runs = 0;
+    do {
+        uint64_t t0 = bench_ticks();
+        bytes += fn(dst, src, len);
+        ticks += bench_ticks() - t0;
+        runs++;
+    } while (runs < 3 || now_ms() - start < s_min_ms);
+    return ticks ? (double)bytes / ticks : 0;
+}
+
+int main(int argc, char **argv)
+{
+    size_t len = 16384;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            s_min_ms = 5;
+        } else if (!strcmp(argv[i], "--len") && i + 1 < argc) {
+            len = strtoul(argv[++i], NULL, 0) & ~(size_t)31;
+        } else {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    uint32_t *src = (uint32_t *)malloc(len + 64);
+    uint32_t *dst = (uint32_t *)malloc(len * 2 + 64);
+    if (!src || !dst) {
+        return 1;
+    }
+    for (size_t i = 0; i < (len + 64) / 4; i++) {
+        src[i] = (uint32_t)(i * 2654435761u);
+    }
+
+    printf("DMA buffer %zu bytes, output bytes per %s\n", len, BENCH_UNIT);
+    printf("%-20s  %8s  %8s  %7s\n", "filter", "byte", "word", "speedup");
+    for (size_t f = 0; f < FILTER_COUNT; f++) {
+        double b = run(s_filters[f].byte_fn, (uint8_t *)dst, (const uint8_t *)src, len);
+        double w = run(s_filters[f].word_fn, (uint8_t *)dst, (const uint8_t *)src, len);
+        printf("%-20s  %8.3f  %8.3f  %6.2fx\n", s_filters[f].name, b, w, b > 0 ? w / b : 0);
+    }
+
+    free(src);
+    free(dst);
+    return 0;
+}
@@ -0,0 +1,333 @@
+/*
+ * Host benchmark for handing finished frames from cam_task to
+ * esp_camera_fb_get.
+ *
+ * "queue" is what cam_hal did before, with a mutex standing in for the
+ * critical section of every FreeRTOS queue call: xQueueSend, and with
+ * GRAB_LATEST on a full queue xQueueReceive + xQueueSend + cam_give. A
+ * consumer blocked in xQueueReceive is woken through a condition variable.
+ * "ring" and "latest" are cam_fb_ring_push/pop with cam_hal's wake-up: the
+ * consumer raises a flag before it sleeps and only then does the producer
+ * post the semaphore.
+ *
+ * A producer thread finishes a frame every --period us into one of three
+ * frame buffers; a consumer thread takes frames, holds each for --hold us
+ * and returns it. For every mode the benchmark reports the producer's cost
+ * of one hand-off (cam_task's hot path) and the latency from the frame being
+ * finished to the consumer having it, as percentiles and log2 histograms.
+ *
+ * Usage: fb_ring_bench [--quick] [--frames n] [--period us] [--hold us]
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cam_fb_ring.h"
+
+#define FRAMES      3
+#define HIST_MIN    6       // first bucket: below 2^6 ns
+#define HIST_BUCKETS 22
+
+typedef enum {
+    MODE_QUEUE,
+    MODE_RING,
+    MODE_QUEUE_LATEST,
+    MODE_LATEST,
+} bench_mode_t;
+
+static const char *s_mode_names[] = {
+    [MODE_QUEUE] = "queue", [MODE_RING] = "ring",
+    [MODE_QUEUE_LATEST] = "queue latest", [MODE_LATEST] = "latest slot",
+};
+
+typedef struct {
+    bench_mode_t mode;
+    camera_fb_t fbs[FRAMES];
+    int64_t done_ns[FRAMES];    // when the producer finished the frame
+    atomic_bool busy[FRAMES];
+
+    // queue model
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    camera_fb_t *q[FRAMES];
+    int q_len, q_head, q_count;
+
+    // ring model
+    cam_fb_ring_t ring;
+    atomic_bool waiting;
+    sem_t ready;
+
+    atomic_bool stop;
+    int64_t *send_ns;
+    int64_t *latency_ns;
+    int sends, receives, no_buffer;
+} bench_t;
+
+static int s_frames = 20000;
+static int s_period_us = 100;
+static int s_hold_us = 250;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* busy-wait, but let the other thread have the CPU on a single-core host */
+static void spin_until(int64_t t)
+{
+    while (now_ns() < t) {
+        sched_yield();
+    }
+}
+
+static void give(bench_t *b, camera_fb_t *fb)
+{
+    atomic_store(&b->busy[fb - b->fbs], false);
+}
+
+static bool is_latest(const bench_t *b)
+{
+    return b->mode == MODE_QUEUE_LATEST || b->mode == MODE_LATEST;
+}
+
+/* cam_task: what cam_hal did with frame_buffer_queue */
+static void queue_send(bench_t *b, camera_fb_t *fb)
+{
+    camera_fb_t *fb2 = NULL;
+    pthread_mutex_lock(&b->lock);
+    if (b->q_count == b->q_len) {
+        // xQueueSend failed: xQueueReceive the oldest, then xQueueSend again
+        pthread_mutex_unlock(&b->lock);
+        pthread_mutex_lock(&b->lock);
+        if (b->q_count) {
+            fb2 = b->q[b->q_head];
+            b->q_head = (b->q_head + 1) % b->q_len;
+            b->q_count--;
+        }
+        pthread_mutex_unlock(&b->lock);
+        pthread_mutex_lock(&b->lock);
+    }
+    b->q[(b->q_head + b->q_count) % b->q_len] = fb;
+    b->q_count++;
+    pthread_cond_signal(&b->cond);
+    pthread_mutex_unlock(&b->lock);
+    if (fb2) {
+        give(b, fb2);
+    }
+}
+
+static camera_fb_t *queue_receive(bench_t *b)
+{
+    camera_fb_t *fb = NULL;
+    pthread_mutex_lock(&b->lock);
+    while (!b->q_count && !atomic_load(&b->stop)) {
+        pthread_cond_wait(&b->cond, &b->lock);
+    }
+    if (b->q_count) {
+        fb = b->q[b->q_head];
+        b->q_head = (b->q_head + 1) % b->q_len;
+        b->q_count--;
+    }
+    pthread_mutex_unlock(&b->lock);
+    return fb;
+}
+
+/* cam_send_frame() */
+static void ring_send(bench_t *b, camera_fb_t *fb)
+{
+    camera_fb_t *evicted;
+    if (!cam_fb_ring_push(&b->ring, fb, &evicted)) {
+        give(b, fb);
+        return;
+    }
+    if (evicted) {
+        give(b, evicted);
+    }
+    if (atomic_exchange(&b->waiting, false)) {
+        sem_post(&b->ready);
+    }
+}
+
+/* cam_wait_frame() */
+static camera_fb_t *ring_receive(bench_t *b)
+{
+    camera_fb_t *fb = cam_fb_ring_pop(&b->ring);
+    while (!fb && !atomic_load(&b->stop)) {
+        atomic_store(&b->waiting, true);
+        fb = cam_fb_ring_pop(&b->ring);
+        if (!fb) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += 10000000;
+            if (ts.tv_nsec >= 1000000000) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            while (sem_timedwait(&b->ready, &ts) && errno == EINTR) {
+            }
+            fb = cam_fb_ring_pop(&b->ring);
+        }
+        atomic_store(&b->waiting, false);
+    }
+    return fb;
+}
+
+static void *producer(void *arg)
+{
+    bench_t *b = (bench_t *)arg;
+    int64_t next = now_ns();
+    int pos = 0;
+    for (int n = 0; n < s_frames; n++) {
+        next += s_period_us * 1000LL;
+        spin_until(next);
+        // cam_start_frame: the next buffer nobody holds
+        int x;
+        for (x = 0; x < FRAMES && atomic_load(&b->busy[(pos + x) % FRAMES]); x++) {
+        }
+        if (x == FRAMES) {
+            b->no_buffer++;
+            continue;
+        }
+        pos = (pos + x) % FRAMES;
+        camera_fb_t *fb = &b->fbs[pos];
+        atomic_store(&b->busy[pos], true);
+        pos = (pos + 1) % FRAMES;
+
+        int64_t t0 = now_ns();
+        b->done_ns[fb - b->fbs] = t0;
+        if (b->mode == MODE_QUEUE || b->mode == MODE_QUEUE_LATEST) {
+            queue_send(b, fb);
+        } else {
+            ring_send(b, fb);
+        }
+        b->send_ns[b->sends++] = now_ns() - t0;
+    }
+    atomic_store(&b->stop, true);
+    pthread_mutex_lock(&b->lock);
+    pthread_cond_signal(&b->cond);
+    pthread_mutex_unlock(&b->lock);
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    bench_t *b = (bench_t *)arg;
+    while (true) {
+        camera_fb_t *fb = b->mode == MODE_QUEUE || b->mode == MODE_QUEUE_LATEST ? queue_receive(b) : ring_receive(b);
+        if (!fb) {
+            if (atomic_load(&b->stop)) {
+                break;
+            }
+            continue;
+        }
+        int64_t t = now_ns();
+        b->latency_ns[b->receives++] = t - b->done_ns[fb - b->fbs];
+        spin_until(t + s_hold_us * 1000LL);
+        give(b, fb);
+    }
+    return NULL;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void print_samples(const char *what, int64_t *v, int n)
+{
+    if (!n) {
+        printf("  %-9s no samples\n", what);
+        return;
+    }
+    qsort(v, n, sizeof(v[0]), cmp_i64);
+    printf("  %-9s p50 %8.2f us  p99 %8.2f us  max %8.2f us   ", what,
+           v[n / 2] / 1e3, v[(n * 99) / 100] / 1e3, v[n - 1] / 1e3);
+    int hist[HIST_BUCKETS] = { 0 };
+    for (int i = 0; i < n; i++) {
+        int bkt = 0;
+        while (bkt < HIST_BUCKETS - 1 && v[i] >= (1LL << (HIST_MIN + bkt))) {
+            bkt++;
+        }
+        hist[bkt]++;
+    }
+    // one column per power of two, from <64 ns
+    for (int bkt = 0; bkt < HIST_BUCKETS; bkt++) {
+        int permille = (int)(hist[bkt] * 1000LL / n);
+        putchar(hist[bkt] == 0 ? '.' : permille < 10 ? ',' : permille < 100 ? 'o' : 'O');
+    }
+    putchar('\n');
+}
+
+static void run(bench_mode_t mode)
+{
+    bench_t *b = (bench_t *)calloc(1, sizeof(bench_t));
+    b->mode = mode;
+    b->send_ns = (int64_t *)calloc(s_frames, sizeof(int64_t));
+    b->latency_ns = (int64_t *)calloc(s_frames, sizeof(int64_t));
+    for (int i = 0; i < FRAMES; i++) {
+        atomic_init(&b->busy[i], false);
+    }
+    atomic_init(&b->stop, false);
+    atomic_init(&b->waiting, false);
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->cond, NULL);
+    sem_init(&b->ready, 0, 0);
+    // cam_config: FRAMES - 1 queue entries with GRAB_LATEST
+    b->q_len = mode == MODE_QUEUE_LATEST ? FRAMES - 1 : FRAMES;
+    cam_fb_ring_init(&b->ring, FRAMES, is_latest(b));
+
+    pthread_t p, c;
+    pthread_create(&c, NULL, consumer, b);
+    pthread_create(&p, NULL, producer, b);
+    pthread_join(p, NULL);
+    pthread_join(c, NULL);
+
+    printf("%-12s %d frames sent, %d taken, %d with no free buffer\n", s_mode_names[mode], b->sends, b->receives, b->no_buffer);
+    print_samples("hand-off", b->send_ns, b->sends);
+    print_samples("latency", b->latency_ns, b->receives);
+
+    cam_fb_ring_deinit(&b->ring);
+    sem_destroy(&b->ready);
+    pthread_cond_destroy(&b->cond);
+    pthread_mutex_destroy(&b->lock);
+    free(b->send_ns);
+    free(b->latency_ns);
+    free(b);
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            s_frames = 2000;
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            s_frames = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--period") && i + 1 < argc) {
+            s_period_us = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--hold") && i + 1 < argc) {
+            s_hold_us = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (s_frames <= 0 || s_period_us <= 0 || s_hold_us < 0) {
+        fprintf(stderr, "bad arguments\n");
+        return 2;
+    }
+
+    printf("%d frames every %d us, consumer holds each %d us, %d frame buffers\n", s_frames, s_period_us, s_hold_us, FRAMES);
+    printf("histogram columns: <64 ns, then one per power of two; . none , <1%% o <10%% O more\n");
+    for (bench_mode_t mode = MODE_QUEUE; mode <= MODE_LATEST; mode++) {
+        run(mode);
+    }
+    return 0;
+}
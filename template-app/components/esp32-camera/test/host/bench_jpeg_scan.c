@@ -0,0 +1,154 @@
+/*
+ * Host microbenchmark for the cam_hal JPEG marker search.
+ *
+ * "old" is what cam_hal did before: a memcmp() per byte for the SOI at the
+ * start of the frame and a backwards memcmp() search for the last EOI over
+ * the whole frame buffer once VSYNC arrived. "new" is cam_jpeg_find_soi()
+ * plus cam_jpeg_scan_feed() over the frame in 1024-byte pieces, the size
+ * ll_cam_memcpy() hands over per DMA half buffer in JPEG mode. Each frame
+ * sits at the start of a frame buffer filled with stale entropy data, as on
+ * the chip, so the backwards search has to walk back to the frame's EOI.
+ *
+ * Usage: jpeg_scan_bench [--quick] [--fb bytes] [file.jpg ...]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cam_jpeg_scan.h"
+#include "test_util.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+#define CHUNK 1024
+
+static double s_min_ms = 200.0;
+
+static const uint8_t JPEG_SOI_MARKER[3] = { 0xFF, 0xD8, 0xFF };
+static const uint8_t JPEG_EOI_MARKER[2] = { 0xFF, 0xD9 };
+
+static int old_find_soi(const uint8_t *inbuf, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++) {
+        if (memcmp(&inbuf[i], JPEG_SOI_MARKER, 3) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int old_find_eoi(const uint8_t *inbuf, uint32_t length)
+{
+    int offset = -1;
+    uint8_t *dptr = (uint8_t *)inbuf + length - 2;
+    while (dptr > inbuf) {
+        if (memcmp(dptr, JPEG_EOI_MARKER, 2) == 0) {
+            offset = dptr - inbuf;
+            return offset;
+        }
+        dptr--;
+    }
+    return -1;
+}
+
+static volatile int s_sink;
+
+/* frame buffers per second */
+static double run_old(const uint8_t *fb, size_t fb_len)
+{
+    double start = now_ms(), elapsed;
+    int runs = 0;
+    do {
+        s_sink += old_find_soi(fb, CHUNK);
+        s_sink += old_find_eoi(fb, fb_len);
+        runs++;
+    } while ((elapsed = now_ms() - start) < s_min_ms);
+    return runs * 1000.0 / elapsed;
+}
+
+static double run_new(const uint8_t *fb, size_t fb_len, size_t jpg_len)
+{
+    double start = now_ms(), elapsed;
+    int runs = 0;
+    do {
+        cam_jpeg_scan_t scan;
+        cam_jpeg_scan_init(&scan);
+        s_sink += cam_jpeg_find_soi(fb, CHUNK);
+        // cam_task feeds every DMA chunk until VSYNC; the frame ends in the last one
+        for (size_t pos = 0; pos < jpg_len; pos += CHUNK) {
+            cam_jpeg_scan_feed(&scan, fb + pos, CHUNK);
+        }
+        s_sink += cam_jpeg_scan_end(&scan);
+        runs++;
+    } while ((elapsed = now_ms() - start) < s_min_ms);
+    return runs * 1000.0 / elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *defaults[] = {
+        TEST_PICTURES_DIR "/testimg.jpeg",
+        TEST_PICTURES_DIR "/test_inside.jpeg",
+        TEST_PICTURES_DIR "/test_outside.jpeg",
+    };
+    const char **files = defaults;
+    int file_count = sizeof(defaults) / sizeof(defaults[0]);
+    size_t fb_len = 0;
+    int status = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            s_min_ms = 5;
+        } else if (!strcmp(argv[i], "--fb") && i + 1 < argc) {
+            fb_len = strtoul(argv[++i], NULL, 0);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return 2;
+        } else {
+            files = (const char **)&argv[i];
+            file_count = argc - i;
+            break;
+        }
+    }
+
+    printf("%-20s  %8s  %8s  %10s  %10s  %7s\n", "picture", "bytes", "fb", "old fb/s", "new fb/s", "speedup");
+    for (int f = 0; f < file_count; f++) {
+        size_t jpg_len;
+        uint8_t *jpg = read_file(files[f], &jpg_len);
+        if (!jpg) {
+            fprintf(stderr, "cannot read %s\n", files[f]);
+            return 1;
+        }
+        // by default the frame fills half of its buffer
+        size_t len = fb_len > jpg_len + CHUNK ? fb_len : (jpg_len + CHUNK) * 2;
+        uint8_t *fb = (uint8_t *)malloc(len);
+        uint32_t r = 1;
+        for (size_t i = 0; i < len; i++) {
+            r = r * 1103515245u + 12345u;
+            fb[i] = r >> 16;
+            if (fb[i] == 0xFF && i + 1 < len) {
+                fb[++i] = 0x00;     // stuffed like entropy data, no stray EOI
+            }
+        }
+        memcpy(fb, jpg, jpg_len);
+
+        cam_jpeg_scan_t scan;
+        cam_jpeg_scan_init(&scan);
+        cam_jpeg_scan_feed(&scan, fb, len);
+        if (cam_jpeg_scan_end(&scan) != (int32_t)jpg_len) {
+            printf("%s: scanner found end %d, expected %zu\n", files[f], (int)cam_jpeg_scan_end(&scan), jpg_len);
+            status = 1;
+        }
+
+        double o = run_old(fb, len);
+        double n = run_new(fb, len, jpg_len);
+        const char *name = strrchr(files[f], '/');
+        printf("%-20s  %8zu  %8zu  %10.0f  %10.0f  %6.2fx\n", name ? name + 1 : files[f],
+               jpg_len, len, o, n, o > 0 ? n / o : 0);
+        free(fb);
+        free(jpg);
+    }
+    return status;
+}
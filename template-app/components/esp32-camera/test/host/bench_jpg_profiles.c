@@ -0,0 +1,275 @@
+/*
+ * Host harness: JPEG size against digit recognition for the encoder profiles.
+ *
+ * The corpus is meter-like frames: each test picture, scaled to QVGA, with
+ * a low contrast display panel holding rows of 5x7 font digits from 7 to
+ * 20 pixels high, anti-aliased at sub-pixel offsets and with sensor noise.
+ * Every frame is encoded with each jpg_profile_t over a range of qualities
+ * and decoded with tjpgd. A template matching reader, which knows where each
+ * digit is, then picks the digit whose ideal rendering correlates best with
+ * the decoded luma. Reported per profile and quality: the corpus size in
+ * bytes and the share of digits read correctly, overall and for the
+ * smallest size.
+ *
+ * The reader stands in for the server's OCR: it cannot tell how a real OCR
+ * engine weighs artefacts, but it ranks the profiles by how much of the
+ * strokes survive at a given number of bytes.
+ *
+ * Usage: jpeg_profile_bench [--quick]
+ *   --quick     one picture and three qualities (used by ctest as a smoke test)
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "test_util.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+#define FRAME_W 320
+#define FRAME_H 240
+#define DIGITS_PER_ROW 10
+#define MAX_DIGITS 64
+
+typedef struct {
+    double x, y, h;     // top left and height of the glyph cell, in pixels; width is h * 5 / 7
+    int digit;
+} glyph_t;
+
+typedef struct {
+    uint8_t bgr[FRAME_W * FRAME_H * 3];
+    glyph_t glyphs[MAX_DIGITS];
+    int count;
+} frame_t;
+
+// 5x7 digits, one row per byte, bit 4 the leftmost column
+static const uint8_t s_font[10][7] = {
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },
+};
+
+// digit heights of the panel rows, the smallest first
+static const double s_row_heights[] = { 7, 9, 12, 20 };
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return s_seed >> 16;
+}
+
+/* Ink coverage (0-1) of glyph g at pixel (px, py), 4x4 supersampled */
+static double coverage(const glyph_t *g, int digit, int px, int py)
+{
+    double cell = g->h / 7;
+    int hits = 0;
+    for (int sy = 0; sy < 4; sy++) {
+        for (int sx = 0; sx < 4; sx++) {
+            double fx = (px + (sx + 0.5) / 4 - g->x) / cell, fy = (py + (sy + 0.5) / 4 - g->y) / cell;
+            if (fx >= 0 && fx < 5 && fy >= 0 && fy < 7 && (s_font[digit][(int)fy] & (0x10 >> (int)fx))) {
+                hits++;
+            }
+        }
+    }
+    return hits / 16.0;
+}
+
+static void glyph_box(const glyph_t *g, int *x0, int *y0, int *x1, int *y1)
+{
+    *x0 = (int)floor(g->x) - 1;
+    *y0 = (int)floor(g->y) - 1;
+    *x1 = (int)ceil(g->x + g->h * 5 / 7) + 1;
+    *y1 = (int)ceil(g->y + g->h) + 1;
+}
+
+/* Picture scaled to the frame, a panel, rows of digits and noise */
+static void make_frame(frame_t *f, const uint8_t *pic, int pw, int ph)
+{
+    for (int y = 0; y < FRAME_H; y++) {
+        for (int x = 0; x < FRAME_W; x++) {
+            memcpy(f->bgr + (y * FRAME_W + x) * 3, pic + ((size_t)(y * ph / FRAME_H) * pw + x * pw / FRAME_W) * 3, 3);
+        }
+    }
+
+    // a greenish grey panel, mixed 3:1 over the picture so it keeps some texture
+    int px0 = 12, py0 = 20, px1 = FRAME_W - 12, py1 = FRAME_H - 20;
+    static const uint8_t panel[3] = { 150, 175, 160 }, ink[3] = { 70, 80, 60 };
+    for (int y = py0; y < py1; y++) {
+        for (int x = px0; x < px1; x++) {
+            uint8_t *p = f->bgr + (y * FRAME_W + x) * 3;
+            for (int c = 0; c < 3; c++) {
+                p[c] = (panel[c] * 3 + p[c]) / 4;
+            }
+        }
+    }
+
+    f->count = 0;
+    double y = py0 + 8;
+    for (size_t r = 0; r < sizeof(s_row_heights) / sizeof(s_row_heights[0]); r++) {
+        double h = s_row_heights[r];
+        double x = px0 + 8 + (rnd() % 8) / 8.0;
+        for (int i = 0; i < DIGITS_PER_ROW && f->count < MAX_DIGITS; i++) {
+            glyph_t *g = &f->glyphs[f->count++];
+            g->x = x;
+            g->y = y + (rnd() % 8) / 8.0;
+            g->h = h;
+            g->digit = rnd() % 10;
+            x += h * 5 / 7 + h * 0.4;
+
+            int x0, y0, x1, y1;
+            glyph_box(g, &x0, &y0, &x1, &y1);
+            for (int py = y0; py < y1; py++) {
+                for (int px = x0; px < x1; px++) {
+                    double a = coverage(g, g->digit, px, py);
+                    uint8_t *p = f->bgr + (py * FRAME_W + px) * 3;
+                    for (int c = 0; c < 3; c++) {
+                        p[c] = (uint8_t)(p[c] * (1 - a) + ink[c] * a + 0.5);
+                    }
+                }
+            }
+        }
+        y += h * 1.6 + 4;
+    }
+
+    for (int i = 0; i < FRAME_W * FRAME_H * 3; i++) {
+        int v = f->bgr[i] + (int)(rnd() % 13) - 6;
+        f->bgr[i] = v < 0 ? 0 : v > 255 ? 255 : v;
+    }
+}
+
+/* Pearson correlation of the decoded luma in g's box with the ideal rendering of digit */
+static double match(const glyph_t *g, int digit, const uint8_t *bgr)
+{
+    int x0, y0, x1, y1;
+    glyph_box(g, &x0, &y0, &x1, &y1);
+    double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+    int n = 0;
+    for (int py = y0; py < y1; py++) {
+        for (int px = x0; px < x1; px++) {
+            const uint8_t *p = bgr + (py * FRAME_W + px) * 3;
+            double a = -(0.114 * p[0] + 0.587 * p[1] + 0.299 * p[2]);     // ink is dark
+            double b = coverage(g, digit, px, py);
+            sa += a;
+            sb += b;
+            saa += a * a;
+            sbb += b * b;
+            sab += a * b;
+            n++;
+        }
+    }
+    double va = saa - sa * sa / n, vb = sbb - sb * sb / n;
+    return va > 0 && vb > 0 ? (sab - sa * sb / n) / sqrt(va * vb) : -1;
+}
+
+static int read_digit(const glyph_t *g, const uint8_t *bgr)
+{
+    int best = 0;
+    double best_r = -2;
+    for (int d = 0; d < 10; d++) {
+        double r = match(g, d, bgr);
+        if (r > best_r) {
+            best_r = r;
+            best = d;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *pictures[] = { "testimg.jpeg", "test_inside.jpeg", "test_outside.jpeg" };
+    static const int qualities[] = { 5, 10, 15, 20, 30, 50, 70, 90 };
+    static const int quick_qualities[] = { 10, 50, 90 };
+    bool quick = argc > 1 && !strcmp(argv[1], "--quick");
+    int num_pictures = quick ? 1 : 3;
+    const int *q_list = quick ? quick_qualities : qualities;
+    int num_q = quick ? 3 : (int)(sizeof(qualities) / sizeof(qualities[0]));
+    int frames_per_picture = quick ? 1 : 4;
+
+    int num_frames = num_pictures * frames_per_picture;
+    frame_t *frames = (frame_t *)malloc(sizeof(frame_t) * num_frames);
+    uint8_t *decoded = (uint8_t *)malloc(FRAME_W * FRAME_H * 3);
+    int n = 0;
+    for (int p = 0; p < num_pictures; p++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", TEST_PICTURES_DIR, pictures[p]);
+        size_t len;
+        uint8_t *jpg = read_file(path, &len);
+        int w, h;
+        if (!jpg || !jpeg_size(jpg, len, &w, &h)) {
+            fprintf(stderr, "cannot read %s\n", path);
+            return 1;
+        }
+        uint8_t *pic = (uint8_t *)malloc((size_t)w * h * 3);
+        if (!fmt2rgb888(jpg, len, PIXFORMAT_JPEG, pic)) {
+            fprintf(stderr, "cannot decode %s\n", path);
+            return 1;
+        }
+        for (int i = 0; i < frames_per_picture; i++) {
+            make_frame(&frames[n++], pic, w, h);
+        }
+        free(pic);
+        free(jpg);
+    }
+
+    int total_digits = 0, small_digits = 0;
+    for (int i = 0; i < num_frames; i++) {
+        total_digits += frames[i].count;
+        for (int g = 0; g < frames[i].count; g++) {
+            small_digits += frames[i].glyphs[g].h == s_row_heights[0];
+        }
+    }
+    printf("%d frames %dx%d RGB888, %d digits (%d of %.0f px)%s\n", num_frames, FRAME_W, FRAME_H, total_digits,
+           small_digits, s_row_heights[0], quick ? ", quick" : "");
+    printf("profile     quality   bytes/frame   read   read %.0f px\n", s_row_heights[0]);
+
+    int failures = 0;
+    for (int profile = 0; profile < JPG_PROFILE_MAX; profile++) {
+        static const char *names[JPG_PROFILE_MAX] = { "default", "ocr-text", "thumbnail", "archive" };
+        for (int qi = 0; qi < num_q; qi++) {
+            jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(q_list[qi]);
+            config.profile = (jpg_profile_t)profile;
+            size_t bytes = 0;
+            int correct = 0, small_correct = 0;
+            for (int i = 0; i < num_frames; i++) {
+                grow_buf_t out = { 0 };
+                if (!fmt2jpg_cb_ex(frames[i].bgr, sizeof(frames[i].bgr), FRAME_W, FRAME_H, PIXFORMAT_RGB888, &config,
+                                   grow_buf_cb, &out)
+                    || !fmt2rgb888(out.buf, out.len, PIXFORMAT_JPEG, decoded)) {
+                    failures++;
+                }
+                bytes += out.len;
+                free(out.buf);
+                for (int g = 0; g < frames[i].count; g++) {
+                    const glyph_t *glyph = &frames[i].glyphs[g];
+                    bool ok = read_digit(glyph, decoded) == glyph->digit;
+                    correct += ok;
+                    small_correct += ok && glyph->h == s_row_heights[0];
+                }
+            }
+            printf("%-10s  %7d   %11zu  %5.1f%%  %5.1f%%\n", names[profile], q_list[qi], bytes / num_frames,
+                   100.0 * correct / total_digits, 100.0 * small_correct / small_digits);
+        }
+    }
+    free(decoded);
+    free(frames);
+    if (failures) {
+        printf("%d encode/decode failure(s)\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * Host benchmark of the JPEG encoder's two forward DCTs.
+ *
+ * A test picture is decoded once and encoded from RGB888 with JPG_DCT_ACCURATE
+ * and JPG_DCT_FAST at qualities 5 to 95. Reported per DCT and quality: encode
+ * time per MCU (16x16 pixels, 6 blocks) in ns and, on x86, in TSC cycles, the
+ * JPEG size and the PSNR of its tjpgd decode against the source.
+ *
+ * Usage: jpeg_dct_bench [--quick] [--min-ms N] [--picture file.jpeg]
+ *   --quick     one iteration per case (used by ctest as a smoke test)
+ *   --min-ms    minimum measuring time per case, default 200 ms
+ *   --picture   source picture, default test/pictures/test_outside.jpeg
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "test_util.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+static double s_min_ms = 200.0;
+static bool s_quick = false;
+
+typedef struct {
+    double ns_per_mcu;
+    double cycles_per_mcu;
+    size_t len;
+    double db;
+} dct_result_t;
+
+static bool run(uint8_t *rgb, int w, int h, int quality, jpg_dct_t dct, dct_result_t *r)
+{
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(quality);
+    config.dct = dct;
+    size_t n = (size_t)w * h * 3;
+    double mcus = (double)((w + 15) / 16) * ((h + 15) / 16);
+    grow_buf_t out = { 0 };
+    int runs = 0;
+    double start = now_ms(), elapsed;
+    uint64_t c0 = cycles();
+    do {
+        out.len = 0;
+        if (!fmt2jpg_cb_ex(rgb, n, w, h, PIXFORMAT_RGB888, &config, grow_buf_cb, &out)) {
+            free(out.buf);
+            return false;
+        }
+        runs++;
+        elapsed = now_ms() - start;
+    } while (!s_quick && (runs < 3 || elapsed < s_min_ms));
+    uint64_t c1 = cycles();
+
+    r->ns_per_mcu = elapsed * 1e6 / runs / mcus;
+    r->cycles_per_mcu = (double)(c1 - c0) / runs / mcus;
+    r->len = out.len;
+    uint8_t *dec = (uint8_t *)malloc(n);
+    bool ok = fmt2rgb888(out.buf, out.len, PIXFORMAT_JPEG, dec);
+    r->db = ok ? psnr(rgb, dec, n) : 0;
+    free(dec);
+    free(out.buf);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    const char *picture = TEST_PICTURES_DIR "/test_outside.jpeg";
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            s_quick = true;
+        } else if (!strcmp(argv[i], "--min-ms") && i + 1 < argc) {
+            s_min_ms = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--picture") && i + 1 < argc) {
+            picture = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--min-ms N] [--picture file.jpeg]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    size_t len;
+    uint8_t *jpg = read_file(picture, &len);
+    int w, h;
+    if (!jpg || !jpeg_size(jpg, len, &w, &h)) {
+        fprintf(stderr, "cannot read %s\n", picture);
+        return 1;
+    }
+    uint8_t *rgb = (uint8_t *)malloc((size_t)w * h * 3);
+    if (!fmt2rgb888(jpg, len, PIXFORMAT_JPEG, rgb)) {
+        fprintf(stderr, "cannot decode %s\n", picture);
+        return 1;
+    }
+    free(jpg);
+
+    printf("%s %dx%d RGB888, %d MCUs%s\n", picture, w, h, ((w + 15) / 16) * ((h + 15) / 16),
+           s_quick ? ", quick" : "");
+    printf("quality | accurate: ns/MCU cyc/MCU   bytes     PSNR | fast: ns/MCU cyc/MCU   bytes     PSNR | speedup\n");
+    int failures = 0;
+    for (int quality = 5; quality <= 95; quality += 10) {
+        dct_result_t a, f;
+        if (!run(rgb, w, h, quality, JPG_DCT_ACCURATE, &a) || !run(rgb, w, h, quality, JPG_DCT_FAST, &f)) {
+            printf("%7d | encode or decode failed\n", quality);
+            failures++;
+            continue;
+        }
+        printf("%7d | %15.0f %7.0f %7zu %5.2f dB | %11.0f %7.0f %7zu %5.2f dB | %6.2fx\n", quality,
+               a.ns_per_mcu, a.cycles_per_mcu, a.len, a.db, f.ns_per_mcu, f.cycles_per_mcu, f.len, f.db,
+               a.ns_per_mcu / f.ns_per_mcu);
+    }
+#if !HAVE_TSC
+    printf("(no cycle counter on this host: cyc/MCU is 0)\n");
+#endif
+    free(rgb);
+    return failures ? 1 : 0;
+}
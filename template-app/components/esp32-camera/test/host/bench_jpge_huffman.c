@@ -0,0 +1,127 @@
+/*
+ * Host benchmark of the JPEG encoder's optimized Huffman tables.
+ *
+ * A test picture is decoded once and encoded from RGB888 (4:2:0) at qualities
+ * 5 to 95, with the standard Huffman tables and with optimize_huffman (one
+ * band each). Reported per quality: encode time per MCU in ns and, on x86,
+ * in TSC cycles, the JPEG sizes, the bytes saved and the time added by the
+ * second pass. The two JPEGs must decode to the same pixels. The host build
+ * limits the symbol store to CONFIG_CAMERA_JPEG_HUFFMAN_STORE_KB (64 KB):
+ * the larger encodes fill it and are partly coded with tables from the top
+ * of the picture only.
+ *
+ * Usage: jpeg_huffman_bench [--quick] [--min-ms N] [--picture file.jpeg]
+ *   --quick     one iteration per case (used by ctest as a smoke test)
+ *   --min-ms    minimum measuring time per case, default 200 ms
+ *   --picture   source picture, default test/pictures/test_outside.jpeg
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "test_util.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+static double s_min_ms = 200.0;
+static bool s_quick = false;
+
+typedef struct {
+    double ns_per_mcu;
+    double cycles_per_mcu;
+    grow_buf_t jpg;
+} huffman_result_t;
+
+static bool run(uint8_t *rgb, int w, int h, int quality, bool optimize, huffman_result_t *r)
+{
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(quality);
+    config.optimize_huffman = optimize;
+    size_t n = (size_t)w * h * 3;
+    double mcus = (double)((w + 15) / 16) * ((h + 15) / 16);
+    int runs = 0;
+    double start = now_ms(), elapsed;
+    uint64_t c0 = cycles();
+    do {
+        r->jpg.len = 0;
+        if (!fmt2jpg_cb_ex(rgb, n, w, h, PIXFORMAT_RGB888, &config, grow_buf_cb, &r->jpg)) {
+            return false;
+        }
+        runs++;
+        elapsed = now_ms() - start;
+    } while (!s_quick && (runs < 3 || elapsed < s_min_ms));
+    uint64_t c1 = cycles();
+
+    r->ns_per_mcu = elapsed * 1e6 / runs / mcus;
+    r->cycles_per_mcu = (double)(c1 - c0) / runs / mcus;
+    return true;
+}
+
+static bool same_pixels(const grow_buf_t *a, const grow_buf_t *b, size_t n)
+{
+    uint8_t *pa = (uint8_t *)malloc(n), *pb = (uint8_t *)malloc(n);
+    bool same = fmt2rgb888(a->buf, a->len, PIXFORMAT_JPEG, pa) && fmt2rgb888(b->buf, b->len, PIXFORMAT_JPEG, pb)
+                && !memcmp(pa, pb, n);
+    free(pa);
+    free(pb);
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    const char *picture = TEST_PICTURES_DIR "/test_outside.jpeg";
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            s_quick = true;
+        } else if (!strcmp(argv[i], "--min-ms") && i + 1 < argc) {
+            s_min_ms = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--picture") && i + 1 < argc) {
+            picture = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--min-ms N] [--picture file.jpeg]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    size_t len;
+    uint8_t *jpg = read_file(picture, &len);
+    int w, h;
+    if (!jpg || !jpeg_size(jpg, len, &w, &h)) {
+        fprintf(stderr, "cannot read %s\n", picture);
+        return 1;
+    }
+    uint8_t *rgb = (uint8_t *)malloc((size_t)w * h * 3);
+    if (!fmt2rgb888(jpg, len, PIXFORMAT_JPEG, rgb)) {
+        fprintf(stderr, "cannot decode %s\n", picture);
+        return 1;
+    }
+    free(jpg);
+
+    printf("%s %dx%d RGB888, %d MCUs, symbol store %d KB%s\n", picture, w, h, ((w + 15) / 16) * ((h + 15) / 16),
+           CONFIG_CAMERA_JPEG_HUFFMAN_STORE_KB, s_quick ? ", quick" : "");
+    printf("quality | standard: ns/MCU cyc/MCU   bytes | optimized: ns/MCU cyc/MCU   bytes | saved   time\n");
+    int failures = 0;
+    for (int quality = 5; quality <= 95; quality += 10) {
+        huffman_result_t s = { 0 }, o = { 0 };
+        if (!run(rgb, w, h, quality, false, &s) || !run(rgb, w, h, quality, true, &o)
+            || !same_pixels(&s.jpg, &o.jpg, (size_t)w * h * 3)) {
+            printf("%7d | encode failed or decoded pixels differ\n", quality);
+            failures++;
+        } else {
+            printf("%7d | %15.0f %7.0f %7zu | %16.0f %7.0f %7zu | %4.1f%% %+5.1f%%\n", quality, s.ns_per_mcu,
+                   s.cycles_per_mcu, s.jpg.len, o.ns_per_mcu, o.cycles_per_mcu, o.jpg.len,
+                   100.0 * (1.0 - (double)o.jpg.len / s.jpg.len), 100.0 * (o.ns_per_mcu / s.ns_per_mcu - 1.0));
+        }
+        free(s.jpg.buf);
+        free(o.jpg.buf);
+    }
+#if !HAVE_TSC
+    printf("(no cycle counter on this host: cyc/MCU is 0)\n");
+#endif
+    free(rgb);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,1046 @@
+/*
+ * Deterministic host simulator for driver/cam_hal.c.
+ *
+ * The real cam_hal.c (cam_task, cam_take, cam_give) runs against the fake
+ * ESP32 ll_cam backend in cam_sim_ll_cam.c and the single-threaded FreeRTOS
+ * in host_freertos.c. This program plays everything else:
+ *
+ *  - the sensor: VSYNC every 1/fps, then the frame's bytes spread evenly over
+ *    the active part of the frame period. JPEG frames are synthetic (or
+ *    replayed from files) and carry their sequence number in a COM segment so
+ *    every delivered frame can be checked byte for byte.
+ *  - the DMA: camera bytes are written into the DMA buffer in the I2S sample
+ *    layout; an EOF event is raised whenever a half buffer fills.
+ *  - cam_task's CPU time: ll_cam_memcpy costs copy_rate, waking up costs
+ *    wake_us, and "busy" windows (WiFi, another task on the same core) keep
+ *    cam_task off the CPU.
+ *  - the application: polls for a frame every poll_ms, holds it for hold_ms,
+ *    then gives it back. With "share" a second consumer takes its own
+ *    reference to each frame and checks it is still intact when it lets go.
+ *
+ * Nothing depends on wall-clock time, so a scenario always gives the same
+ * result. The report covers delivered/dropped frames and why they were lost,
+ * the driver's overflow warnings and queue occupancy; "expect" lines turn a
+ * scenario into a test.
+ *
+ * Usage: cam_sim [-v] scenario.sim... [key=value...]
+ *   key=value lines are applied after the scenario files, e.g.
+ *   cam_sim scenarios/jpeg_vga.sim fb_count=3 jpeg_bytes=20000,30000
+ */
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "esp_camera.h"
+#include "cam_sim.h"
+#include "cam_hal.h"
+#include "host_freertos.h"
+
+#define SIM_MAX_FILES   8
+#define SIM_MAX_FAULTS  64
+#define SIM_MAX_EXPECT  32
+#define SIM_MAX_TALLY   32
+#define SIM_MAX_SCENES  8
+#define SIM_MAX_SHARES  8
+#define SIM_MAX_MSG     128 // an ets_printf message, the longest tally key
+
+typedef enum {
+    FAULT_NOSOI,
+    FAULT_NOEOI,
+    FAULT_NOVSYNC,
+    FAULT_RETURN2,      // the application returns the frame twice
+} fault_kind_t;
+
+typedef struct {
+    int frame;
+    fault_kind_t kind;
+} fault_t;
+
+typedef struct {
+    int frame;              // JPEG sizes from this frame on
+    size_t jpeg_min;
+    size_t jpeg_max;
+} scene_t;
+
+typedef struct {
+    char stat[32];
+    char op[3];
+    double value;
+} expect_t;
+
+typedef struct {
+    pixformat_t format;
+    framesize_t framesize;
+    int fb_count;
+    camera_grab_mode_t grab;
+    double fps;
+    double active;
+    int frames;
+    size_t jpeg_min;
+    size_t jpeg_max;
+    scene_t scenes[SIM_MAX_SCENES];
+    int scene_count;
+    uint8_t *files[SIM_MAX_FILES];
+    size_t file_len[SIM_MAX_FILES];
+    int file_count;
+    int xclk_mhz;
+    double wake_us;
+    double busy_period_us;
+    double busy_us;
+    double poll_us;
+    double hold_us;
+    double share_us;        // second consumer holds a reference this long
+    uint32_t seed;
+    fault_t faults[SIM_MAX_FAULTS];
+    int fault_count;
+    expect_t expects[SIM_MAX_EXPECT];
+    int expect_count;
+} sim_config_t;
+
+typedef struct {
+    char key[SIM_MAX_MSG];
+    char level;
+    uint32_t count;
+} tally_t;
+
+typedef struct {
+    camera_fb_t *fb;
+    int seq;
+    double release;
+} share_t;
+
+typedef struct {
+    double now;             // cam_task clock (us)
+    double world;           // sensor, ISRs and application processed up to here
+    double end;
+    bool in_world;
+    double period;
+
+    // sensor
+    int vsync_next;
+    int frame;              // frame being sent, -1 before the first VSYNC
+    uint8_t *data;
+    size_t len;
+    size_t pos;
+    double data_start;
+    double rate;            // camera bytes per us
+
+    // application
+    camera_fb_t *held;
+    double next_app;
+    uint8_t *seen;
+    share_t shares[SIM_MAX_SHARES];
+    int share_count;
+
+    // results
+    uint32_t vsync_events;
+    uint32_t taken;
+    uint32_t ok;
+    uint32_t bad_len;
+    uint32_t corrupt;
+    uint32_t repeat;
+    uint32_t partial;
+    uint32_t shared;
+    uint32_t share_corrupt;
+    uint32_t share_fail;
+    uint64_t jpeg_bytes;    // fb->len of the ok frames
+    uint64_t chunk_bytes;   // the same frames counted in whole DMA half buffers
+    double latency_sum;
+    double latency_max;
+    double busy_total;
+    tally_t tally[SIM_MAX_TALLY];
+    int tally_count;
+} sim_state_t;
+
+static sim_config_t s_cfg;
+static sim_state_t s_sim;
+static bool s_verbose;
+
+static const struct {
+    const char *name;
+    framesize_t size;
+} s_framesizes[] = {
+    { "96X96", FRAMESIZE_96X96 }, { "QQVGA", FRAMESIZE_QQVGA }, { "QCIF", FRAMESIZE_QCIF },
+    { "HQVGA", FRAMESIZE_HQVGA }, { "240X240", FRAMESIZE_240X240 }, { "QVGA", FRAMESIZE_QVGA },
+    { "CIF", FRAMESIZE_CIF }, { "HVGA", FRAMESIZE_HVGA }, { "VGA", FRAMESIZE_VGA },
+    { "SVGA", FRAMESIZE_SVGA }, { "XGA", FRAMESIZE_XGA }, { "HD", FRAMESIZE_HD },
+    { "SXGA", FRAMESIZE_SXGA }, { "UXGA", FRAMESIZE_UXGA },
+};
+
+static const char *s_format_names[] = {
+    [PIXFORMAT_RGB565] = "rgb565", [PIXFORMAT_YUV422] = "yuv422",
+    [PIXFORMAT_GRAYSCALE] = "grayscale", [PIXFORMAT_JPEG] = "jpeg",
+};
+
+/* ---- driver log messages ---- */
+
+static void tally(char level, const char *key)
+{
+    for (int i = 0; i < s_sim.tally_count; i++) {
+        if (!strcmp(s_sim.tally[i].key, key)) {
+            s_sim.tally[i].count++;
+            return;
+        }
+    }
+    if (s_sim.tally_count < SIM_MAX_TALLY) {
+        tally_t *t = &s_sim.tally[s_sim.tally_count++];
+        snprintf(t->key, sizeof(t->key), "%s", key);
+        t->level = level;
+        t->count = 1;
+    }
+}
+
+static uint32_t tally_count(const char *prefix)
+{
+    uint32_t n = 0;
+    for (int i = 0; i < s_sim.tally_count; i++) {
+        if (!strncmp(s_sim.tally[i].key, prefix, strlen(prefix))) {
+            n += s_sim.tally[i].count;
+        }
+    }
+    return n;
+}
+
+/* warnings and errors are counted by format string, so "FB-SIZE: %u != %u" is one entry */
+void host_log(char level, const char *tag, const char *fmt, ...)
+{
+    if (level != 'I') {
+        tally(level, fmt);
+    }
+    if (s_verbose) {
+        va_list ap;
+        va_start(ap, fmt);
+        fprintf(stderr, "%10.3f ms %c (%s) ", host_time_us() / 1000.0, level, tag);
+        vfprintf(stderr, fmt, ap);
+        fputc('\n', stderr);
+        va_end(ap);
+    }
+}
+
+int ets_printf(const char *fmt, ...)
+{
+    char msg[SIM_MAX_MSG];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    msg[strcspn(msg, "\r\n")] = 0;
+    tally('E', msg);
+    if (s_verbose) {
+        fprintf(stderr, "%10.3f ms %s\n", host_time_us() / 1000.0, msg);
+    }
+    return n;
+}
+
+/* ---- frames ---- */
+
+static uint32_t rng_next(uint32_t *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+static uint32_t frame_rng(int seq)
+{
+    uint32_t x = s_cfg.seed * 2654435761u + (uint32_t)seq * 40503u + 1;
+    for (int i = 0; i < 4; i++) {
+        rng_next(&x);
+    }
+    return x ? x : 1;
+}
+
+static bool has_fault(int seq, fault_kind_t kind)
+{
+    for (int i = 0; i < s_cfg.fault_count; i++) {
+        if (s_cfg.faults[i].frame == seq && s_cfg.faults[i].kind == kind) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* camera bytes of frame seq; returns the length, out may be NULL to only get it */
+static size_t frame_make(int seq, uint8_t *out)
+{
+    uint32_t x = frame_rng(seq);
+
+    if (s_cfg.format != PIXFORMAT_JPEG) {
+        cam_obj_t *cam = g_sim_cam.cam;
+        size_t len = cam->recv_size;
+        if (out) {
+            for (size_t i = 0; i < len; i++) {
+                out[i] = rng_next(&x);
+            }
+            // every byte doubled, so the number survives any of the filters
+            for (int i = 0; i < 4; i++) {
+                out[2 * i] = out[2 * i + 1] = seq >> (8 * i);
+            }
+        }
+        return len;
+    }
+
+    static const uint8_t com[] = { 0xFF, 0xFE, 0x00, 0x06 };
+    // one component scan header, so the entropy coded data follows as in a real frame
+    static const uint8_t sos[] = { 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00 };
+    size_t len;
+    if (s_cfg.file_count) {
+        int f = seq % s_cfg.file_count;
+        len = s_cfg.file_len[f] + sizeof(com) + 4;
+        if (out) {
+            memcpy(out, s_cfg.files[f], 2);
+            memcpy(out + 6 + sizeof(com), s_cfg.files[f] + 2, s_cfg.file_len[f] - 2);
+        }
+    } else {
+        size_t jpeg_min = s_cfg.jpeg_min, jpeg_max = s_cfg.jpeg_max;
+        for (int i = 0; i < s_cfg.scene_count; i++) {
+            if (seq >= s_cfg.scenes[i].frame) {
+                jpeg_min = s_cfg.scenes[i].jpeg_min;
+                jpeg_max = s_cfg.scenes[i].jpeg_max;
+            }
+        }
+        len = jpeg_min + rng_next(&x) % (jpeg_max - jpeg_min + 1);
+        if (out) {
+            out[0] = 0xFF;
+            out[1] = 0xD8;
+            memcpy(out + 2 + sizeof(com) + 4, sos, sizeof(sos));
+            for (size_t i = 2 + sizeof(com) + 4 + sizeof(sos); i < len - 2; i++) {
+                out[i] = rng_next(&x);
+                if (out[i] == 0xFF) {
+                    // stuffed, so no stray markers
+                    if (i + 1 < len - 2) {
+                        out[++i] = 0x00;
+                    } else {
+                        out[i] = 0xFE;
+                    }
+                }
+            }
+            out[len - 2] = 0xFF;
+            out[len - 1] = 0xD9;
+        }
+    }
+    if (out) {
+        memcpy(out + 2, com, sizeof(com));
+        for (int i = 0; i < 4; i++) {
+            out[2 + sizeof(com) + i] = seq >> (8 * i);
+        }
+        if (has_fault(seq, FAULT_NOSOI)) {
+            out[0] = 0;
+        }
+        if (has_fault(seq, FAULT_NOEOI)) {
+            out[len - 2] = out[len - 1] = 0;
+        }
+    }
+    return len;
+}
+
+/* the frame buffer contents cam_take() should return for frame seq */
+static uint8_t *frame_expected(int seq, size_t *len)
+{
+    size_t n = frame_make(seq, NULL);
+    uint8_t *buf = malloc(n);
+    frame_make(seq, buf);
+    cam_obj_t *cam = g_sim_cam.cam;
+    if (s_cfg.format != PIXFORMAT_JPEG && cam->fb_bytes_per_pixel < cam->in_bytes_per_pixel) {
+        for (size_t i = 0; i < n / 2; i++) {
+            buf[i] = buf[2 * i];
+        }
+        n /= 2;
+    }
+    *len = n;
+    return buf;
+}
+
+static int frame_seq(const camera_fb_t *fb)
+{
+    cam_obj_t *cam = g_sim_cam.cam;
+    uint32_t seq = 0;
+    if (s_cfg.format == PIXFORMAT_JPEG) {
+        if (fb->len < 10 || fb->buf[2] != 0xFF || fb->buf[3] != 0xFE) {
+            return -1;
+        }
+        seq = fb->buf[6] | fb->buf[7] << 8 | fb->buf[8] << 16 | (uint32_t)fb->buf[9] << 24;
+    } else {
+        int step = cam->fb_bytes_per_pixel < cam->in_bytes_per_pixel ? 1 : 2;
+        if (fb->len < 8) {
+            return -1;
+        }
+        for (int i = 0; i < 4; i++) {
+            seq |= (uint32_t)fb->buf[i * step] << (8 * i);
+        }
+    }
+    return seq < (uint32_t)s_cfg.frames ? (int)seq : -1;
+}
+
+static void app_check(const camera_fb_t *fb, double t)
+{
+    int seq = frame_seq(fb);
+    s_sim.taken++;
+    if (fb->partial) {
+        // only returned with CONFIG_CAMERA_JPEG_PARTIAL_FRAMES
+        s_sim.partial++;
+        return;
+    }
+    if (seq < 0) {
+        s_sim.corrupt++;
+        return;
+    }
+    size_t len;
+    uint8_t *want = frame_expected(seq, &len);
+    size_t n = fb->len < len ? fb->len : len;
+    if (memcmp(fb->buf, want, n)) {
+        s_sim.corrupt++;
+    } else if (fb->len != len) {
+        s_sim.bad_len++;
+    } else if (s_sim.seen[seq]) {
+        s_sim.repeat++;
+    } else {
+        double latency = t - (seq + 1) * s_sim.period;
+        size_t half = g_sim_cam.cam->dma_half_buffer_size / g_sim_cam.cam->dma_bytes_per_item;
+        s_sim.seen[seq] = 1;
+        s_sim.ok++;
+        s_sim.jpeg_bytes += fb->len;
+        // cam_task counts one more half buffer at VSYNC for the tail of the frame
+        s_sim.chunk_bytes += (fb->len / half + 1) * half;
+        s_sim.latency_sum += latency;
+        if (latency > s_sim.latency_max) {
+            s_sim.latency_max = latency;
+        }
+    }
+    free(want);
+}
+
+/* ---- world: sensor, DMA, application ---- */
+
+enum { W_VSYNC, W_EOF, W_APP, W_SHARE, W_END };
+
+static double world_next(int *what)
+{
+    double t = s_sim.end;
+    *what = W_END;
+    if (s_sim.vsync_next <= s_cfg.frames && s_sim.vsync_next * s_sim.period < t) {
+        t = s_sim.vsync_next * s_sim.period;
+        *what = W_VSYNC;
+    }
+    if (g_sim_cam.capturing && s_sim.frame >= 0 && s_sim.pos < s_sim.len) {
+        size_t need = cam_sim_dma_bytes_to_eof();
+        if (s_sim.pos + need <= s_sim.len) {
+            double te = s_sim.data_start + (s_sim.pos + need) / s_sim.rate;
+            if (te < t) {
+                t = te;
+                *what = W_EOF;
+            }
+        }
+    }
+    if (s_sim.next_app < t) {
+        t = s_sim.next_app;
+        *what = W_APP;
+    }
+    for (int i = 0; i < s_sim.share_count; i++) {
+        if (s_sim.shares[i].release < t) {
+            t = s_sim.shares[i].release;
+            *what = W_SHARE;
+        }
+    }
+    return t < s_sim.world ? s_sim.world : t;
+}
+
+static void sensor_send(size_t upto)
+{
+    if (upto > s_sim.len) {
+        upto = s_sim.len;
+    }
+    if (s_sim.frame >= 0 && upto > s_sim.pos) {
+        cam_sim_dma_write(s_sim.data + s_sim.pos, upto - s_sim.pos);
+        s_sim.pos = upto;
+    }
+}
+
+static void sensor_send_until(double t)
+{
+    double sent = (t - s_sim.data_start) * s_sim.rate;
+    if (sent > 0) {
+        sensor_send((size_t)(sent + 1e-6));
+    }
+}
+
+static void sensor_vsync(double t)
+{
+    int k = s_sim.vsync_next++;
+    sensor_send(s_sim.len);
+    if (k < s_cfg.frames) {
+        free(s_sim.data);
+        s_sim.len = frame_make(k, NULL);
+        s_sim.data = malloc(s_sim.len);
+        frame_make(k, s_sim.data);
+        s_sim.frame = k;
+        s_sim.pos = 0;
+        // blanking on both sides of the active lines
+        s_sim.data_start = t + (1.0 - s_cfg.active) * s_sim.period / 2;
+        s_sim.rate = s_sim.len / (s_cfg.active * s_sim.period);
+    }
+    if (g_sim_cam.vsync_intr && !has_fault(k, FAULT_NOVSYNC)) {
+        BaseType_t woken = pdFALSE;
+        s_sim.vsync_events++;
+        ll_cam_send_event(g_sim_cam.cam, CAM_VSYNC_EVENT, &woken);
+    }
+}
+
+/* second consumer: keeps a reference to good frames and checks them when it lets go */
+static void share_take(camera_fb_t *fb, double t)
+{
+    int seq = frame_seq(fb);
+    if (s_cfg.share_us <= 0 || fb->partial || seq < 0 || s_sim.share_count == SIM_MAX_SHARES) {
+        return;
+    }
+    if (!cam_ref(fb)) {
+        s_sim.share_fail++;
+        return;
+    }
+    s_sim.shares[s_sim.share_count++] = (share_t) {
+        .fb = fb, .seq = seq, .release = t + s_cfg.share_us,
+    };
+    s_sim.shared++;
+}
+
+static void share_release(double t)
+{
+    for (int i = 0; i < s_sim.share_count;) {
+        share_t *sh = &s_sim.shares[i];
+        if (sh->release > t) {
+            i++;
+            continue;
+        }
+        size_t len;
+        uint8_t *want = frame_expected(sh->seq, &len);
+        // the driver must not have reused the buffer while it was referenced
+        if (sh->fb->len != len || memcmp(sh->fb->buf, want, len)) {
+            s_sim.share_corrupt++;
+        }
+        free(want);
+        cam_give(sh->fb);
+        *sh = s_sim.shares[--s_sim.share_count];
+    }
+}
+
+static void app_run(double t)
+{
+    if (s_sim.held) {
+        int seq = frame_seq(s_sim.held);
+        cam_give(s_sim.held);
+        if (seq >= 0 && has_fault(seq, FAULT_RETURN2)) {
+            cam_give(s_sim.held);
+        }
+        s_sim.held = NULL;
+    }
+    if (cam_fb_ring_count(&g_sim_cam.cam->frame_ring)) {
+        camera_fb_t *fb = cam_take(0);
+        if (fb) {
+            app_check(fb, t);
+            share_take(fb, t);
+            s_sim.held = fb;
+            if (s_cfg.hold_us > 0) {
+                s_sim.next_app = t + s_cfg.hold_us;
+                return;
+            }
+        }
+    }
+    s_sim.next_app = (floor(t / s_cfg.poll_us) + 1) * s_cfg.poll_us;
+}
+
+static void world_step(double t, int what)
+{
+    host_time_set(llround(t));
+    if (what == W_EOF) {
+        sensor_send(s_sim.pos + cam_sim_dma_bytes_to_eof());
+    } else {
+        sensor_send_until(t);
+    }
+    if (what == W_VSYNC) {
+        sensor_vsync(t);
+    } else if (what == W_APP) {
+        app_run(t);
+    } else if (what == W_SHARE) {
+        share_release(t);
+    }
+    s_sim.world = t;
+}
+
+/* cam_task can't run inside a busy window; returns when it gets the CPU back */
+static double task_ready(double t)
+{
+    if (s_cfg.busy_us <= 0) {
+        return t;
+    }
+    double start = floor(t / s_cfg.busy_period_us) * s_cfg.busy_period_us;
+    return t < start + s_cfg.busy_us ? start + s_cfg.busy_us : t;
+}
+
+void cam_sim_task_busy(double us)
+{
+    double t = task_ready(s_sim.now);
+    s_sim.busy_total += us;
+    while (s_cfg.busy_us > 0) {
+        double next = (floor(t / s_cfg.busy_period_us) + 1) * s_cfg.busy_period_us;
+        if (t + us <= next) {
+            break;
+        }
+        us -= next - t;
+        t = next + s_cfg.busy_us;
+    }
+    s_sim.now = t + us;
+}
+
+void cam_sim_sync(void)
+{
+    if (s_sim.in_world) {
+        return;
+    }
+    s_sim.in_world = true;
+    int what;
+    double t;
+    while ((t = world_next(&what)) <= s_sim.now && what != W_END) {
+        world_step(t, what);
+    }
+    if (s_sim.now > s_sim.world) {
+        world_step(s_sim.now, -1);
+    }
+    host_time_set(llround(s_sim.now));
+    s_sim.in_world = false;
+}
+
+/* cam_task waits for an event: run the world until one is queued */
+static bool sim_block(void *ctx, QueueHandle_t q)
+{
+    if (!g_sim_cam.cam || q != g_sim_cam.cam->event_queue) {
+        return false;
+    }
+    s_sim.in_world = true;
+    int what;
+    double t;
+    bool woke = false;
+    while ((t = world_next(&what)), what != W_END) {
+        world_step(t, what);
+        if (uxQueueMessagesWaiting(q)) {
+            s_sim.now = task_ready(t + s_cfg.wake_us);
+            woke = true;
+            break;
+        }
+    }
+    if (!woke) {
+        world_step(s_sim.end, -1);
+        s_sim.now = s_sim.end;
+    }
+    s_sim.in_world = false;
+    return woke;
+}
+
+static void sim_sync_hook(void *ctx)
+{
+    cam_sim_sync();
+}
+
+/* ---- scenario files ---- */
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = n > 4 ? malloc(n) : NULL;
+    if (buf && fread(buf, 1, n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = n;
+    return buf;
+}
+
+static bool parse_line(char *line, const char *dir, const char *where)
+{
+    char *argv[8];
+    int argc = 0;
+    line[strcspn(line, "#\r\n")] = 0;
+    for (char *tok = strtok(line, " \t"); tok && argc < 8; tok = strtok(NULL, " \t")) {
+        argv[argc++] = tok;
+    }
+    if (argc == 0) {
+        return true;
+    }
+
+    const char *key = argv[0];
+    if (!strcmp(key, "format") && argc == 2) {
+        for (size_t i = 0; i < sizeof(s_format_names) / sizeof(s_format_names[0]); i++) {
+            if (s_format_names[i] && !strcmp(argv[1], s_format_names[i])) {
+                s_cfg.format = (pixformat_t)i;
+                return true;
+            }
+        }
+    } else if (!strcmp(key, "framesize") && argc == 2) {
+        for (size_t i = 0; i < sizeof(s_framesizes) / sizeof(s_framesizes[0]); i++) {
+            if (!strcasecmp(argv[1], s_framesizes[i].name)) {
+                s_cfg.framesize = s_framesizes[i].size;
+                return true;
+            }
+        }
+    } else if (!strcmp(key, "fb_count") && argc == 2) {
+        s_cfg.fb_count = atoi(argv[1]);
+        return s_cfg.fb_count > 0;
+    } else if (!strcmp(key, "grab") && argc == 2) {
+        s_cfg.grab = !strcmp(argv[1], "latest") ? CAMERA_GRAB_LATEST : CAMERA_GRAB_WHEN_EMPTY;
+        return true;
+    } else if (!strcmp(key, "fps") && argc == 2) {
+        s_cfg.fps = atof(argv[1]);
+        return s_cfg.fps > 0;
+    } else if (!strcmp(key, "active") && argc == 2) {
+        s_cfg.active = atof(argv[1]);
+        return s_cfg.active > 0 && s_cfg.active <= 1;
+    } else if (!strcmp(key, "frames") && argc == 2) {
+        s_cfg.frames = atoi(argv[1]);
+        return s_cfg.frames > 0;
+    } else if (!strcmp(key, "jpeg_bytes") && (argc == 2 || argc == 3)) {
+        s_cfg.jpeg_min = strtoul(argv[1], NULL, 0);
+        s_cfg.jpeg_max = argc == 3 ? strtoul(argv[2], NULL, 0) : s_cfg.jpeg_min;
+        return s_cfg.jpeg_min >= 22 && s_cfg.jpeg_max >= s_cfg.jpeg_min;
+    } else if (!strcmp(key, "scene") && argc == 4 && s_cfg.scene_count < SIM_MAX_SCENES) {
+        scene_t *sc = &s_cfg.scenes[s_cfg.scene_count++];
+        sc->frame = atoi(argv[1]);
+        sc->jpeg_min = strtoul(argv[2], NULL, 0);
+        sc->jpeg_max = strtoul(argv[3], NULL, 0);
+        return sc->jpeg_min >= 22 && sc->jpeg_max >= sc->jpeg_min;
+    } else if (!strcmp(key, "jpeg_file") && argc == 2 && s_cfg.file_count < SIM_MAX_FILES) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s%s", argv[1][0] == '/' ? "" : dir, argv[1]);
+        int f = s_cfg.file_count;
+        s_cfg.files[f] = read_file(path, &s_cfg.file_len[f]);
+        if (!s_cfg.files[f] || s_cfg.files[f][0] != 0xFF || s_cfg.files[f][1] != 0xD8) {
+            fprintf(stderr, "%s: can't read JPEG %s\n", where, path);
+            return false;
+        }
+        s_cfg.file_count++;
+        return true;
+    } else if (!strcmp(key, "jpeg_fb_size") && argc == 2) {
+        g_sim_cam.jpeg_fb_size = strtoul(argv[1], NULL, 0);
+        return true;
+    } else if (!strcmp(key, "dma_max") && argc == 2) {
+        g_sim_cam.dma_buffer_max = strtoul(argv[1], NULL, 0);
+        return g_sim_cam.dma_buffer_max >= 8192;
+    } else if (!strcmp(key, "filter") && argc == 2) {
+        g_sim_cam.word_filter = !strcmp(argv[1], "word");
+        return g_sim_cam.word_filter || !strcmp(argv[1], "byte");
+    } else if (!strcmp(key, "xclk") && argc == 2) {
+        s_cfg.xclk_mhz = atoi(argv[1]);
+        return s_cfg.xclk_mhz > 0;
+    } else if (!strcmp(key, "psram") && argc == 2) {
+        g_sim_cam.psram = atoi(argv[1]) != 0;
+        return true;
+    } else if (!strcmp(key, "adaptive") && argc == 2) {
+        g_sim_cam.adaptive = atoi(argv[1]) != 0;
+        return true;
+    } else if (!strcmp(key, "copy_rate") && argc == 2) {
+        g_sim_cam.copy_bytes_per_us = atof(argv[1]);
+        return g_sim_cam.copy_bytes_per_us > 0;
+    } else if (!strcmp(key, "wake_us") && argc == 2) {
+        s_cfg.wake_us = atof(argv[1]);
+        return true;
+    } else if (!strcmp(key, "busy") && argc == 3) {
+        s_cfg.busy_period_us = atof(argv[1]) * 1000;
+        s_cfg.busy_us = atof(argv[2]);
+        return s_cfg.busy_us == 0 || (s_cfg.busy_period_us > s_cfg.busy_us && s_cfg.busy_us > 0);
+    } else if (!strcmp(key, "consumer") && argc == 3) {
+        s_cfg.poll_us = atof(argv[1]) * 1000;
+        s_cfg.hold_us = atof(argv[2]) * 1000;
+        return s_cfg.poll_us > 0;
+    } else if (!strcmp(key, "share") && argc == 2) {
+        s_cfg.share_us = atof(argv[1]) * 1000;
+        return s_cfg.share_us >= 0;
+    } else if (!strcmp(key, "fault") && argc == 3 && s_cfg.fault_count < SIM_MAX_FAULTS) {
+        fault_t *f = &s_cfg.faults[s_cfg.fault_count];
+        f->frame = atoi(argv[1]);
+        if (!strcmp(argv[2], "nosoi")) {
+            f->kind = FAULT_NOSOI;
+        } else if (!strcmp(argv[2], "noeoi")) {
+            f->kind = FAULT_NOEOI;
+        } else if (!strcmp(argv[2], "novsync")) {
+            f->kind = FAULT_NOVSYNC;
+        } else if (!strcmp(argv[2], "return2")) {
+            f->kind = FAULT_RETURN2;
+        } else {
+            goto bad;
+        }
+        s_cfg.fault_count++;
+        return true;
+    } else if (!strcmp(key, "seed") && argc == 2) {
+        s_cfg.seed = strtoul(argv[1], NULL, 0);
+        return true;
+    } else if (!strcmp(key, "expect") && argc == 4 && s_cfg.expect_count < SIM_MAX_EXPECT) {
+        expect_t *e = &s_cfg.expects[s_cfg.expect_count++];
+        snprintf(e->stat, sizeof(e->stat), "%s", argv[1]);
+        snprintf(e->op, sizeof(e->op), "%s", argv[2]);
+        e->value = atof(argv[3]);
+        return true;
+    }
+bad:
+    fprintf(stderr, "%s: bad line '%s'\n", where, key);
+    return false;
+}
+
+static bool parse_file(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "can't open %s\n", path);
+        return false;
+    }
+    char dir[512] = "";
+    const char *slash = strrchr(path, '/');
+    if (slash) {
+        snprintf(dir, sizeof(dir), "%.*s/", (int)(slash - path), path);
+    }
+    char line[512], where[600];
+    bool ok = true;
+    for (int n = 1; ok && fgets(line, sizeof(line), f); n++) {
+        snprintf(where, sizeof(where), "%s:%d", path, n);
+        ok = parse_line(line, dir, where);
+    }
+    fclose(f);
+    return ok;
+}
+
+/* ---- report ---- */
+
+static bool stat_value(const char *name, double *v)
+{
+    const cam_obj_t *cam = g_sim_cam.cam;
+    camera_fb_stats_t fbs;
+    camera_latency_stats_t lat[CAMERA_LATENCY_STAGE_MAX];
+    cam_get_fb_stats(&fbs);
+    for (int stage = 0; stage < CAMERA_LATENCY_STAGE_MAX; stage++) {
+        cam_get_latency_stats(stage, &lat[stage]);
+    }
+    const struct {
+        const char *name;
+        double value;
+    } stats[] = {
+        { "ok", s_sim.ok },
+        { "dropped", s_cfg.frames - s_sim.ok },
+        { "taken", s_sim.taken },
+        { "bad_len", s_sim.bad_len },
+        { "corrupt", s_sim.corrupt },
+        { "repeat", s_sim.repeat },
+        { "shared", s_sim.shared },
+        { "share_corrupt", s_sim.share_corrupt },
+        { "share_fail", s_sim.share_fail },
+        { "fb_misuse", tally_count("FB-RET") + tally_count("FB-REF") },
+        { "partial", s_sim.partial },
+        { "pad_pct", s_sim.chunk_bytes ? 100.0 * (s_sim.chunk_bytes - s_sim.jpeg_bytes) / s_sim.chunk_bytes : 0 },
+        { "evicted", cam->frame_ring.evicted },
+        { "vsync", s_sim.vsync_events },
+        { "no_soi", tally_count("NO-SOI") },
+        { "no_eoi", tally_count("NO-EOI") },
+        { "fb_ovf", tally_count("FB-OVF") },
+        { "fb_size", tally_count("FB-SIZE") },
+        { "fb_overflows", fbs.overflows },
+        { "fb_resizes", fbs.resizes },
+        { "fb_total_kb", fbs.fb_total / 1024.0 },
+        { "fbq_err", tally_count("FBQ-") },
+        { "ev_ovf", tally_count("cam_hal: EV-") },
+        { "event_q_high", host_queue_stats(cam->event_queue)->high_water },
+        { "frame_q_high", cam->frame_ring.high_water },
+        { "latency_max_ms", s_sim.latency_max / 1000 },
+        { "capture_p50_ms", lat[CAMERA_LATENCY_CAPTURE].p50_us / 1000.0 },
+        { "capture_p99_ms", lat[CAMERA_LATENCY_CAPTURE].p99_us / 1000.0 },
+        { "deliver_p99_ms", lat[CAMERA_LATENCY_DELIVER].p99_us / 1000.0 },
+        { "wait_p99_ms", lat[CAMERA_LATENCY_WAIT].p99_us / 1000.0 },
+        { "busy_pct", 100 * s_sim.busy_total / s_sim.end },
+    };
+    for (size_t i = 0; i < sizeof(stats) / sizeof(stats[0]); i++) {
+        if (!strcmp(name, stats[i].name)) {
+            *v = stats[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void report(void)
+{
+    cam_obj_t *cam = g_sim_cam.cam;
+    const host_queue_stats_t *eq = host_queue_stats(cam->event_queue);
+    double v;
+
+    printf("cam_sim: %s %ux%u, %.1f fps, %d frames, fb_count %d (%s), fb %u B, DMA %u x %u B, %s\n",
+           s_format_names[s_cfg.format], cam->width, cam->height, s_cfg.fps, s_cfg.frames, s_cfg.fb_count,
+           s_cfg.grab == CAMERA_GRAB_LATEST ? "latest" : "when_empty", (unsigned)cam->fb_size,
+           (unsigned)cam->dma_half_buffer_cnt, (unsigned)cam->dma_half_buffer_size,
+           cam->psram_mode ? "PSRAM mode" : g_sim_cam.word_filter ? "word filter" : "byte filter");
+    stat_value("evicted", &v);
+    printf("  frames   sensor %d, delivered ok %u (%.1f fps), dropped %d\n",
+           s_cfg.frames, s_sim.ok, s_sim.ok / (s_cfg.frames * s_sim.period) * 1e6, s_cfg.frames - (int)s_sim.ok);
+    printf("  app      taken %u: ok %u, bad_len %u, corrupt %u, repeat %u, partial %u; evicted by driver %u, left queued %u\n",
+           s_sim.taken, s_sim.ok, s_sim.bad_len, s_sim.corrupt, s_sim.repeat, s_sim.partial, (unsigned)v,
+           (unsigned)cam_fb_ring_count(&cam->frame_ring));
+    if (s_cfg.share_us > 0) {
+        printf("  shared   %u frames referenced by a second consumer for %.0f ms: corrupt %u, ref failed %u\n",
+               s_sim.shared, s_cfg.share_us / 1000, s_sim.share_corrupt, s_sim.share_fail);
+    }
+    if (s_cfg.format == PIXFORMAT_JPEG && s_sim.ok) {
+        stat_value("pad_pct", &v);
+        printf("  jpeg     ok frames %.1f KB, %.1f KB in DMA half buffers: %.1f KB (%.1f %%) of padding not returned\n",
+               s_sim.jpeg_bytes / 1e3, s_sim.chunk_bytes / 1e3, (s_sim.chunk_bytes - s_sim.jpeg_bytes) / 1e3, v);
+    }
+    if (s_sim.ok) {
+        printf("  latency  frame end -> app: avg %.2f ms, max %.2f ms\n",
+               s_sim.latency_sum / s_sim.ok / 1000, s_sim.latency_max / 1000);
+        static const char *stages[] = { "capture", "deliver", "wait" };
+        printf("  stages  ");
+        for (int stage = 0; stage < CAMERA_LATENCY_STAGE_MAX; stage++) {
+            camera_latency_stats_t lat;
+            cam_get_latency_stats(stage, &lat);
+            printf(" %s p50 %.2f / p99 %.2f ms%s", stages[stage], lat.p50_us / 1000.0, lat.p99_us / 1000.0,
+                   stage + 1 < CAMERA_LATENCY_STAGE_MAX ? "," : "\n");
+        }
+    }
+    printf("  events   vsync %u, event queue %u deep: high-water %u, avg %.2f, full %u\n",
+           s_sim.vsync_events, (unsigned)(cam->dma_half_buffer_cnt > 1 ? cam->dma_half_buffer_cnt - 1 : 1),
+           eq->high_water, host_queue_avg_occupancy(cam->event_queue), eq->send_fails);
+    printf("  frame q  %s, %u frames handed over, high-water %u\n", cam->frame_ring.latest ? "latest slot" : "ring",
+           (unsigned)cam->frame_ring.pushed, (unsigned)cam->frame_ring.high_water);
+    if (s_cfg.format == PIXFORMAT_JPEG) {
+        camera_fb_stats_t fbs;
+        cam_get_fb_stats(&fbs);
+        printf("  fb size  p50 %u, p90 %u, p99 %u, max %u B; %u overflows; now %u B%s, %u resizes, %.1f KB in all buffers\n",
+               (unsigned)fbs.p50, (unsigned)fbs.p90, (unsigned)fbs.p99, (unsigned)fbs.max, (unsigned)fbs.overflows,
+               (unsigned)fbs.fb_size, cam->jpeg_fb_adaptive ? " (adaptive)" : "", (unsigned)fbs.resizes, fbs.fb_total / 1024.0);
+    }
+    printf("  cam_task busy %.1f %% (%.1f MB through ll_cam_memcpy), %u DMA starts\n",
+           100 * s_sim.busy_total / s_sim.end, g_sim_cam.copied / 1e6, g_sim_cam.starts);
+    for (int i = 0; i < s_sim.tally_count; i++) {
+        printf("  %6u x %c %s\n", s_sim.tally[i].count, s_sim.tally[i].level, s_sim.tally[i].key);
+    }
+}
+
+static bool check_expectations(void)
+{
+    bool ok = true;
+    for (int i = 0; i < s_cfg.expect_count; i++) {
+        const expect_t *e = &s_cfg.expects[i];
+        double v;
+        bool pass;
+        if (!stat_value(e->stat, &v)) {
+            printf("FAIL unknown stat %s\n", e->stat);
+            ok = false;
+            continue;
+        }
+        if (!strcmp(e->op, "==")) {
+            pass = v == e->value;
+        } else if (!strcmp(e->op, "!=")) {
+            pass = v != e->value;
+        } else if (!strcmp(e->op, "<")) {
+            pass = v < e->value;
+        } else if (!strcmp(e->op, "<=")) {
+            pass = v <= e->value;
+        } else if (!strcmp(e->op, ">")) {
+            pass = v > e->value;
+        } else if (!strcmp(e->op, ">=")) {
+            pass = v >= e->value;
+        } else {
+            printf("FAIL unknown operator %s\n", e->op);
+            ok = false;
+            continue;
+        }
+        if (!pass) {
+            printf("FAIL expect %s %s %g (got %g)\n", e->stat, e->op, e->value, v);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    s_cfg = (sim_config_t) {
+        .format = PIXFORMAT_JPEG,
+        .framesize = FRAMESIZE_VGA,
+        .fb_count = 2,
+        .grab = CAMERA_GRAB_LATEST,
+        .fps = 25,
+        .active = 0.8,
+        .frames = 100,
+        .jpeg_min = 8000,
+        .jpeg_max = 16000,
+        .xclk_mhz = 20,
+        .wake_us = 20,
+        .poll_us = 1000,
+        .seed = 1,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            s_verbose = true;
+        } else if (strchr(argv[i], '=')) {
+            char line[256];
+            snprintf(line, sizeof(line), "%s", argv[i]);
+            for (char *p = line; *p; p++) {
+                if (*p == '=' || *p == ',') {
+                    *p = ' ';
+                }
+            }
+            if (!parse_line(line, "", argv[i])) {
+                return 2;
+            }
+        } else if (!parse_file(argv[i])) {
+            return 2;
+        }
+    }
+
+    camera_config_t config = {
+        .pin_vsync = 25,
+        .xclk_freq_hz = s_cfg.xclk_mhz * 1000000,
+        .pixel_format = s_cfg.format,
+        .frame_size = s_cfg.framesize,
+        .fb_count = s_cfg.fb_count,
+        .fb_location = CAMERA_FB_IN_PSRAM,
+        .grab_mode = s_cfg.grab,
+    };
+    host_freertos_hooks_t hooks = {
+        .sync = sim_sync_hook,
+        .block = sim_block,
+    };
+    host_freertos_set_hooks(&hooks);
+
+    if (cam_init(&config) != ESP_OK || cam_config(&config, s_cfg.framesize, OV2640_PID) != ESP_OK) {
+        fprintf(stderr, "cam_init/cam_config failed\n");
+        return 2;
+    }
+
+    s_sim.period = 1e6 / s_cfg.fps;
+    s_sim.end = (s_cfg.frames + 2) * s_sim.period + s_cfg.hold_us;
+    s_sim.frame = -1;
+    s_sim.next_app = s_cfg.poll_us;
+    s_sim.seen = calloc(s_cfg.frames, 1);
+    s_sim.now = s_sim.world = 0;
+
+    cam_start();
+    host_task_run(g_sim_cam.cam->task_handle);
+
+    report();
+    bool ok = check_expectations();
+
+    cam_deinit();
+    free(s_sim.data);
+    free(s_sim.seen);
+    for (int i = 0; i < s_cfg.file_count; i++) {
+        free(s_cfg.files[i]);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+/*
+ * cam_hal host simulator: state shared between the fake ll_cam backend
+ * (cam_sim_ll_cam.c) and the simulator (cam_sim.c).
+ *
+ * The fake backend behaves like target/esp32/ll_cam.c without the registers:
+ * the same DMA buffer sizes, the same I2S sample layout in the DMA buffer
+ * (dma_elem_t) and the same DMA filters. With psram set it plays the
+ * ESP32-S3 in JPEG PSRAM mode instead, where the DMA stores camera bytes
+ * straight into the frame buffer in 1 KiB chunks. The simulator plays the sensor: it
+ * feeds camera bytes through cam_sim_dma_write(), which raises the DMA EOF
+ * events, and raises VSYNC itself.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ll_cam.h"
+#include "ll_cam_dma_filter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    /* knobs, set before cam_config() */
+    size_t jpeg_fb_size;        // JPEG frame buffer size, 0 keeps the driver's choice
+    size_t dma_buffer_max;      // CONFIG_CAMERA_DMA_BUFFER_SIZE_MAX
+    bool word_filter;           // CONFIG_CAMERA_DMA_FILTER_WORD
+    double copy_bytes_per_us;   // cam_task cost of ll_cam_memcpy, in DMA bytes per microsecond
+    bool psram;                 // play the ESP32-S3 JPEG PSRAM mode: the DMA writes the frame buffer directly
+    bool adaptive;              // CONFIG_CAMERA_JPEG_FB_ADAPTIVE (compiled in, off unless set)
+
+    /* backend state */
+    cam_obj_t *cam;
+    dma_filter_t filter;
+    bool vsync_intr;            // VSYNC interrupt enabled (cam_start / cam_stop)
+    bool capturing;             // between ll_cam_start() and ll_cam_stop()
+    size_t dma_pos;             // DMA bytes written since ll_cam_start()
+    int frame_pos;              // frame buffer the DMA writes in PSRAM mode
+    uint32_t starts;
+    uint64_t copied;            // DMA bytes passed through ll_cam_memcpy()
+} cam_sim_ll_cam_t;
+
+extern cam_sim_ll_cam_t g_sim_cam;
+
+/* camera bytes until the DMA raises the next EOF (half buffer full) */
+size_t cam_sim_dma_bytes_to_eof(void);
+
+/* the sensor sends len camera bytes; only stored while capturing */
+void cam_sim_dma_write(const uint8_t *data, size_t len);
+
+/* implemented by the simulator */
+void cam_sim_sync(void);            // bring ISRs and the application up to cam_task's time
+void cam_sim_task_busy(double us);  // cam_task spends us of CPU time
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,259 @@
+/*
+ * Fake ESP32 ll_cam backend for the cam_hal host simulator.
+ *
+ * Buffer sizing, sample modes and DMA filters follow target/esp32/ll_cam.c;
+ * the I2S/GPIO register accesses are replaced by the simulator's state.
+ */
+#include <string.h>
+
+#include "cam_sim.h"
+
+static const char *TAG = "sim ll_cam";
+
+cam_sim_ll_cam_t g_sim_cam = {
+    .dma_buffer_max = 32768,
+    .word_filter = true,
+    .copy_bytes_per_us = 40.0,
+};
+
+typedef enum {
+    SM_0A0B_0B0C = 0,
+    SM_0A0B_0C0D = 1,
+    SM_0A00_0B00 = 3,
+} i2s_sampling_mode_t;
+
+static i2s_sampling_mode_t sampling_mode = SM_0A00_0B00;
+
+#define DMA_FILTER(name) (g_sim_cam.word_filter ? ll_cam_dma_filter_##name##_word : ll_cam_dma_filter_##name)
+
+size_t cam_sim_dma_bytes_to_eof(void)
+{
+    cam_obj_t *cam = g_sim_cam.cam;
+    size_t left = cam->dma_half_buffer_size - g_sim_cam.dma_pos % cam->dma_half_buffer_size;
+    return (left + cam->dma_bytes_per_item - 1) / cam->dma_bytes_per_item;
+}
+
+void cam_sim_dma_write(const uint8_t *data, size_t len)
+{
+    cam_obj_t *cam = g_sim_cam.cam;
+    if (cam->psram_mode) {
+        uint8_t *fb = cam->frames[g_sim_cam.frame_pos].fb.buf;
+        for (size_t i = 0; i < len && g_sim_cam.capturing; i++) {
+            // the descriptors form a ring over the frame buffer
+            fb[g_sim_cam.dma_pos % (cam->dma_node_cnt * cam->dma_node_buffer_size)] = data[i];
+            if (++g_sim_cam.dma_pos % cam->dma_half_buffer_size == 0) {
+                BaseType_t woken = pdFALSE;
+                ll_cam_send_event(cam, CAM_IN_SUC_EOF_EVENT, &woken);
+            }
+        }
+        return;
+    }
+    for (size_t i = 0; i < len && g_sim_cam.capturing; i++) {
+        dma_elem_t *el = (dma_elem_t *)&cam->dma_buffer[(g_sim_cam.dma_pos % cam->dma_buffer_size) & ~3u];
+        if (cam->dma_bytes_per_item == 4 || (g_sim_cam.dma_pos & 3) == 0) {
+            // 00 s1 00 00 / first half of 00 s1 00 s2
+            el->val = 0;
+            el->sample1 = data[i];
+        } else {
+            el->sample2 = data[i];
+        }
+        g_sim_cam.dma_pos += cam->dma_bytes_per_item;
+        if (g_sim_cam.dma_pos % cam->dma_half_buffer_size == 0) {
+            BaseType_t woken = pdFALSE;
+            ll_cam_send_event(cam, CAM_IN_SUC_EOF_EVENT, &woken);
+        }
+    }
+}
+
+bool ll_cam_stop(cam_obj_t *cam)
+{
+    cam_sim_sync();
+    g_sim_cam.capturing = false;
+    return true;
+}
+
+bool ll_cam_start(cam_obj_t *cam, int frame_pos)
+{
+    cam_sim_sync();
+    g_sim_cam.capturing = true;
+    g_sim_cam.dma_pos = 0;
+    g_sim_cam.frame_pos = frame_pos;
+    g_sim_cam.starts++;
+    return true;
+}
+
+esp_err_t ll_cam_config(cam_obj_t *cam, const camera_config_t *config)
+{
+    g_sim_cam.cam = cam;
+    return ESP_OK;
+}
+
+esp_err_t ll_cam_deinit(cam_obj_t *cam)
+{
+    g_sim_cam.cam = NULL;
+    return ESP_OK;
+}
+
+void ll_cam_vsync_intr_enable(cam_obj_t *cam, bool en)
+{
+    g_sim_cam.vsync_intr = en;
+}
+
+esp_err_t ll_cam_set_pin(cam_obj_t *cam, const camera_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t ll_cam_init_isr(cam_obj_t *cam)
+{
+    return ESP_OK;
+}
+
+void ll_cam_do_vsync(cam_obj_t *cam)
+{
+}
+
+uint8_t ll_cam_get_dma_align(cam_obj_t *cam)
+{
+    return cam->psram_mode ? 16 : 0;
+}
+
+static bool ll_cam_calc_rgb_dma(cam_obj_t *cam){
+    size_t dma_half_buffer_max = g_sim_cam.dma_buffer_max / 2 / cam->dma_bytes_per_item;
+    size_t dma_buffer_max = 2 * dma_half_buffer_max;
+    size_t node_max = LCD_CAM_DMA_NODE_BUFFER_MAX_SIZE / cam->dma_bytes_per_item;
+
+    size_t line_width = cam->width * cam->in_bytes_per_pixel;
+    size_t image_size = cam->height * line_width;
+    if (image_size > (4 * 1024 * 1024) || (line_width > dma_half_buffer_max)) {
+        ESP_LOGE(TAG, "Resolution too high");
+        return 0;
+    }
+
+    size_t node_size = node_max;
+    size_t nodes_per_line = 1;
+    size_t lines_per_node = 1;
+    size_t lines_per_half_buffer = 1;
+    size_t dma_half_buffer_min = node_max;
+    size_t dma_half_buffer = dma_half_buffer_max;
+    size_t dma_buffer_size = dma_buffer_max;
+
+    if(line_width >= node_max){
+        for(size_t i = node_max; i > 0; i=i-1){
+            if ((line_width % i) == 0) {
+                node_size = i;
+                nodes_per_line = line_width / node_size;
+                break;
+            }
+        }
+    } else {
+        for(size_t i = node_max; i > 0; i=i-1){
+            if ((i % line_width) == 0) {
+                node_size = i;
+                lines_per_node = node_size / line_width;
+                while((cam->height % lines_per_node) != 0){
+                    lines_per_node = lines_per_node - 1;
+                    node_size = lines_per_node * line_width;
+                }
+                break;
+            }
+        }
+    }
+    dma_half_buffer_min = node_size * nodes_per_line;
+    dma_half_buffer = (dma_half_buffer_max / dma_half_buffer_min) * dma_half_buffer_min;
+    lines_per_half_buffer = dma_half_buffer / line_width;
+    while((cam->height % lines_per_half_buffer) != 0){
+        dma_half_buffer = dma_half_buffer - dma_half_buffer_min;
+        lines_per_half_buffer = dma_half_buffer / line_width;
+    }
+    dma_buffer_size =(dma_buffer_max / dma_half_buffer) * dma_half_buffer;
+
+    cam->dma_buffer_size = dma_buffer_size * cam->dma_bytes_per_item;
+    cam->dma_half_buffer_size = dma_half_buffer * cam->dma_bytes_per_item;
+    cam->dma_node_buffer_size = node_size * cam->dma_bytes_per_item;
+    cam->dma_half_buffer_cnt = cam->dma_buffer_size / cam->dma_half_buffer_size;
+    return 1;
+}
+
+bool ll_cam_dma_sizes(cam_obj_t *cam)
+{
+    cam->dma_bytes_per_item = sampling_mode == SM_0A0B_0C0D ? 2 : 4;
+    if (cam->jpeg_mode) {
+        if (g_sim_cam.jpeg_fb_size) {
+            cam->recv_size = cam->fb_size = g_sim_cam.jpeg_fb_size;
+        }
+        cam->jpeg_fb_adaptive = g_sim_cam.adaptive && !g_sim_cam.psram;
+        if (g_sim_cam.psram) {
+            // target/esp32s3/ll_cam.c; cam_config() only allows this mode off the ESP32
+            cam->psram_mode = true;
+            cam->dma_bytes_per_item = 1;
+            cam->dma_buffer_size = cam->recv_size;
+            cam->dma_half_buffer_size = 1024;
+            cam->dma_half_buffer_cnt = cam->dma_buffer_size / cam->dma_half_buffer_size;
+            cam->dma_node_buffer_size = cam->dma_half_buffer_size;
+            return 1;
+        }
+        cam->dma_half_buffer_cnt = 8;
+        cam->dma_node_buffer_size = 2048;
+        cam->dma_half_buffer_size = cam->dma_node_buffer_size * 2;
+        cam->dma_buffer_size = cam->dma_half_buffer_cnt * cam->dma_half_buffer_size;
+    } else {
+        return ll_cam_calc_rgb_dma(cam);
+    }
+    return 1;
+}
+
+size_t ll_cam_memcpy(cam_obj_t *cam, uint8_t *out, const uint8_t *in, size_t len)
+{
+    cam_sim_sync();
+    size_t r = g_sim_cam.filter(out, in, len);
+    g_sim_cam.copied += len;
+    cam_sim_task_busy(len / g_sim_cam.copy_bytes_per_us);
+    return r;
+}
+
+esp_err_t ll_cam_set_sample_mode(cam_obj_t *cam, pixformat_t pix_format, uint32_t xclk_freq_hz, uint16_t sensor_pid)
+{
+    if (pix_format == PIXFORMAT_GRAYSCALE) {
+        if (sensor_pid == OV3660_PID || sensor_pid == OV5640_PID || sensor_pid == NT99141_PID || sensor_pid == SC031GS_PID || sensor_pid == BF20A6_PID || sensor_pid == GC0308_PID) {
+            if (xclk_freq_hz > 10000000) {
+                sampling_mode = SM_0A00_0B00;
+                g_sim_cam.filter = DMA_FILTER(yuyv_highspeed);
+            } else {
+                sampling_mode = SM_0A0B_0C0D;
+                g_sim_cam.filter = DMA_FILTER(yuyv);
+            }
+            cam->in_bytes_per_pixel = 1;
+        } else {
+            if (xclk_freq_hz > 10000000 && sensor_pid != OV7725_PID) {
+                sampling_mode = SM_0A00_0B00;
+                g_sim_cam.filter = DMA_FILTER(grayscale_highspeed);
+            } else {
+                sampling_mode = SM_0A0B_0C0D;
+                g_sim_cam.filter = DMA_FILTER(grayscale);
+            }
+            cam->in_bytes_per_pixel = 2;
+        }
+        cam->fb_bytes_per_pixel = 1;
+    } else if (pix_format == PIXFORMAT_YUV422 || pix_format == PIXFORMAT_RGB565) {
+        if (xclk_freq_hz > 10000000 && sensor_pid != OV7725_PID && sensor_pid != OV7670_PID) {
+            sampling_mode = SM_0A00_0B00;
+            g_sim_cam.filter = DMA_FILTER(yuyv_highspeed);
+        } else {
+            // SM_0A0B_0B0C (OV7670) repeats bytes across words and is not modelled
+            sampling_mode = SM_0A0B_0C0D;
+            g_sim_cam.filter = DMA_FILTER(yuyv);
+        }
+        cam->in_bytes_per_pixel = 2;
+        cam->fb_bytes_per_pixel = 2;
+    } else if (pix_format == PIXFORMAT_JPEG) {
+        cam->in_bytes_per_pixel = 1;
+        cam->fb_bytes_per_pixel = 1;
+        g_sim_cam.filter = DMA_FILTER(jpeg);
+        sampling_mode = SM_0A00_0B00;
+    } else {
+        ESP_LOGE(TAG, "Requested format is not supported");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
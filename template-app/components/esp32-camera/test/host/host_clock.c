@@ -0,0 +1,12 @@
+// Host build: esp_timer_get_time() on the real monotonic clock, for the
+// conversions library (the cam_hal simulator has its own simulated clock)
+#include <time.h>
+
+#include "esp_timer.h"
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,234 @@
+/*
+ * Single-threaded FreeRTOS queue/task implementation for host builds,
+ * see host_freertos.h.
+ */
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "host_freertos.h"
+
+struct host_queue {
+    uint8_t *items;
+    size_t len;
+    size_t item_size;
+    size_t head;
+    size_t count;
+    host_queue_stats_t stats;
+};
+
+struct host_task {
+    TaskFunction_t fn;
+    void *arg;
+    const char *name;
+};
+
+static host_freertos_hooks_t s_hooks;
+static int64_t s_time_us;
+static struct host_task *s_running;
+static jmp_buf s_task_exit;
+
+void host_freertos_set_hooks(const host_freertos_hooks_t *hooks)
+{
+    s_hooks = *hooks;
+}
+
+int64_t host_time_us(void)
+{
+    return s_time_us;
+}
+
+void host_time_set(int64_t us)
+{
+    s_time_us = us;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_time_us;
+}
+
+/* ---- queues ---- */
+
+static void queue_account(QueueHandle_t q)
+{
+    q->stats.occupancy_us += (double)q->count * (s_time_us - q->stats.last_change_us);
+    q->stats.last_change_us = s_time_us;
+}
+
+static bool queue_put(QueueHandle_t q, const void *item)
+{
+    if (q->count == q->len) {
+        q->stats.send_fails++;
+        return false;
+    }
+    queue_account(q);
+    memcpy(q->items + ((q->head + q->count) % q->len) * q->item_size, item, q->item_size);
+    q->count++;
+    q->stats.sends++;
+    if (q->count > q->stats.high_water) {
+        q->stats.high_water = q->count;
+    }
+    return true;
+}
+
+static bool queue_get(QueueHandle_t q, void *item)
+{
+    if (q->count == 0) {
+        return false;
+    }
+    queue_account(q);
+    memcpy(item, q->items + q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->len;
+    q->count--;
+    q->stats.receives++;
+    return true;
+}
+
+static void sync(void)
+{
+    if (s_hooks.sync) {
+        s_hooks.sync(s_hooks.ctx);
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size)
+{
+    QueueHandle_t q = calloc(1, sizeof(*q));
+    if (!q) {
+        return NULL;
+    }
+    q->items = calloc(len, item_size);
+    if (!q->items) {
+        free(q);
+        return NULL;
+    }
+    q->len = len;
+    q->item_size = item_size;
+    q->stats.last_change_us = s_time_us;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    if (q) {
+        free(q->items);
+        free(q);
+    }
+}
+
+BaseType_t xQueueReset(QueueHandle_t q)
+{
+    queue_account(q);
+    q->head = 0;
+    q->count = 0;
+    return pdPASS;
+}
+
+/* sends never wait on the host: a full queue fails immediately */
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    sync();
+    return queue_put(q, item) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    if (!queue_put(q, item)) {
+        return pdFALSE;
+    }
+    if (woken) {
+        *woken = pdTRUE;
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks_to_wait)
+{
+    int64_t deadline = s_time_us + (int64_t)ticks_to_wait * portTICK_PERIOD_MS * 1000;
+    while (true) {
+        sync();
+        if (queue_get(q, item)) {
+            return pdTRUE;
+        }
+        if (ticks_to_wait == 0 || (ticks_to_wait != portMAX_DELAY && s_time_us >= deadline)) {
+            return pdFALSE;
+        }
+        if (!s_hooks.block || !s_hooks.block(s_hooks.ctx, q)) {
+            if (s_running && ticks_to_wait == portMAX_DELAY) {
+                longjmp(s_task_exit, 1);
+            }
+            return pdFALSE;
+        }
+    }
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    return q->count;
+}
+
+const host_queue_stats_t *host_queue_stats(QueueHandle_t q)
+{
+    queue_account(q);
+    return &q->stats;
+}
+
+double host_queue_avg_occupancy(QueueHandle_t q)
+{
+    queue_account(q);
+    return s_time_us ? q->stats.occupancy_us / s_time_us : 0;
+}
+
+/* ---- tasks ---- */
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle)
+{
+    (void)stack;
+    (void)prio;
+    struct host_task *t = calloc(1, sizeof(*t));
+    if (!t) {
+        return pdFAIL;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    t->name = name;
+    if (handle) {
+        *handle = t;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)core;
+    return xTaskCreate(fn, name, stack, arg, prio, handle);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    free(task);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(s_time_us / 1000 / portTICK_PERIOD_MS);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    host_time_set(s_time_us + (int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+void host_task_run(TaskHandle_t task)
+{
+    s_running = task;
+    if (setjmp(s_task_exit) == 0) {
+        task->fn(task->arg);
+    }
+    s_running = NULL;
+}
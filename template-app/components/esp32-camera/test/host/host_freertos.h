@@ -0,0 +1,60 @@
+/*
+ * Single-threaded host implementation of the FreeRTOS queue and task calls
+ * used by cam_hal.c (shims/freertos/).
+ *
+ * Nothing runs concurrently. Time is a simulation clock that only moves when
+ * the host program moves it, and the host program decides what "the rest of
+ * the system" (ISRs, other tasks) does through two hooks:
+ *
+ *  - sync:  called at the start of every task-side queue call, so the host can
+ *           first deliver everything that happened up to the current time
+ *           (ISRs posting events, the application taking frames).
+ *  - block: called when a task waits on an empty queue. The host advances the
+ *           clock to the next thing that can wake the task and returns true,
+ *           or returns false to end the run.
+ *
+ * A task created with xTaskCreate() does not start by itself: host_task_run()
+ * calls its function and returns once a block hook ends the run.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    void (*sync)(void *ctx);
+    bool (*block)(void *ctx, QueueHandle_t q);
+    void *ctx;
+} host_freertos_hooks_t;
+
+typedef struct {
+    uint32_t sends;           // items accepted
+    uint32_t send_fails;      // sends rejected because the queue was full
+    uint32_t receives;        // items taken
+    uint32_t high_water;      // most items ever waiting
+    double   occupancy_us;    // integral of items waiting over time
+    int64_t  last_change_us;
+} host_queue_stats_t;
+
+void host_freertos_set_hooks(const host_freertos_hooks_t *hooks);
+
+/* the clock read by esp_timer_get_time() and xTaskGetTickCount() */
+int64_t host_time_us(void);
+void host_time_set(int64_t us);
+
+void host_task_run(TaskHandle_t task);
+
+const host_queue_stats_t *host_queue_stats(QueueHandle_t q);
+/* average number of items waiting from creation until now */
+double host_queue_avg_occupancy(QueueHandle_t q);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,4 @@
+// Host build shim: ets_printf is provided by the host program
+#pragma once
+
+int ets_printf(const char *fmt, ...);
@@ -0,0 +1,15 @@
+// Host build shim: DMA descriptor layout; the host never hands these to hardware
+#pragma once
+
+#include <stdint.h>
+
+typedef struct lldesc_s {
+    volatile uint32_t size  : 12,
+             length: 12,
+             offset:  5,
+             sosf  :  1,
+             eof   :  1,
+             owner :  1;
+    volatile const uint8_t *buf;
+    volatile uint32_t empty;
+} lldesc_t;
@@ -0,0 +1,8 @@
+// Host build shim: section placement attributes are no-ops off-target
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define EXT_RAM_ATTR
+#define DRAM_STR(str) (str)
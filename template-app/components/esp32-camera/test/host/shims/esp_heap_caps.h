@@ -0,0 +1,60 @@
+// Host build shim: every capability maps to the system heap
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MALLOC_CAP_EXEC     (1 << 0)
+#define MALLOC_CAP_32BIT    (1 << 1)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+static inline void *heap_caps_malloc(size_t size, unsigned int caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void *heap_caps_calloc(size_t n, size_t size, unsigned int caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+static inline void *heap_caps_realloc(void *ptr, size_t size, unsigned int caps)
+{
+    (void)caps;
+    return realloc(ptr, size);
+}
+
+static inline void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+static inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, unsigned int caps)
+{
+    (void)caps;
+    void *p = NULL;
+    return posix_memalign(&p, alignment < sizeof(void *) ? sizeof(void *) : alignment, size) ? NULL : p;
+}
+
+static inline void *heap_caps_aligned_calloc(size_t alignment, size_t n, size_t size, unsigned int caps)
+{
+    void *p = heap_caps_aligned_alloc(alignment, n * size, caps);
+    if (p) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+static inline size_t heap_caps_get_largest_free_block(unsigned int caps)
+{
+    (void)caps;
+    return SIZE_MAX;
+}
@@ -0,0 +1,4 @@
+// Host build shim: interrupt handles are opaque and never allocated
+#pragma once
+
+typedef void *intr_handle_t;
@@ -0,0 +1,19 @@
+// Host build shim: ESP_LOGx print to stderr, verbose levels are compiled out.
+// With HOST_LOG_HOOK defined, E/W/I go to host_log() instead, provided by the
+// host program (the cam_hal simulator counts the driver's warnings this way).
+#pragma once
+
+#include <stdio.h>
+
+#ifdef HOST_LOG_HOOK
+void host_log(char level, const char *tag, const char *fmt, ...);
+#define ESP_LOGE(tag, fmt, ...) host_log('E', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) host_log('W', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) host_log('I', tag, fmt, ##__VA_ARGS__)
+#else
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+#define ESP_LOGD(tag, fmt, ...) do { (void)(tag); } while (0)
+#define ESP_LOGV(tag, fmt, ...) do { (void)(tag); } while (0)
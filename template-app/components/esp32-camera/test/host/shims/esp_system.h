@@ -0,0 +1,5 @@
+// Host build shim
+#pragma once
+
+#include "esp_err.h"
+#include "esp_idf_version.h"
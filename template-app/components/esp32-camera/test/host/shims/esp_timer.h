@@ -0,0 +1,6 @@
+// Host build shim: microseconds on the host simulation clock (host_freertos.c)
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,40 @@
+// Host build shim: the FreeRTOS types and constants used by the camera driver.
+// Queues and tasks are implemented single-threaded in test/host/host_freertos.c,
+// or on threads (HOST_FREERTOS_THREADS) by the app's
+// template-app/test/host/host_freertos_threads.c.
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_attr.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE             ((BaseType_t)0)
+#define pdTRUE              ((BaseType_t)1)
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS  ((TickType_t)1)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define portYIELD_FROM_ISR()
+
+#ifdef HOST_FREERTOS_THREADS
+// host_freertos_threads.c: tasks are threads, a critical section is a mutex
+#include <pthread.h>
+typedef pthread_mutex_t portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED PTHREAD_MUTEX_INITIALIZER
+#define portENTER_CRITICAL(mux)     pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL(mux)      pthread_mutex_unlock(mux)
+#else
+// one thread: critical sections have nothing to exclude
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux)     ((void)(mux))
+#define portEXIT_CRITICAL(mux)      ((void)(mux))
+#endif
+#define configMAX_PRIORITIES 25
+#define portNUM_PROCESSORS   2
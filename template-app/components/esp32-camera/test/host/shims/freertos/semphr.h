@@ -0,0 +1,55 @@
+// Host build shim: binary semaphores and mutexes as one-item queues, counting
+// semaphores as queues of max_count tokens (test/host/host_freertos.h)
+#pragma once
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 1);
+}
+
+/* no priority inheritance on the host */
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    const uint8_t token = 0;
+    SemaphoreHandle_t sem = xQueueCreate(1, 1);
+    if (sem) {
+        xQueueSend(sem, &token, 0);
+    }
+    return sem;
+}
+
+static inline SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    const uint8_t token = 0;
+    SemaphoreHandle_t sem = xQueueCreate(max_count, 1);
+    while (sem && initial_count--) {
+        xQueueSend(sem, &token, 0);
+    }
+    return sem;
+}
+
+static inline UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem)
+{
+    return uxQueueMessagesWaiting(sem);
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    const uint8_t token = 0;
+    return xQueueSend(sem, &token, 0);
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    uint8_t token;
+    return xQueueReceive(sem, &token, ticks_to_wait);
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    vQueueDelete(sem);
+}
@@ -0,0 +1,2 @@
+// Host build shim: no target, no PSRAM, no ROM JPEG decoder (the software tjpgd is used)
+#pragma once
@@ -0,0 +1,2 @@
+// Host build shim: included by the converters but not used
+#pragma once
@@ -0,0 +1,187 @@
+/*
+ * Host test for the lock-free frame hand-off (driver/cam_fb_ring.c).
+ *
+ * Single-threaded checks of the ring and the latest slot, then a stress run
+ * of each with a real producer and consumer thread: every frame must arrive
+ * exactly once, in order, with the contents the producer wrote before it
+ * pushed the frame.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cam_fb_ring.h"
+
+#define STRESS_FRAMES   300000
+#define POOL            64
+
+static int s_failures;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        s_failures++;
+    }
+}
+
+static void test_ring(void)
+{
+    camera_fb_t fbs[3];
+    camera_fb_t *evicted;
+    cam_fb_ring_t ring;
+    check(cam_fb_ring_init(&ring, 3, false) == ESP_OK, "ring init");
+
+    // wrap the indices many times with a size that is not a power of two
+    for (int round = 0; round < 1000; round++) {
+        int n = 1 + round % 3;
+        for (int i = 0; i < n; i++) {
+            check(cam_fb_ring_push(&ring, &fbs[i], &evicted) && !evicted, "ring push");
+        }
+        check(cam_fb_ring_count(&ring) == (uint32_t)n, "ring count");
+        if (n == 3) {
+            check(!cam_fb_ring_push(&ring, &fbs[0], &evicted) && !evicted, "ring full");
+        }
+        for (int i = 0; i < n; i++) {
+            check(cam_fb_ring_pop(&ring) == &fbs[i], "ring order");
+        }
+        check(cam_fb_ring_pop(&ring) == NULL, "ring empty");
+    }
+    check(ring.high_water == 3 && ring.evicted == 0, "ring stats");
+    cam_fb_ring_deinit(&ring);
+}
+
+static void test_latest(void)
+{
+    camera_fb_t fbs[3];
+    camera_fb_t *evicted;
+    cam_fb_ring_t ring;
+    check(cam_fb_ring_init(&ring, 3, true) == ESP_OK, "latest init");
+
+    check(cam_fb_ring_pop(&ring) == NULL, "latest empty");
+    check(cam_fb_ring_push(&ring, &fbs[0], &evicted) && !evicted, "latest push");
+    check(cam_fb_ring_push(&ring, &fbs[1], &evicted) && evicted == &fbs[0], "latest evicts");
+    check(cam_fb_ring_push(&ring, &fbs[2], &evicted) && evicted == &fbs[1], "latest evicts again");
+    check(cam_fb_ring_count(&ring) == 1, "latest count");
+    check(cam_fb_ring_pop(&ring) == &fbs[2], "latest pop");
+    check(cam_fb_ring_pop(&ring) == NULL && cam_fb_ring_count(&ring) == 0, "latest drained");
+    check(ring.pushed == 3 && ring.evicted == 2 && ring.high_water == 1, "latest stats");
+    cam_fb_ring_deinit(&ring);
+}
+
+typedef struct {
+    cam_fb_ring_t ring;
+    camera_fb_t pool[POOL];
+    atomic_bool busy[POOL]; // pushed and not yet given back, like cam_frame_t.en
+    uint8_t *seen;          // 1 popped by the consumer, 2 evicted to the producer
+    atomic_bool done;
+    uint32_t out_of_order;
+    uint32_t bad_data;
+} stress_t;
+
+static void *stress_producer(void *arg)
+{
+    stress_t *st = (stress_t *)arg;
+    int pos = 0;
+    for (uint32_t seq = 0; seq < STRESS_FRAMES; seq++) {
+        // capture into a frame nobody holds
+        while (atomic_load(&st->busy[pos])) {
+            pos = (pos + 1) % POOL;
+            if (!pos) {
+                sched_yield();
+            }
+        }
+        camera_fb_t *fb = &st->pool[pos];
+        atomic_store(&st->busy[pos], true);
+        fb->len = seq;
+        fb->width = (uint16_t)(seq * 7);
+        camera_fb_t *evicted;
+        while (!cam_fb_ring_push(&st->ring, fb, &evicted)) {
+            sched_yield();
+        }
+        if (evicted) {
+            st->seen[evicted->len] += 2;
+            atomic_store(&st->busy[evicted - st->pool], false);
+        }
+    }
+    atomic_store(&st->done, true);
+    return NULL;
+}
+
+static void *stress_consumer(void *arg)
+{
+    stress_t *st = (stress_t *)arg;
+    long last = -1;
+    while (true) {
+        bool done = atomic_load(&st->done);
+        camera_fb_t *fb = cam_fb_ring_pop(&st->ring);
+        if (!fb) {
+            if (done) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        size_t seq = fb->len;
+        if ((long)seq <= last) {
+            st->out_of_order++;
+        }
+        if (fb->width != (uint16_t)(seq * 7)) {
+            st->bad_data++;
+        }
+        last = seq;
+        st->seen[seq] += 1;
+        atomic_store(&st->busy[fb - st->pool], false);
+    }
+    return NULL;
+}
+
+static void test_stress(bool latest)
+{
+    const char *name = latest ? "latest slot" : "ring";
+    stress_t *st = (stress_t *)calloc(1, sizeof(stress_t));
+    st->seen = (uint8_t *)calloc(STRESS_FRAMES, 1);
+    check(cam_fb_ring_init(&st->ring, 4, latest) == ESP_OK, "stress init");
+    atomic_init(&st->done, false);
+    for (int i = 0; i < POOL; i++) {
+        atomic_init(&st->busy[i], false);
+    }
+
+    pthread_t producer, consumer;
+    pthread_create(&consumer, NULL, stress_consumer, st);
+    pthread_create(&producer, NULL, stress_producer, st);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    uint32_t popped = 0, evicted = 0, lost = 0;
+    for (uint32_t seq = 0; seq < STRESS_FRAMES; seq++) {
+        popped += st->seen[seq] == 1;
+        evicted += st->seen[seq] == 2;
+        lost += st->seen[seq] != 1 && st->seen[seq] != 2;
+    }
+    printf("%-12s %u frames: %u to the consumer, %u evicted, %u lost, %u out of order, %u bad data\n",
+           name, STRESS_FRAMES, popped, evicted, lost, st->out_of_order, st->bad_data);
+    check(lost == 0 && st->out_of_order == 0 && st->bad_data == 0, name);
+    check(latest || evicted == 0, "ring never evicts");
+    check(evicted == st->ring.evicted, "evicted count");
+
+    cam_fb_ring_deinit(&st->ring);
+    free(st->seen);
+    free(st);
+}
+
+int main(void)
+{
+    test_ring();
+    test_latest();
+    test_stress(false);
+    test_stress(true);
+    if (s_failures) {
+        printf("%d failures\n", s_failures);
+        return 1;
+    }
+    printf("cam_fb_ring: all checks passed\n");
+    return 0;
+}
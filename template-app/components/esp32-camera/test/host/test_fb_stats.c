@@ -0,0 +1,120 @@
+/*
+ * Host test for the JPEG frame size statistics (driver/cam_fb_stats.c).
+ *
+ * The percentiles must never be below the true value and at most one
+ * histogram step (1/16) above it, must follow a change of scene once the
+ * window has turned over, and an overflow must count as a frame bigger than
+ * the buffer.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cam_fb_stats.h"
+
+static int s_failures;
+
+static uint32_t s_rand = 777;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static int cmp_size(const void *a, const void *b)
+{
+    size_t x = *(const size_t *)a, y = *(const size_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void expect_near(const char *what, size_t got, size_t want)
+{
+    // one step above the true value, or the 1 KiB first bucket
+    size_t limit = want < 1024 ? 1024 : want + want / 16 + 1;
+    if (got < want || got > limit) {
+        printf("FAIL %s: %zu, true value %zu\n", what, got, want);
+        s_failures++;
+    }
+}
+
+static void test_percentiles(void)
+{
+    static const uint32_t permille[] = { 1, 500, 900, 990, 1000 };
+    size_t sizes[CAM_FB_STATS_WINDOW];
+
+    for (int round = 0; round < 50; round++) {
+        cam_fb_stats_t stats;
+        cam_fb_stats_init(&stats);
+        size_t lo = 200 + next_rand() % 100000;
+        size_t span = 1 + next_rand() % 200000;
+        for (int i = 0; i < CAM_FB_STATS_WINDOW; i++) {
+            sizes[i] = lo + next_rand() % span;
+            cam_fb_stats_add(&stats, sizes[i]);
+        }
+        qsort(sizes, CAM_FB_STATS_WINDOW, sizeof(sizes[0]), cmp_size);
+        for (size_t p = 0; p < sizeof(permille) / sizeof(permille[0]); p++) {
+            size_t rank = (CAM_FB_STATS_WINDOW * permille[p] + 999) / 1000;
+            expect_near("percentile", cam_fb_stats_percentile(&stats, permille[p]), sizes[rank - 1]);
+        }
+        if (stats.max != sizes[CAM_FB_STATS_WINDOW - 1] || stats.frames != CAM_FB_STATS_WINDOW) {
+            printf("FAIL max %zu frames %u\n", stats.max, (unsigned)stats.frames);
+            s_failures++;
+        }
+    }
+}
+
+static void test_scene_change(void)
+{
+    cam_fb_stats_t stats;
+    cam_fb_stats_init(&stats);
+    if (cam_fb_stats_percentile(&stats, 990) != 0) {
+        printf("FAIL empty stats\n");
+        s_failures++;
+    }
+    for (int i = 0; i < CAM_FB_STATS_WINDOW; i++) {
+        cam_fb_stats_add(&stats, 40000);
+    }
+    // halving every window: after four windows of small frames the big ones are below 1 %
+    for (int i = 0; i < 4 * CAM_FB_STATS_WINDOW; i++) {
+        cam_fb_stats_add(&stats, 10000);
+    }
+    expect_near("after scene change", cam_fb_stats_percentile(&stats, 990), 10000);
+    if (stats.max != 40000) {
+        printf("FAIL max after scene change %zu\n", stats.max);
+        s_failures++;
+    }
+}
+
+static void test_overflow(void)
+{
+    cam_fb_stats_t stats;
+    cam_fb_stats_init(&stats);
+    for (int i = 0; i < 10; i++) {
+        cam_fb_stats_add(&stats, 5000);
+    }
+    cam_fb_stats_overflow(&stats, 8192);
+    size_t p = cam_fb_stats_percentile(&stats, 1000);
+    if (p <= 8192 || stats.overflows != 1 || stats.frames != 10) {
+        printf("FAIL overflow: p100 %zu, overflows %u, frames %u\n", p, (unsigned)stats.overflows, (unsigned)stats.frames);
+        s_failures++;
+    }
+    // beyond the last bucket
+    cam_fb_stats_add(&stats, 5 << 20);
+    if (cam_fb_stats_percentile(&stats, 1000) < (1 << 20)) {
+        printf("FAIL huge frame\n");
+        s_failures++;
+    }
+}
+
+int main(void)
+{
+    test_percentiles();
+    test_scene_change();
+    test_overflow();
+    if (s_failures) {
+        printf("%d failures\n", s_failures);
+        return 1;
+    }
+    printf("cam_fb_stats: all checks passed\n");
+    return 0;
+}
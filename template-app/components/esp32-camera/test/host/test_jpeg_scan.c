@@ -0,0 +1,184 @@
+/*
+ * Host test for the cam_hal JPEG marker scanner (driver/cam_jpeg_scan.c).
+ *
+ * The test pictures are fed in chunks of several sizes, followed by stale
+ * data from a "previous frame" that contains EOI markers of its own; the
+ * scanner must report the picture's own length every time. Data that isn't
+ * JPEG must fall back to the last EOI, like the old backwards search, and
+ * cam_jpeg_find_soi() must agree with a plain byte-wise search.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cam_jpeg_scan.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+static const char *s_pictures[] = {
+    "testimg.jpeg",
+    "test_inside.jpeg",
+    "test_outside.jpeg",
+};
+
+#define PICTURE_COUNT (sizeof(s_pictures) / sizeof(s_pictures[0]))
+#define STALE_BYTES   3000
+
+static int s_failures;
+
+static uint32_t s_rand = 4321;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = (uint8_t *)malloc(size + STALE_BYTES);
+    if (buf && fread(buf, 1, size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = size;
+    return buf;
+}
+
+static int32_t scan_chunked(const uint8_t *buf, size_t len, size_t chunk)
+{
+    cam_jpeg_scan_t scan;
+    cam_jpeg_scan_init(&scan);
+    for (size_t pos = 0; pos < len; pos += chunk) {
+        cam_jpeg_scan_feed(&scan, buf + pos, len - pos < chunk ? len - pos : chunk);
+    }
+    return cam_jpeg_scan_end(&scan);
+}
+
+static void expect_end(const char *what, size_t chunk, int32_t got, int32_t want)
+{
+    if (got != want) {
+        printf("FAIL %s chunk %zu: end %d, expected %d\n", what, chunk, (int)got, (int)want);
+        s_failures++;
+    }
+}
+
+/* byte-wise search, as cam_hal did it before */
+static int find_soi_ref(const uint8_t *buf, size_t len)
+{
+    static const uint8_t soi[3] = { 0xFF, 0xD8, 0xFF };
+    for (size_t i = 0; i + 3 <= len; i++) {
+        if (!memcmp(&buf[i], soi, 3)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void test_pictures(void)
+{
+    static const size_t chunks[] = { 1, 3, 7, 1024, 4096, 1 << 20 };
+
+    for (size_t p = 0; p < PICTURE_COUNT; p++) {
+        char path[256];
+        size_t len;
+        snprintf(path, sizeof(path), "%s/%s", TEST_PICTURES_DIR, s_pictures[p]);
+        uint8_t *jpg = read_file(path, &len);
+        if (!jpg) {
+            printf("FAIL cannot read %s\n", path);
+            s_failures++;
+            continue;
+        }
+        // the rest of the frame buffer: entropy data and an EOI from an older frame
+        for (size_t i = 0; i < STALE_BYTES; i++) {
+            jpg[len + i] = next_rand();
+        }
+        memcpy(&jpg[len + STALE_BYTES / 2 - 2], "\xFF\xD9", 2);
+        memcpy(&jpg[len + STALE_BYTES - 2], "\xFF\xD9", 2);
+
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            expect_end(s_pictures[p], chunks[c], scan_chunked(jpg, len, chunks[c]), len);
+            expect_end(s_pictures[p], chunks[c], scan_chunked(jpg, len + STALE_BYTES, chunks[c]), len);
+        }
+        // cut short: no EOI yet
+        expect_end(s_pictures[p], 0, scan_chunked(jpg, len - 1, 1024), -1);
+        free(jpg);
+    }
+}
+
+static void test_stuffing_and_restart(void)
+{
+    // SOI, DRI, SOS, entropy data with FF00, RST0 and fill bytes, EOI, stale EOI
+    static const uint8_t jpg[] = {
+        0xFF, 0xD8,
+        0xFF, 0xDD, 0x00, 0x04, 0x00, 0x01,
+        0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00,
+        0x12, 0xFF, 0x00, 0x34, 0xFF, 0xD0, 0x56, 0xFF, 0xFF, 0xD1, 0x78,
+        0xFF, 0xD9,
+        0x9A, 0xFF, 0xD9,
+    };
+    for (size_t chunk = 1; chunk <= sizeof(jpg); chunk++) {
+        expect_end("restart", chunk, scan_chunked(jpg, sizeof(jpg), chunk), 31);
+    }
+}
+
+static void test_loose(void)
+{
+    // no SOI: every EOI counts, the last one wins
+    static const uint8_t junk[] = {
+        0x00, 0xFF, 0xD9, 0x11, 0x22, 0xFF, 0xFF, 0xD9, 0x33,
+    };
+    // a segment length below 2
+    static const uint8_t bad_len[] = {
+        0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x01, 0x00, 0xFF, 0xD9, 0x00, 0xFF, 0xD9, 0x00,
+    };
+    for (size_t chunk = 1; chunk <= sizeof(bad_len); chunk++) {
+        expect_end("loose junk", chunk, scan_chunked(junk, sizeof(junk), chunk), 8);
+        expect_end("loose length", chunk, scan_chunked(bad_len, sizeof(bad_len), chunk), 12);
+    }
+}
+
+static void test_find_soi(void)
+{
+    static uint8_t buf[4096 + 8];
+    for (int round = 0; round < 2000; round++) {
+        size_t len = next_rand() % 4096;
+        size_t offset = next_rand() % 4;
+        uint8_t *p = buf + offset;
+        for (size_t i = 0; i < len; i++) {
+            // mostly 0xFF/0xD8 so that near misses are common
+            uint32_t r = next_rand();
+            p[i] = (r & 3) == 0 ? 0xD8 : (r & 3) == 1 ? 0xFF : r >> 8;
+        }
+        int want = find_soi_ref(p, len);
+        int got = cam_jpeg_find_soi(p, len);
+        if (got != want) {
+            printf("FAIL find_soi len %zu offset %zu: %d, expected %d\n", len, offset, got, want);
+            s_failures++;
+        }
+    }
+}
+
+int main(void)
+{
+    test_pictures();
+    test_stuffing_and_restart();
+    test_loose();
+    test_find_soi();
+    if (s_failures) {
+        printf("%d failures\n", s_failures);
+        return 1;
+    }
+    printf("cam_jpeg_scan: all checks passed\n");
+    return 0;
+}
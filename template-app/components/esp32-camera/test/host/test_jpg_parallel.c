@@ -0,0 +1,176 @@
+/*
+ * Host test for the parallel JPEG encode (fmt2jpg_parallel / fmt2jpg_cb_parallel).
+ *
+ * For several sizes, formats and band counts the banded JPEG must carry a
+ * DRI marker and one RSTn marker per band boundary, and decode to exactly
+ * the pixels of the single encoder's JPEG: restart intervals change only
+ * the entropy coding, never the coefficients. Decoded with tjpgd (target/,
+ * colour only: it does not take single component JPEGs) and, when the host
+ * has it, libjpeg.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "test_util.h"
+
+#define QUALITY 75
+
+/* like grow_buf_t (test_util.h), and records how the output was ended */
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t size;
+    int ends;           // calls with data == NULL
+    bool data_after_end;
+} end_buf_t;
+
+static int s_failures;
+
+static size_t end_buf_cb(void *arg, size_t index, const void *data, size_t len)
+{
+    end_buf_t *b = (end_buf_t *)arg;
+    if (!data) {
+        b->ends++;
+        return 0;
+    }
+    if (b->ends) {
+        b->data_after_end = true;
+    }
+    if (b->len + len > b->size) {
+        b->size = (b->len + len) * 2;
+        b->buf = (uint8_t *)realloc(b->buf, b->size);
+    }
+    memcpy(b->buf + b->len, data, len);
+    b->len += len;
+    return len;
+}
+
+static void fail(const char *what, int w, int h, pixformat_t format, int bands)
+{
+    printf("FAIL %dx%d format %d, %d bands: %s\n", w, h, format, bands, what);
+    s_failures++;
+}
+
+static uint8_t *make_picture(int w, int h, pixformat_t format, size_t *len)
+{
+    int bpp = format == PIXFORMAT_GRAYSCALE ? 1 : format == PIXFORMAT_RGB888 ? 3 : 2;
+    *len = (size_t)w * h * bpp;
+    uint8_t *p = (uint8_t *)malloc(*len);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < *len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        // smooth gradients with some noise, so there are both long zero runs and busy blocks
+        int x = (int)((i / bpp) % w), y = (int)((i / bpp) / w);
+        p[i] = (uint8_t)(x * 3 + y * 2 + (i % bpp) * 50 + ((seed >> 16) & 15));
+    }
+    return p;
+}
+
+static int count_markers(const uint8_t *jpg, size_t len, uint8_t first, uint8_t last)
+{
+    int n = 0;
+    for (size_t i = 0; i + 1 < len; i++) {
+        if (jpg[i] == 0xFF && jpg[i + 1] >= first && jpg[i + 1] <= last) {
+            n++;
+        }
+    }
+    return n;
+}
+
+static uint8_t *decode_tjpgd(const end_buf_t *jpg, int w, int h)
+{
+    uint8_t *rgb = (uint8_t *)malloc((size_t)w * h * 3);
+    if (!fmt2rgb888(jpg->buf, jpg->len, PIXFORMAT_JPEG, rgb)) {
+        free(rgb);
+        return NULL;
+    }
+    return rgb;
+}
+
+static void check(int w, int h, pixformat_t format, int bands)
+{
+    size_t src_len;
+    uint8_t *src = make_picture(w, h, format, &src_len);
+    end_buf_t seq = { 0 }, par = { 0 };
+
+    if (!fmt2jpg_cb(src, src_len, w, h, format, QUALITY, end_buf_cb, &seq)
+        || !fmt2jpg_cb_parallel(src, src_len, w, h, format, QUALITY, bands, end_buf_cb, &par)) {
+        fail("encode", w, h, format, bands);
+        goto done;
+    }
+    if (par.ends != 1 || par.data_after_end) {
+        fail("end of image not signalled exactly once, last", w, h, format, bands);
+    }
+
+    // bands of whole MCU rows, as fmt2jpg_cb_parallel splits them
+    int mcu_h = format == PIXFORMAT_GRAYSCALE ? 8 : 16;
+    int rows = (h + mcu_h - 1) / mcu_h;
+    int want = bands > 8 ? 8 : bands;
+    want = want > rows ? rows : want;
+    if (want > 1) {
+        int per_band = (rows + want - 1) / want;
+        want = (rows + per_band - 1) / per_band;
+    }
+    int rst = count_markers(par.buf, par.len, 0xD0, 0xD7);
+    int dri = count_markers(par.buf, par.len, 0xDD, 0xDD);
+    if (want > 1 ? (rst != want - 1 || dri != 1) : (par.len != seq.len || memcmp(par.buf, seq.buf, seq.len))) {
+        printf("  %d RSTn and %d DRI markers for %d bands\n", rst, dri, want);
+        fail("restart markers", w, h, format, bands);
+    }
+
+    uint8_t *a, *b;
+    if (format != PIXFORMAT_GRAYSCALE) {
+        a = decode_tjpgd(&seq, w, h);
+        b = decode_tjpgd(&par, w, h);
+        if (!a || !b || memcmp(a, b, (size_t)w * h * 3)) {
+            fail(!b ? "tjpgd cannot decode" : "tjpgd pixels differ", w, h, format, bands);
+        }
+        free(a);
+        free(b);
+    }
+#ifdef HAVE_LIBJPEG
+    int comps = format == PIXFORMAT_GRAYSCALE ? 1 : 3;
+    a = decode_libjpeg(seq.buf, seq.len, w, h);
+    b = decode_libjpeg(par.buf, par.len, w, h);
+    if (!a || !b || memcmp(a, b, (size_t)w * h * comps)) {
+        fail(!b ? "libjpeg cannot decode" : "libjpeg pixels differ", w, h, format, bands);
+    }
+    free(a);
+    free(b);
+#endif
+
+done:
+    free(seq.buf);
+    free(par.buf);
+    free(src);
+}
+
+int main(void)
+{
+    static const struct {
+        int w, h;
+    } sizes[] = { { 16, 16 }, { 100, 75 }, { 320, 240 }, { 640, 480 }, { 24, 200 } };
+    static const pixformat_t formats[] = { PIXFORMAT_RGB565, PIXFORMAT_YUV422, PIXFORMAT_RGB888, PIXFORMAT_GRAYSCALE };
+    static const int bands[] = { 1, 2, 3, 4, 8, 30 };
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            for (size_t b = 0; b < sizeof(bands) / sizeof(bands[0]); b++) {
+                check(sizes[s].w, sizes[s].h, formats[f], bands[b]);
+            }
+        }
+    }
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+#ifdef HAVE_LIBJPEG
+    printf("jpg parallel: all banded encodes decode like the single encode (tjpgd, libjpeg)\n");
+#else
+    printf("jpg parallel: all banded encodes decode like the single encode (tjpgd)\n");
+#endif
+    return 0;
+}
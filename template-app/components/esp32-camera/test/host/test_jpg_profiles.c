@@ -0,0 +1,216 @@
+/*
+ * Host test for the JPEG encoder profiles and custom quantization tables.
+ *
+ * Custom base tables, given in row major order, must show up in the DQT
+ * segment in zigzag order at quality 50 (and the chroma table default to
+ * the luma one). Every profile must encode a test picture that tjpgd
+ * decodes, with the subsampling the profile asks for, and at the same
+ * quality the thumbnail profile must be the smallest and the archive
+ * profile the largest. A banded encode with custom tables must decode to
+ * the pixels of the sequential one, frame2jpg_ex must write the bytes of
+ * fmt2jpg_ex, and jpg_profile_from_name must know every profile by name.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "test_util.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL line %d: ", __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            s_failures++; \
+        } \
+    } while (0)
+
+static int s_failures;
+
+// row major index of the k-th coefficient in zigzag order
+static const uint8_t s_zigzag[64] = {
+    0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5, 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47,
+    55, 62, 63,
+};
+
+/* The nth (from 0) header segment with the given marker, NULL if there is none before the scan */
+static const uint8_t *find_segment(const uint8_t *jpg, size_t len, uint8_t marker, int nth)
+{
+    size_t i = 2;
+    while (i + 4 < len && jpg[i] == 0xFF && jpg[i + 1] != 0xDA) {
+        if (jpg[i + 1] == marker && !nth--) {
+            return jpg + i;
+        }
+        i += 2 + ((jpg[i + 2] << 8) | jpg[i + 3]);
+    }
+    return NULL;
+}
+
+static bool encode(uint8_t *rgb, int w, int h, const jpg_encoder_config_t *config, grow_buf_t *out)
+{
+    out->len = 0;
+    return fmt2jpg_cb_ex(rgb, (size_t)w * h * 3, w, h, PIXFORMAT_RGB888, config, grow_buf_cb, out);
+}
+
+static void check_custom_tables(uint8_t *rgb, int w, int h)
+{
+    uint8_t luma[64], chroma[64];
+    for (int i = 0; i < 64; i++) {
+        luma[i] = 1 + i * 3;
+        chroma[i] = 250 - i;
+    }
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(50);
+    config.profile = JPG_PROFILE_THUMBNAIL;     // the custom tables take precedence over its tables
+    config.luma_quant = luma;
+    config.chroma_quant = chroma;
+    grow_buf_t out = { 0 };
+    CHECK(encode(rgb, w, h, &config, &out), "custom tables: encode");
+    for (int t = 0; t < 2; t++) {
+        const uint8_t *dqt = find_segment(out.buf, out.len, 0xDB, t);
+        CHECK(dqt && ((dqt[2] << 8) | dqt[3]) == 2 + 65, "custom tables: DQT %d", t);
+        if (dqt) {
+            const uint8_t *q = dqt + 4;
+            const uint8_t *want = t ? chroma : luma;
+            CHECK(q[0] == t, "custom tables: DQT table id %d", q[0]);
+            for (int k = 0; k < 64; k++) {
+                CHECK(q[1 + k] == want[s_zigzag[k]], "custom tables: table %d entry %d is %d, want %d", t, k, q[1 + k],
+                      want[s_zigzag[k]]);
+            }
+        }
+    }
+
+    // without a chroma table the luma one serves both
+    config.chroma_quant = NULL;
+    CHECK(encode(rgb, w, h, &config, &out), "custom luma table: encode");
+    const uint8_t *dqt_luma = find_segment(out.buf, out.len, 0xDB, 0);
+    const uint8_t *dqt_chroma = find_segment(out.buf, out.len, 0xDB, 1);
+    CHECK(dqt_luma && dqt_chroma && !memcmp(dqt_luma + 5, dqt_chroma + 5, 64), "custom luma table: chroma table differs");
+
+    // banded: restart markers change the bytes, not the pixels
+    config.chroma_quant = chroma;
+    grow_buf_t banded = { 0 };
+    CHECK(encode(rgb, w, h, &config, &out), "custom tables: encode");
+    config.bands = 3;
+    CHECK(encode(rgb, w, h, &config, &banded), "custom tables: banded encode");
+    size_t n = (size_t)w * h * 3;
+    uint8_t *a = (uint8_t *)malloc(n), *b = (uint8_t *)malloc(n);
+    CHECK(fmt2rgb888(out.buf, out.len, PIXFORMAT_JPEG, a) && fmt2rgb888(banded.buf, banded.len, PIXFORMAT_JPEG, b)
+          && !memcmp(a, b, n), "custom tables: banded encode decodes differently");
+    free(a);
+    free(b);
+    free(banded.buf);
+    free(out.buf);
+}
+
+static void check_profiles(uint8_t *rgb, int w, int h)
+{
+    static const struct {
+        const char *name;
+        uint8_t sampling;   // horizontal and vertical factor of the luma component in SOF
+    } expected[JPG_PROFILE_MAX] = {
+        { "default", 0x22 },
+        { "ocr-text", 0x22 },
+        { "thumbnail", 0x22 },
+        { "archive", 0x11 },
+    };
+    size_t sizes[JPG_PROFILE_MAX] = { 0 };
+    size_t n = (size_t)w * h * 3;
+    uint8_t *dec = (uint8_t *)malloc(n);
+    for (int p = 0; p < JPG_PROFILE_MAX; p++) {
+        CHECK(jpg_profile_from_name(expected[p].name) == (jpg_profile_t)p, "profile %s: name lookup", expected[p].name);
+        jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(50);
+        config.profile = (jpg_profile_t)p;
+        grow_buf_t out = { 0 };
+        bool ok = encode(rgb, w, h, &config, &out);
+        CHECK(ok && fmt2rgb888(out.buf, out.len, PIXFORMAT_JPEG, dec), "profile %s: encode or decode",
+              expected[p].name);
+        const uint8_t *sof = ok ? find_segment(out.buf, out.len, 0xC0, 0) : NULL;
+        CHECK(sof && sof[9] == 3 && sof[11] == expected[p].sampling, "profile %s: subsampling", expected[p].name);
+        sizes[p] = out.len;
+        printf("  %-10s %7zu bytes\n", expected[p].name, out.len);
+
+        // grayscale frames keep their one component whatever the profile
+        size_t pixels = (size_t)w * h;
+        uint8_t *grey = (uint8_t *)malloc(pixels);
+        for (size_t i = 0; i < pixels; i++) {
+            grey[i] = rgb[i * 3 + 1];
+        }
+        out.len = 0;
+        ok = fmt2jpg_cb_ex(grey, pixels, w, h, PIXFORMAT_GRAYSCALE, &config, grow_buf_cb, &out);
+        sof = ok ? find_segment(out.buf, out.len, 0xC0, 0) : NULL;
+        CHECK(sof && sof[9] == 1, "profile %s: grayscale encode", expected[p].name);
+        free(grey);
+        free(out.buf);
+    }
+    CHECK(sizes[JPG_PROFILE_THUMBNAIL] < sizes[JPG_PROFILE_DEFAULT], "thumbnail profile not smaller than default");
+    CHECK(sizes[JPG_PROFILE_ARCHIVE] > sizes[JPG_PROFILE_OCR_TEXT], "archive profile not larger than ocr-text");
+    CHECK(sizes[JPG_PROFILE_ARCHIVE] > sizes[JPG_PROFILE_DEFAULT], "archive profile not larger than default");
+    CHECK(jpg_profile_from_name("OCR") == JPG_PROFILE_MAX, "unknown profile name");
+    CHECK(jpg_profile_from_name(NULL) == JPG_PROFILE_MAX, "NULL profile name");
+
+    // like an out of range quality, an unknown profile falls back to the default
+    jpg_encoder_config_t bad = JPG_ENCODER_CONFIG_DEFAULT(50);
+    bad.profile = JPG_PROFILE_MAX;
+    grow_buf_t out = { 0 };
+    CHECK(encode(rgb, w, h, &bad, &out) && out.len == sizes[JPG_PROFILE_DEFAULT], "invalid profile not the default");
+    free(out.buf);
+    free(dec);
+}
+
+static void check_frame2jpg_ex(uint8_t *rgb, int w, int h)
+{
+    camera_fb_t fb = { 0 };
+    fb.buf = rgb;
+    fb.len = (size_t)w * h * 3;
+    fb.width = w;
+    fb.height = h;
+    fb.format = PIXFORMAT_RGB888;
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(30);
+    config.profile = JPG_PROFILE_OCR_TEXT;
+    uint8_t *a = NULL, *b = NULL;
+    size_t a_len = 0, b_len = 0;
+    CHECK(frame2jpg_ex(&fb, &config, &a, &a_len), "frame2jpg_ex");
+    CHECK(fmt2jpg_ex(rgb, fb.len, w, h, PIXFORMAT_RGB888, &config, &b, &b_len), "fmt2jpg_ex");
+    CHECK(a && b && a_len == b_len && !memcmp(a, b, a_len), "frame2jpg_ex and fmt2jpg_ex differ");
+    free(a);
+    free(b);
+}
+
+int main(void)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", TEST_PICTURES_DIR, "test_inside.jpeg");
+    size_t len;
+    uint8_t *jpg = read_file(path, &len);
+    int w, h;
+    if (!jpg || !jpeg_size(jpg, len, &w, &h)) {
+        printf("FAIL %s: cannot read\n", path);
+        return 1;
+    }
+    uint8_t *rgb = (uint8_t *)malloc((size_t)w * h * 3);
+    if (!fmt2rgb888(jpg, len, PIXFORMAT_JPEG, rgb)) {
+        printf("FAIL %s: cannot decode\n", path);
+        return 1;
+    }
+    printf("%s %dx%d, quality 50\n", path, w, h);
+
+    check_custom_tables(rgb, w, h);
+    check_profiles(rgb, w, h);
+    check_frame2jpg_ex(rgb, w, h);
+
+    free(rgb);
+    free(jpg);
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("jpg profiles: custom tables in DQT, every profile encodes and decodes\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Host test for the fast (AAN) forward DCT of the JPEG encoder.
+ *
+ * Each test picture is decoded, halved (a 2x2 box filter, so its 8x8 blocks
+ * no longer line up with the blocks it was quantized in, which would favour
+ * whichever DCT rounds the same way the original encoder did) and encoded
+ * from RGB888 with JPG_DCT_ACCURATE and with JPG_DCT_FAST over the quality
+ * range. Both JPEGs are decoded with tjpgd and compared with the source:
+ * the fast DCT may lose at most MAX_PSNR_LOSS_DB of PSNR and change the
+ * size by at most MAX_SIZE_CHANGE.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "test_util.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+#define MAX_PSNR_LOSS_DB    0.15
+#define MAX_SIZE_CHANGE     0.03
+
+static int s_failures;
+
+/* 2x2 box filter, in place: the result is (w / 2) x (h / 2) */
+static void halve(uint8_t *rgb, int *w, int *h)
+{
+    int hw = *w / 2, hh = *h / 2;
+    for (int y = 0; y < hh; y++) {
+        for (int x = 0; x < hw; x++) {
+            for (int c = 0; c < 3; c++) {
+                const uint8_t *s = rgb + ((size_t)y * 2 * *w + x * 2) * 3 + c;
+                size_t stride = (size_t)*w * 3;
+                rgb[((size_t)y * hw + x) * 3 + c] = (s[0] + s[3] + s[stride] + s[stride + 3] + 2) / 4;
+            }
+        }
+    }
+    *w = hw;
+    *h = hh;
+}
+
+/* Encode with one DCT and decode again; false if either fails */
+static bool round_trip(uint8_t *rgb, int w, int h, int quality, jpg_dct_t dct, size_t *jpg_len, double *db)
+{
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(quality);
+    config.dct = dct;
+    grow_buf_t jpg = { 0 };
+    size_t n = (size_t)w * h * 3;
+    uint8_t *out = (uint8_t *)malloc(n);
+    bool ok = fmt2jpg_cb_ex(rgb, n, w, h, PIXFORMAT_RGB888, &config, grow_buf_cb, &jpg)
+              && fmt2rgb888(jpg.buf, jpg.len, PIXFORMAT_JPEG, out);
+    if (ok) {
+        *jpg_len = jpg.len;
+        *db = psnr(rgb, out, n);
+    }
+    free(out);
+    free(jpg.buf);
+    return ok;
+}
+
+static void check_picture(const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", TEST_PICTURES_DIR, name);
+    size_t len;
+    uint8_t *jpg = read_file(path, &len);
+    int w, h;
+    if (!jpg || !jpeg_size(jpg, len, &w, &h)) {
+        printf("FAIL %s: cannot read\n", path);
+        s_failures++;
+        free(jpg);
+        return;
+    }
+    uint8_t *rgb = (uint8_t *)malloc((size_t)w * h * 3);
+    if (!fmt2rgb888(jpg, len, PIXFORMAT_JPEG, rgb)) {
+        printf("FAIL %s: cannot decode\n", path);
+        s_failures++;
+        goto done;
+    }
+    halve(rgb, &w, &h);
+
+    printf("%s %dx%d\n  quality   accurate         fast             size     PSNR\n", name, w, h);
+    for (int quality = 10; quality <= 95; quality += 5) {
+        size_t len_llm, len_aan;
+        double db_llm, db_aan;
+        if (!round_trip(rgb, w, h, quality, JPG_DCT_ACCURATE, &len_llm, &db_llm)
+            || !round_trip(rgb, w, h, quality, JPG_DCT_FAST, &len_aan, &db_aan)) {
+            printf("FAIL %s quality %d: encode or decode\n", name, quality);
+            s_failures++;
+            continue;
+        }
+        double size_change = (double)len_aan / len_llm - 1.0;
+        bool bad = db_llm - db_aan > MAX_PSNR_LOSS_DB || fabs(size_change) > MAX_SIZE_CHANGE;
+        printf("  %3d   %7zu %5.2f dB   %7zu %5.2f dB   %+5.2f%%  %+5.3f dB%s\n", quality, len_llm, db_llm,
+               len_aan, db_aan, size_change * 100, db_aan - db_llm, bad ? "  FAIL" : "");
+        if (bad) {
+            s_failures++;
+        }
+    }
+
+done:
+    free(rgb);
+    free(jpg);
+}
+
+int main(void)
+{
+    static const char *pictures[] = { "testimg.jpeg", "test_inside.jpeg", "test_outside.jpeg" };
+
+    for (size_t i = 0; i < sizeof(pictures) / sizeof(pictures[0]); i++) {
+        check_picture(pictures[i]);
+    }
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("jpge dct: fast DCT within %.2f dB PSNR and %.0f%% size of the accurate DCT\n", MAX_PSNR_LOSS_DB,
+           MAX_SIZE_CHANGE * 100);
+    return 0;
+}
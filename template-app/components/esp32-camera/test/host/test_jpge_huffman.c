@@ -0,0 +1,137 @@
+/*
+ * Host test for the optimized Huffman tables of the JPEG encoder.
+ *
+ * Each test picture is encoded from RGB888, grayscale and YUYV, with 4:2:0
+ * (default profile) and 4:4:4 (archive profile) subsampling, over the
+ * quality range, once with the standard tables and once with
+ * optimize_huffman. Only the entropy coding differs, so both JPEGs must
+ * decode to the same pixels, and the optimized one must be smaller. The
+ * colour JPEGs are decoded with tjpgd; with libjpeg on the host, which also
+ * rejects malformed Huffman tables, all of them are.
+ *
+ * The host build limits the symbol store to 64 KB, less than the larger
+ * encodes of test_outside.jpeg need: those cover the early end of the first
+ * pass, where the rest of the image is coded with tables that have a code
+ * for every symbol.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "test_util.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+static int s_failures;
+
+/* Decode both JPEGs; true if they give the same pixels */
+static bool same_pixels(const grow_buf_t *a, const grow_buf_t *b, int w, int h, pixformat_t format)
+{
+    bool same = true;
+    if (format != PIXFORMAT_GRAYSCALE) {
+        // tjpgd has no grayscale output
+        size_t n = (size_t)w * h * 3;
+        uint8_t *pa = (uint8_t *)malloc(n), *pb = (uint8_t *)malloc(n);
+        same = fmt2rgb888(a->buf, a->len, PIXFORMAT_JPEG, pa) && fmt2rgb888(b->buf, b->len, PIXFORMAT_JPEG, pb)
+               && !memcmp(pa, pb, n);
+        free(pa);
+        free(pb);
+    }
+#ifdef HAVE_LIBJPEG
+    size_t n = (size_t)w * h * (format == PIXFORMAT_GRAYSCALE ? 1 : 3);
+    uint8_t *la = decode_libjpeg(a->buf, a->len, w, h), *lb = decode_libjpeg(b->buf, b->len, w, h);
+    same = same && la && lb && !memcmp(la, lb, n);
+    free(la);
+    free(lb);
+#endif
+    return same;
+}
+
+static void check_format(const char *name, uint8_t *src, size_t src_len, int w, int h, pixformat_t format,
+                         jpg_profile_t profile, const char *label)
+{
+    size_t std_total = 0, opt_total = 0;
+    for (int quality = 10; quality <= 100; quality += 15) {
+        jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(quality);
+        config.profile = profile;
+        grow_buf_t std_jpg = { 0 }, opt_jpg = { 0 };
+        bool ok = fmt2jpg_cb_ex(src, src_len, w, h, format, &config, grow_buf_cb, &std_jpg);
+        config.optimize_huffman = true;
+        ok = ok && fmt2jpg_cb_ex(src, src_len, w, h, format, &config, grow_buf_cb, &opt_jpg);
+        if (!ok) {
+            printf("FAIL %s %s quality %d: encode\n", name, label, quality);
+            s_failures++;
+        } else if (!same_pixels(&std_jpg, &opt_jpg, w, h, format) || opt_jpg.len >= std_jpg.len) {
+            printf("FAIL %s %s quality %d: %zu -> %zu bytes, decoded pixels differ or larger\n", name, label, quality,
+                   std_jpg.len, opt_jpg.len);
+            s_failures++;
+        }
+        std_total += std_jpg.len;
+        opt_total += opt_jpg.len;
+        free(std_jpg.buf);
+        free(opt_jpg.buf);
+    }
+    printf("  %-16s %8zu -> %8zu bytes  %5.1f%% smaller\n", label, std_total, opt_total,
+           100.0 * (1.0 - (double)opt_total / std_total));
+}
+
+static void check_picture(const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", TEST_PICTURES_DIR, name);
+    size_t len;
+    uint8_t *jpg = read_file(path, &len);
+    int w, h;
+    if (!jpg || !jpeg_size(jpg, len, &w, &h)) {
+        printf("FAIL %s: cannot read\n", path);
+        s_failures++;
+        free(jpg);
+        return;
+    }
+    size_t pixels = (size_t)w * h;
+    uint8_t *rgb = (uint8_t *)malloc(pixels * 3);
+    uint8_t *grey = (uint8_t *)malloc(pixels);
+    uint8_t *yuyv = (uint8_t *)malloc(pixels * 2);
+    if (!fmt2rgb888(jpg, len, PIXFORMAT_JPEG, rgb)) {
+        printf("FAIL %s: cannot decode\n", path);
+        s_failures++;
+        goto done;
+    }
+    for (size_t i = 0; i < pixels; i++) {
+        grey[i] = rgb[i * 3 + 1];
+    }
+
+    printf("%s %dx%d, qualities 10-100\n", name, w, h);
+    check_format(name, rgb, pixels * 3, w, h, PIXFORMAT_RGB888, JPG_PROFILE_DEFAULT, "rgb888 4:2:0");
+    check_format(name, rgb, pixels * 3, w, h, PIXFORMAT_RGB888, JPG_PROFILE_ARCHIVE, "rgb888 4:4:4");
+    check_format(name, grey, pixels, w, h, PIXFORMAT_GRAYSCALE, JPG_PROFILE_DEFAULT, "grayscale");
+    if (!(w & 1)) {
+        bgr_to_yuyv(rgb, yuyv, w, h);
+        check_format(name, yuyv, pixels * 2, w, h, PIXFORMAT_YUV422, JPG_PROFILE_DEFAULT, "yuv422 4:2:0");
+    }
+
+done:
+    free(yuyv);
+    free(grey);
+    free(rgb);
+    free(jpg);
+}
+
+int main(void)
+{
+    static const char *pictures[] = { "testimg.jpeg", "test_inside.jpeg", "test_outside.jpeg" };
+
+    for (size_t i = 0; i < sizeof(pictures) / sizeof(pictures[0]); i++) {
+        check_picture(pictures[i]);
+    }
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("jpge huffman: optimized tables decode to the same pixels, always smaller\n");
+    return 0;
+}
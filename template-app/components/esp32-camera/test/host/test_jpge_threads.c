@@ -0,0 +1,98 @@
+/*
+ * Host stress test for concurrent JPEG encoding (conversions/jpge.cpp).
+ *
+ * Several threads encode different pictures at different qualities and
+ * subsamplings at the same time. Every output must be byte-identical to the
+ * same encode done alone: any table shared between encoders and written
+ * during an encode shows up as a mismatch.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+
+#define THREADS     4
+#define WIDTH       160
+#define HEIGHT      120
+#define ROUNDS      40
+
+typedef struct {
+    pixformat_t format;
+    uint8_t quality;
+    uint8_t *src;
+    size_t src_len;
+    uint8_t *ref;
+    size_t ref_len;
+    int mismatches;
+} job_t;
+
+static void make_picture(job_t *j, int seed)
+{
+    int bpp = j->format == PIXFORMAT_GRAYSCALE ? 1 : 3;
+    j->src_len = WIDTH * HEIGHT * bpp;
+    j->src = (uint8_t *)malloc(j->src_len);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            for (int c = 0; c < bpp; c++) {
+                j->src[(y * WIDTH + x) * bpp + c] = (uint8_t)((x * (seed + c + 1) + y * (seed + 3)) ^ (x * y >> seed));
+            }
+        }
+    }
+}
+
+static void *encode_loop(void *arg)
+{
+    job_t *j = (job_t *)arg;
+    for (int r = 0; r < ROUNDS; r++) {
+        uint8_t *out = NULL;
+        size_t len = 0;
+        if (!fmt2jpg(j->src, j->src_len, WIDTH, HEIGHT, j->format, j->quality, &out, &len)
+            || len != j->ref_len || memcmp(out, j->ref, len)) {
+            j->mismatches++;
+        }
+        free(out);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    job_t jobs[THREADS] = {
+        { .format = PIXFORMAT_RGB888, .quality = 12 },
+        { .format = PIXFORMAT_RGB888, .quality = 90 },
+        { .format = PIXFORMAT_GRAYSCALE, .quality = 40 },
+        { .format = PIXFORMAT_RGB888, .quality = 63 },
+    };
+    for (int t = 0; t < THREADS; t++) {
+        make_picture(&jobs[t], t + 1);
+        if (!fmt2jpg(jobs[t].src, jobs[t].src_len, WIDTH, HEIGHT, jobs[t].format, jobs[t].quality,
+                     &jobs[t].ref, &jobs[t].ref_len)) {
+            printf("FAIL reference encode %d\n", t);
+            return 1;
+        }
+    }
+
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        pthread_create(&threads[t], NULL, encode_loop, &jobs[t]);
+    }
+    int failures = 0;
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        if (jobs[t].mismatches) {
+            printf("FAIL thread %d (quality %d): %d of %d encodes differ from the reference\n",
+                   t, jobs[t].quality, jobs[t].mismatches, ROUNDS);
+            failures++;
+        }
+        free(jobs[t].src);
+        free(jobs[t].ref);
+    }
+    if (failures) {
+        return 1;
+    }
+    printf("jpge threads: %d threads x %d encodes identical to the reference\n", THREADS, ROUNDS);
+    return 0;
+}
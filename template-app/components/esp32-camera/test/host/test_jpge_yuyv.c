@@ -0,0 +1,143 @@
+/*
+ * Host test and accuracy report for the native YUYV input of the JPEG encoder.
+ *
+ * The test pictures are turned into studio range (BT.601) YUYV, as the
+ * sensors deliver it, and encoded two ways: fmt2jpg_cb(PIXFORMAT_YUV422),
+ * which hands the YCbCr samples straight to jpge, and the former route of
+ * converting to RGB (fmt2rgb888, yuv2rgb) and encoding the RGB888 frame,
+ * which converts back to YCbCr. Both JPEGs are decoded with tjpgd and
+ * compared with the exact (floating point) RGB of the YUYV frame.
+ *
+ * The native route must be at least as accurate at every quality, and
+ * fmt2jpg_cb_parallel must decode to the same pixels. The gap is widest on
+ * saturated colours: yuv2rgb takes the green term of Cb from the Cr column
+ * of its table and the other way round, which the native route never uses.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "test_util.h"
+
+#ifndef TEST_PICTURES_DIR
+#define TEST_PICTURES_DIR "../pictures"
+#endif
+
+// the native route may be this much worse before it counts as a regression
+#define PSNR_SLACK_DB   0.02
+
+static int s_failures;
+
+typedef struct {
+    size_t len;
+    double db;
+    int max_err;
+} result_t;
+
+static bool measure(const grow_buf_t *jpg, const uint8_t *ref, int w, int h, result_t *r)
+{
+    size_t n = (size_t)w * h * 3;
+    uint8_t *out = (uint8_t *)malloc(n);
+    bool ok = fmt2rgb888(jpg->buf, jpg->len, PIXFORMAT_JPEG, out);
+    if (ok) {
+        double se = 0;
+        r->max_err = 0;
+        for (size_t i = 0; i < n; i++) {
+            int d = abs(out[i] - ref[i]);
+            se += d * d;
+            r->max_err = d > r->max_err ? d : r->max_err;
+        }
+        r->db = se ? 10.0 * log10(255.0 * 255.0 * n / se) : 99.0;
+        r->len = jpg->len;
+    }
+    free(out);
+    return ok;
+}
+
+static void check_picture(const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", TEST_PICTURES_DIR, name);
+    size_t len;
+    uint8_t *jpg = read_file(path, &len);
+    int w, h;
+    if (!jpg || !jpeg_size(jpg, len, &w, &h)) {
+        printf("FAIL %s: cannot read\n", path);
+        s_failures++;
+        free(jpg);
+        return;
+    }
+    int full_w = w;
+    w &= ~1;    // the YUYV frame needs whole pixel pairs
+    size_t pixels = (size_t)w * h;
+    uint8_t *full = (uint8_t *)malloc((size_t)full_w * h * 3);
+    uint8_t *bgr = (uint8_t *)malloc(pixels * 3);
+    uint8_t *yuyv = (uint8_t *)malloc(pixels * 2);
+    uint8_t *ref = (uint8_t *)malloc(pixels * 3);
+    uint8_t *via_rgb = (uint8_t *)malloc(pixels * 3);
+    if (!fmt2rgb888(jpg, len, PIXFORMAT_JPEG, full)) {
+        printf("FAIL %s: cannot decode\n", path);
+        s_failures++;
+        goto done;
+    }
+    for (int y = 0; y < h; y++) {
+        memcpy(bgr + (size_t)y * w * 3, full + (size_t)y * full_w * 3, (size_t)w * 3);
+    }
+    bgr_to_yuyv(bgr, yuyv, w, h);
+    yuyv_to_bgr(yuyv, ref, w, h);
+    if (!fmt2rgb888(yuyv, pixels * 2, PIXFORMAT_YUV422, via_rgb)) {
+        printf("FAIL %s: yuv422 to rgb888\n", name);
+        s_failures++;
+        goto done;
+    }
+
+    printf("%s %dx%d\n  quality   native (YUYV)               via RGB                     PSNR\n", name, w, h);
+    for (int quality = 10; quality <= 100; quality += 10) {
+        grow_buf_t a = { 0 }, b = { 0 }, par = { 0 };
+        result_t ra, rb, rp;
+        bool ok = fmt2jpg_cb(yuyv, pixels * 2, w, h, PIXFORMAT_YUV422, quality, grow_buf_cb, &a)
+                  && fmt2jpg_cb(via_rgb, pixels * 3, w, h, PIXFORMAT_RGB888, quality, grow_buf_cb, &b)
+                  && fmt2jpg_cb_parallel(yuyv, pixels * 2, w, h, PIXFORMAT_YUV422, quality, 3, grow_buf_cb, &par)
+                  && measure(&a, ref, w, h, &ra) && measure(&b, ref, w, h, &rb) && measure(&par, ref, w, h, &rp);
+        if (!ok) {
+            printf("FAIL %s quality %d: encode or decode\n", name, quality);
+            s_failures++;
+        } else {
+            bool bad = ra.db < rb.db - PSNR_SLACK_DB || rp.db != ra.db;
+            printf("  %3d   %7zu %5.2f dB max %3d   %7zu %5.2f dB max %3d   %+5.2f dB%s\n", quality, ra.len, ra.db,
+                   ra.max_err, rb.len, rb.db, rb.max_err, ra.db - rb.db, bad ? "  FAIL" : "");
+            if (bad) {
+                s_failures++;
+            }
+        }
+        free(a.buf);
+        free(b.buf);
+        free(par.buf);
+    }
+
+done:
+    free(full);
+    free(via_rgb);
+    free(ref);
+    free(yuyv);
+    free(bgr);
+    free(jpg);
+}
+
+int main(void)
+{
+    static const char *pictures[] = { "testimg.jpeg", "test_inside.jpeg", "test_outside.jpeg" };
+
+    for (size_t i = 0; i < sizeof(pictures) / sizeof(pictures[0]); i++) {
+        check_picture(pictures[i]);
+    }
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("jpge yuyv: native YUYV encode at least as accurate as the RGB round trip\n");
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Host test for the latency histogram (driver/cam_latency.c).
+ *
+ * Percentiles must never be below the true value and at most one bucket
+ * (1/8) above it, capped by the largest sample; huge samples land in the
+ * last bucket and a reset histogram reads as empty.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+
+static int s_failures;
+
+static uint32_t s_rand = 4242;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void expect_near(const char *what, uint32_t got, uint32_t want)
+{
+    uint32_t limit = want + want / 8;
+    if (got < want || got > limit) {
+        printf("FAIL %s: %u, true value %u\n", what, (unsigned)got, (unsigned)want);
+        s_failures++;
+    }
+}
+
+static void test_percentiles(void)
+{
+    enum { N = 1000 };
+    static uint32_t samples[N];
+
+    for (int round = 0; round < 50; round++) {
+        static camera_latency_hist_t hist;
+        esp_camera_latency_reset(&hist);
+        // from a few us up to seconds
+        uint32_t lo = next_rand() % 1000;
+        uint32_t span = 1 + ((next_rand() % 4000000) >> (next_rand() % 20));
+        for (int i = 0; i < N; i++) {
+            samples[i] = lo + next_rand() % span;
+            esp_camera_latency_add(&hist, samples[i]);
+        }
+        qsort(samples, N, sizeof(samples[0]), cmp_u32);
+
+        camera_latency_stats_t st;
+        esp_camera_latency_get(&hist, &st);
+        expect_near("p50", st.p50_us, samples[N / 2 - 1]);
+        expect_near("p90", st.p90_us, samples[N * 9 / 10 - 1]);
+        expect_near("p99", st.p99_us, samples[N * 99 / 100 - 1]);
+        if (st.count != N || st.max_us != samples[N - 1] || st.p99_us > st.max_us) {
+            printf("FAIL count %u max %u p99 %u\n", (unsigned)st.count, (unsigned)st.max_us, (unsigned)st.p99_us);
+            s_failures++;
+        }
+    }
+}
+
+static void test_edges(void)
+{
+    static camera_latency_hist_t hist;
+    camera_latency_stats_t st;
+
+    esp_camera_latency_get(&hist, &st);
+    if (st.count || st.p50_us || st.max_us) {
+        printf("FAIL empty histogram\n");
+        s_failures++;
+    }
+
+    // small values are exact
+    for (uint32_t us = 0; us < 8; us++) {
+        esp_camera_latency_reset(&hist);
+        esp_camera_latency_add(&hist, us);
+        esp_camera_latency_get(&hist, &st);
+        if (st.p50_us != us) {
+            printf("FAIL exact %u -> %u\n", (unsigned)us, (unsigned)st.p50_us);
+            s_failures++;
+        }
+    }
+
+    // beyond the last bucket: the percentile is capped by the largest sample
+    esp_camera_latency_reset(&hist);
+    esp_camera_latency_add(&hist, 100);
+    esp_camera_latency_add(&hist, 4000000000u);
+    esp_camera_latency_get(&hist, &st);
+    if (st.max_us != 4000000000u || st.p99_us < 30000000u || st.p50_us < 100 || st.p50_us > 112) {
+        printf("FAIL huge sample: p50 %u p99 %u max %u\n", (unsigned)st.p50_us, (unsigned)st.p99_us, (unsigned)st.max_us);
+        s_failures++;
+    }
+
+    esp_camera_latency_reset(&hist);
+    esp_camera_latency_get(&hist, &st);
+    if (st.count || st.max_us) {
+        printf("FAIL reset\n");
+        s_failures++;
+    }
+}
+
+int main(void)
+{
+    test_percentiles();
+    test_edges();
+    if (s_failures) {
+        printf("%d failures\n", s_failures);
+        return 1;
+    }
+    printf("cam_latency: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Host test for the trace ring (driver/esp_camera_trace.c) and the trace
+ * points in the conversions.
+ *
+ * Encoding and decoding a small picture must leave balanced convert_image,
+ * MCU row and decoder spans in the exported Chrome trace JSON, with
+ * timestamps in order. When the ring wraps only the newest events are
+ * exported and end events whose begin was overwritten are dropped. A task
+ * that exits before the export, like a JPEG band task, keeps its name, and
+ * tasks of the same name share one thread. A writer that fails stops the
+ * export.
+ */
+#define _GNU_SOURCE // pthread_setname_np
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "esp_camera_trace.h"
+#include "img_converters.h"
+
+#define WIDTH   64
+#define HEIGHT  48      // three H2V2 MCU rows
+
+static int s_failures;
+
+typedef struct {
+    char *buf;
+    size_t len, cap;
+    int calls, fail_at;
+} sink_t;
+
+static bool sink_write(void *arg, const char *data, size_t len)
+{
+    sink_t *s = (sink_t *)arg;
+    if (++s->calls == s->fail_at) {
+        return false;
+    }
+    if (s->len + len + 1 > s->cap) {
+        s->cap = (s->len + len + 1) * 2;
+        s->buf = (char *)realloc(s->buf, s->cap);
+    }
+    memcpy(s->buf + s->len, data, len);
+    s->len += len;
+    s->buf[s->len] = 0;
+    return true;
+}
+
+static char *export_trace(void)
+{
+    sink_t s = { 0 };
+    if (esp_camera_trace_export(sink_write, &s) != ESP_OK) {
+        printf("FAIL export\n");
+        s_failures++;
+    }
+    return s.buf;
+}
+
+static int count(const char *json, const char *what)
+{
+    int n = 0;
+    for (const char *p = json; (p = strstr(p, what)); p += strlen(what)) {
+        n++;
+    }
+    return n;
+}
+
+static void expect_count(const char *json, const char *what, int want)
+{
+    int got = count(json, what);
+    if (got != want) {
+        printf("FAIL %s: %d, expected %d\n", what, got, want);
+        s_failures++;
+    }
+}
+
+static void expect_wellformed(const char *json)
+{
+    const char *head = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    size_t len = strlen(json);
+    if (strncmp(json, head, strlen(head)) || len < 4 || strcmp(json + len - 4, "\n]}\n")) {
+        printf("FAIL not a trace document\n");
+        s_failures++;
+    }
+    long last = -1;
+    for (const char *p = json; (p = strstr(p, "\"ts\":")); p++) {
+        long ts = strtol(p + 5, NULL, 10);
+        if (ts < last) {
+            printf("FAIL timestamps out of order: %ld after %ld\n", ts, last);
+            s_failures++;
+            return;
+        }
+        last = ts;
+    }
+}
+
+static void test_codec(void)
+{
+    uint8_t *rgb = (uint8_t *)malloc(WIDTH * HEIGHT * 3);
+    for (int i = 0; i < WIDTH * HEIGHT * 3; i++) {
+        rgb[i] = (uint8_t)(i * 7);
+    }
+    uint8_t *jpg = NULL;
+    size_t jpg_len = 0;
+
+    esp_camera_trace_start();
+    bool ok = fmt2jpg(rgb, WIDTH * HEIGHT * 3, WIDTH, HEIGHT, PIXFORMAT_RGB888, 80, &jpg, &jpg_len)
+              && fmt2rgb888(jpg, jpg_len, PIXFORMAT_JPEG, rgb);
+    CAM_TRACE_INSTANT("marker", 42);
+    CAM_TRACE_COUNTER("level", -3);
+    char *json = export_trace();
+    if (!ok) {
+        printf("FAIL encode/decode\n");
+        s_failures++;
+    }
+
+    expect_wellformed(json);
+    expect_count(json, "{\"name\":\"convert_image\",\"ph\":\"B\"", 1);
+    expect_count(json, "{\"name\":\"convert_image\",\"ph\":\"E\"", 1);
+    expect_count(json, "{\"name\":\"jpge mcu row\",\"ph\":\"B\"", HEIGHT / 16);
+    expect_count(json, "{\"name\":\"jpge mcu row\",\"ph\":\"E\"", HEIGHT / 16);
+    expect_count(json, "{\"name\":\"jd_prepare\",\"ph\":\"B\"", 1);
+    expect_count(json, "{\"name\":\"jd_decomp\",\"ph\":\"E\"", 1);
+    expect_count(json, "\"ph\":\"i\"", 1);
+    expect_count(json, "\"s\":\"t\",\"args\":{\"v\":42}", 1);
+    expect_count(json, "\"name\":\"level\",\"ph\":\"C\"", 1);
+    expect_count(json, "\"args\":{\"value\":-3}", 1);
+    expect_count(json, "\"name\":\"thread_name\"", 1);
+    free(json);
+
+    // stopped: nothing more is recorded
+    CAM_TRACE_INSTANT("late", 0);
+    json = export_trace();
+    expect_count(json, "\"late\"", 0);
+    free(json);
+
+    free(jpg);
+    free(rgb);
+}
+
+static void test_wrap(void)
+{
+    esp_camera_trace_start();
+    CAM_TRACE_BEGIN("outer");
+    for (int i = 0; i < CONFIG_CAMERA_TRACE_EVENTS; i++) {
+        CAM_TRACE_BEGIN("inner");
+        CAM_TRACE_END("inner");
+    }
+    CAM_TRACE_END("outer");
+    char *json = export_trace();
+    expect_wellformed(json);
+    // the outer begin and the first inner pair were overwritten
+    expect_count(json, "\"name\":\"outer\"", 0);
+    expect_count(json, "\"name\":\"inner\",\"ph\":\"B\"", CONFIG_CAMERA_TRACE_EVENTS / 2 - 1);
+    expect_count(json, "\"name\":\"inner\",\"ph\":\"E\"", CONFIG_CAMERA_TRACE_EVENTS / 2 - 1);
+    free(json);
+}
+
+static void *band_task(void *arg)
+{
+    (void)arg;
+    pthread_setname_np(pthread_self(), "jpg_band");
+    CAM_TRACE_BEGIN("jpg band");
+    CAM_TRACE_END("jpg band");
+    return NULL;
+}
+
+static void test_exited_task(void)
+{
+    esp_camera_trace_start();
+    CAM_TRACE_INSTANT("before", 0);
+    // more band tasks than the task table holds, one after the other
+    for (int i = 0; i < 40; i++) {
+        pthread_t band;
+        pthread_create(&band, NULL, band_task, NULL);
+        pthread_join(band, NULL);
+    }
+    char *json = export_trace();
+    expect_wellformed(json);
+    expect_count(json, "\"name\":\"thread_name\"", 2);
+    expect_count(json, "\"args\":{\"name\":\"jpg_band\"}", 1);
+    expect_count(json, "{\"name\":\"jpg band\",\"ph\":\"E\"", 40);
+    free(json);
+}
+
+static void test_write_failure(void)
+{
+    esp_camera_trace_start();
+    for (int i = 0; i < 10; i++) {
+        CAM_TRACE_INSTANT("x", i);
+    }
+    sink_t s = { .fail_at = 3 };
+    if (esp_camera_trace_export(sink_write, &s) != ESP_FAIL || s.calls != 3) {
+        printf("FAIL export went on after a failed write (%d calls)\n", s.calls);
+        s_failures++;
+    }
+    free(s.buf);
+}
+
+int main(void)
+{
+    // an empty trace is still a valid document
+    char *json = export_trace();
+    expect_wellformed(json);
+    expect_count(json, "\"ph\"", 0);
+    free(json);
+
+    test_codec();
+    test_wrap();
+    test_exited_task();
+    test_write_failure();
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("trace: all checks passed\n");
+    return 0;
+}
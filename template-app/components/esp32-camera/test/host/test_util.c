@@ -0,0 +1,169 @@
+/*
+ * Helpers shared by the host tests and benchmarks, see test_util.h.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_util.h"
+
+#if HAVE_TSC
+#include <x86intrin.h>
+#endif
+
+#ifdef HAVE_LIBJPEG
+#include <jpeglib.h>
+#endif
+
+uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = (uint8_t *)malloc(size);
+    if (buf && fread(buf, 1, size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = size;
+    return buf;
+}
+
+bool jpeg_size(const uint8_t *jpg, size_t len, int *w, int *h)
+{
+    size_t i = 2;
+    while (i + 9 < len) {
+        if (jpg[i] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = jpg[i + 1];
+        uint16_t seg = (jpg[i + 2] << 8) | jpg[i + 3];
+        if (marker >= 0xC0 && marker <= 0xC2) {
+            *h = (jpg[i + 5] << 8) | jpg[i + 6];
+            *w = (jpg[i + 7] << 8) | jpg[i + 8];
+            return true;
+        }
+        i += 2 + seg;
+    }
+    return false;
+}
+
+size_t grow_buf_cb(void *arg, size_t index, const void *data, size_t len)
+{
+    grow_buf_t *g = (grow_buf_t *)arg;
+    (void)index;
+    if (!data || !len) {
+        return 0;
+    }
+    if (g->len + len > g->size) {
+        size_t size = g->size ? g->size * 2 : 64 * 1024;
+        while (size < g->len + len) {
+            size *= 2;
+        }
+        uint8_t *buf = (uint8_t *)realloc(g->buf, size);
+        if (!buf) {
+            return 0;
+        }
+        g->buf = buf;
+        g->size = size;
+    }
+    memcpy(g->buf + g->len, data, len);
+    g->len += len;
+    return len;
+}
+
+double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+uint64_t cycles(void)
+{
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+double psnr(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    double se = 0;
+    for (size_t i = 0; i < n; i++) {
+        int d = a[i] - b[i];
+        se += d * d;
+    }
+    return se ? 10.0 * log10(255.0 * 255.0 * n / se) : 99.0;
+}
+
+static uint8_t clamp_round(double v)
+{
+    return v < 0 ? 0 : v > 255 ? 255 : (uint8_t)(v + 0.5);
+}
+
+void bgr_to_yuyv(const uint8_t *bgr, uint8_t *yuyv, int w, int h)
+{
+    for (int i = 0; i < w * h; i += 2) {
+        double cb = 0, cr = 0;
+        for (int k = 0; k < 2; k++) {
+            const uint8_t *p = bgr + (i + k) * 3;
+            double r = p[2], g = p[1], b = p[0];
+            yuyv[(i + k) * 2] = clamp_round(16 + (0.299 * r + 0.587 * g + 0.114 * b) * 219 / 255);
+            cb += (-0.168736 * r - 0.331264 * g + 0.5 * b) * 224 / 255 / 2;
+            cr += (0.5 * r - 0.418688 * g - 0.081312 * b) * 224 / 255 / 2;
+        }
+        yuyv[i * 2 + 1] = clamp_round(128 + cb);
+        yuyv[i * 2 + 3] = clamp_round(128 + cr);
+    }
+}
+
+void yuyv_to_bgr(const uint8_t *yuyv, uint8_t *bgr, int w, int h)
+{
+    for (int i = 0; i < w * h; i++) {
+        const uint8_t *pair = yuyv + (i & ~1) * 2;
+        double y = (yuyv[i * 2] - 16) * 255.0 / 219;
+        double cb = (pair[1] - 128) * 255.0 / 224, cr = (pair[3] - 128) * 255.0 / 224;
+        bgr[i * 3 + 2] = clamp_round(y + 1.402 * cr);
+        bgr[i * 3 + 1] = clamp_round(y - 0.344136 * cb - 0.714136 * cr);
+        bgr[i * 3 + 0] = clamp_round(y + 1.772 * cb);
+    }
+}
+
+#ifdef HAVE_LIBJPEG
+uint8_t *decode_libjpeg(const uint8_t *jpg, size_t len, int w, int h)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpg, len);
+    uint8_t *out = NULL;
+    if (jpeg_read_header(&cinfo, TRUE) == JPEG_HEADER_OK && (int)cinfo.image_width == w && (int)cinfo.image_height == h) {
+        cinfo.dct_method = JDCT_ISLOW;
+        jpeg_start_decompress(&cinfo);
+        size_t stride = (size_t)w * cinfo.output_components;
+        out = (uint8_t *)malloc(stride * h);
+        while (cinfo.output_scanline < cinfo.output_height) {
+            uint8_t *row = out + stride * cinfo.output_scanline;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_decompress(&cinfo);
+        // libjpeg reports corrupt data as warnings
+        if (jerr.num_warnings) {
+            free(out);
+            out = NULL;
+        }
+    }
+    jpeg_destroy_decompress(&cinfo);
+    return out;
+}
+#endif
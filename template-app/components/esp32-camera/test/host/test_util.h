@@ -0,0 +1,62 @@
+/*
+ * Helpers shared by the host tests and benchmarks (test_util.c): picture
+ * files, JPEG output buffers, timing and pixel comparisons.
+ *
+ * decode_libjpeg() is there when libjpeg was found (HAVE_LIBJPEG, set for
+ * everything that links the helpers).
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* JPEG output collected by grow_buf_cb(); free(buf) when done */
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t size;
+} grow_buf_t;
+
+/* the whole file in a malloc'ed buffer, NULL if it cannot be read */
+uint8_t *read_file(const char *path, size_t *len);
+
+/* JPEG header scan for the picture size (SOF0..SOF2) */
+bool jpeg_size(const uint8_t *jpg, size_t len, int *w, int *h);
+
+/* fmt2jpg_cb() output callback appending to a grow_buf_t */
+size_t grow_buf_cb(void *arg, size_t index, const void *data, size_t len);
+
+/* monotonic clock in ms */
+double now_ms(void);
+
+/* TSC cycles on x86 (HAVE_TSC), 0 elsewhere */
+uint64_t cycles(void);
+
+/* PSNR in dB of two 8-bit sample buffers, 99 if identical */
+double psnr(const uint8_t *a, const uint8_t *b, size_t n);
+
+/* BGR888 (as fmt2rgb888 writes it) to studio range YUYV, chroma averaged over each pixel pair */
+void bgr_to_yuyv(const uint8_t *bgr, uint8_t *yuyv, int w, int h);
+
+/* the exact BGR888 of a studio range YUYV frame */
+void yuyv_to_bgr(const uint8_t *yuyv, uint8_t *bgr, int w, int h);
+
+#ifdef HAVE_LIBJPEG
+/* w x h pixels with libjpeg's accurate IDCT, NULL if the JPEG is corrupt or another size */
+uint8_t *decode_libjpeg(const uint8_t *jpg, size_t len, int w, int h);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
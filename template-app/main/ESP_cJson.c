@@ -1,18 +1,37 @@
-
+#include <inttypes.h>
 #include <header.h>
 
 static const char *cJsonParsingTag = "cJsonParsing";
 #define MAX_JSON_BODY 1024
 
 /*
-함수는 각각
-1. http 함수에서 json이 담긴 body를 받는다
-2. content_len을 받는다
-3. client 핸들을 받는다
+OCR 응답 JSON
+- 응답을 받으면서 필드를 꺼내는 스트리밍 추출기는 ESP_json_stream.c
+- 여기는 결과 출력과 cJSON 방식 비교(json_bench)
 */
 
-void parse_json_body(const char *body, size_t len, esp_http_client_handle_t client)
+void ocr_resp_log(const ocr_resp_t *r)
+{
+    for (int i = 0; i < OCR_FIELD_COUNT; i++)
+    {
+        const ocr_field_t *f = &r->fields[i];
+        if (f->found)
+        {
+            ESP_LOGI(cJsonParsingTag, "%s : %s%s (%zuB)", ocr_field_name(i), f->text, f->len >= OCR_FIELD_MAX ? "..." : "", f->len);
+        }
+    }
+}
+
+/*
+cJSON으로 같은 필드를 꺼내는 기존 방식 (전체 바디 복사 + 트리 생성), 비교용
+문자열과 숫자 값만 꺼낸다 (숫자는 cJSON이 다시 쓴 글자)
+1. json이 담긴 body
+2. body 길이
+3. 결과를 담을 ocr_resp_t
+*/
+void parse_json_body(const char *body, size_t len, ocr_resp_t *out)
 {
+    memset(out, 0, sizeof(*out));
     if (!body || len == 0 || len > MAX_JSON_BODY)
     {
         ESP_LOGE(cJsonParsingTag, "조건이 부합하지 않습니다. (len : %zu)", len);
@@ -37,18 +56,61 @@ void parse_json_body(const char *body, size_t len, esp_http_client_handle_t clie
         return;
     }
 
-    cJSON *msg = cJSON_GetObjectItemCaseSensitive(root, "test_value");
-    if (cJSON_IsNumber(msg))
-    {
-        // int value = msg->valueint;
-        ESP_LOGI(cJsonParsingTag, "-----------------------\n valueInt : %d", msg->valueint);
-    }
-    else if (cJSON_IsString(msg))
+    for (int i = 0; i < OCR_FIELD_COUNT; i++)
     {
-        // int value = atoi(msg->valueint);
-        ESP_LOGI(cJsonParsingTag, "-----------------------\n valueString : %s", msg->valuestring);
+        cJSON *msg = cJSON_GetObjectItemCaseSensitive(root, ocr_field_name(i));
+        if (cJSON_IsString(msg))
+        {
+            ocr_resp_field(out, i, msg->valuestring, strlen(msg->valuestring), false);
+            ocr_resp_field(out, i, NULL, 0, true);
+        }
+        else if (cJSON_IsNumber(msg))
+        {
+            // 스트리밍 추출기처럼 숫자도 글자로 넘긴다 (원문이 아니라 cJSON이 다시 쓴 모양, 12.5e3 -> 12500)
+            char num[32];
+            if (cJSON_PrintPreallocated(msg, num, sizeof(num), false))
+            {
+                ocr_resp_field(out, i, num, strlen(num), false);
+                ocr_resp_field(out, i, NULL, 0, true);
+            }
+        }
     }
 
     cJSON_Delete(root);
     free(buffer);
 }
+
+/*
+스트리밍 추출기와 cJSON 방식 비교
+1. OCR 서버 응답과 같은 형태의 바디를
+2. esp_http_client_read 처럼 chunk 바이트씩 나눠 넣어 시간과 힙 사용량을 잰다
+*/
+void json_bench(int iterations, size_t chunk)
+{
+    const size_t len = strlen(json_bench_body);
+    ocr_resp_t r;
+
+    size_t heap_before = esp_get_free_heap_size();
+    size_t heap_min = heap_before;
+    int64_t t0 = esp_timer_get_time();
+    for (int n = 0; n < iterations; n++)
+    {
+        parse_json_body(json_bench_body, len, &r);
+        heap_min = MIN(heap_min, esp_get_free_heap_size());
+    }
+    int64_t t_cjson = esp_timer_get_time() - t0;
+    ocr_resp_t cjson_r = r;
+
+    int64_t t_stream = json_stream_bench(json_bench_body, len, iterations, chunk, &r);
+
+    bool same = t_stream >= 0;
+    for (int i = 0; i < OCR_FIELD_COUNT; i++)
+    {
+        same = same && strcmp(r.fields[i].text, cjson_r.fields[i].text) == 0;
+    }
+
+    ESP_LOGI(cJsonParsingTag, "JSON %zuB x %d회 (chunk %zuB)", len, iterations, chunk);
+    ESP_LOGI(cJsonParsingTag, "cJSON  : %" PRId64 " us/회, 힙 최대 %zuB", t_cjson / iterations, heap_before - heap_min);
+    ESP_LOGI(cJsonParsingTag, "stream : %" PRId64 " us/회, 힙 0B, 상태 %zuB", t_stream / iterations, sizeof(json_stream_t));
+    ESP_LOGI(cJsonParsingTag, "결과 일치 : %s", same ? "yes" : "no");
+}
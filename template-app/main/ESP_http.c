@@ -1,171 +1,403 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
 
-#include "header.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "esp_camera.h"
+#include "esp_camera_trace.h"
+#include "img_converters.h"
+#include "freertos/FreeRTOS.h"
 
-#define BUF_SIZE 1024             // 입력 버퍼 사이즈
-#define MAX_JSON_BODY (16 * 2024) // 서버 응답 메시지 제한
+#include "ESP_upload.h"
 
 static const char *sendPhotoTag = "Send_Photo";
-static const char *captureTag = "Capture";
-char *cJsonBuffer; // cJson 파싱 값 저장 버퍼
+static const char *uploadSessionTag = "Upload_Session";
 
-char url[128] = "http://192.168.1.51:5000/upload/"; // 서버 접속 URL
+#define UPLOAD_BOUNDARY "----ESP32CamBoundary1234" // 멀티파트에서 각 파트를 구분하는 구분자 문자열
+#define UPLOAD_RETRY_MAX 1                          // 재사용 연결이 끊겼을 때 새 연결로 다시 시도하는 횟수
 
 /*
-서버의
-1. 서버 URL
-2. json body 전용 버퍼
-3. 버퍼 사이즈
+업로드 세션은
+1. HTTP 클라이언트 핸들을 한 번만 만들고 (keep-alive)
+2. 사진마다 같은 TCP 연결로 POST를 보내며
+3. 서버가 연결을 닫았거나 전송이 실패하면 연결을 닫고 새로 맺는다
 */
 
-// 이미지 HTTP 전송
-int sendPhoto(const char *url, char *resp_buf, size_t resp_buf_sz)
+// 응답 헤더에서 서버가 연결을 닫겠다고 했는지 확인
+static esp_err_t upload_session_event_handler(esp_http_client_event_t *evt)
 {
-    int rc = ESP_FAIL;
-    camera_fb_t *pic = NULL;
-    esp_http_client_handle_t client = NULL;
+    upload_session_t *s = (upload_session_t *)evt->user_data;
 
-    // 카메라 사진 촬영
-    ESP_ERROR_CHECK(ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, 500));
-    ESP_ERROR_CHECK(ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1));
-    vTaskDelay(pdMS_TO_TICKS(50));
+    if (evt->event_id == HTTP_EVENT_ON_HEADER && s)
+    {
+        if (strcasecmp(evt->header_key, "Connection") == 0 && strcasecmp(evt->header_value, "close") == 0)
+        {
+            s->server_close = true;
+        }
+    }
+    else if (evt->event_id == HTTP_EVENT_DISCONNECTED && s)
+    {
+        s->connected = false;
+    }
+    return ESP_OK;
+}
 
-    pic = esp_camera_fb_get();
+esp_err_t upload_session_init(upload_session_t *s, const char *url)
+{
+    if (!s || !url)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(s, 0, sizeof(*s));
+    snprintf(s->url, sizeof(s->url), "%s", url);
 
-    ESP_ERROR_CHECK(ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, 0));
-    ESP_ERROR_CHECK(ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1));
+    // HTTP 클라이언트 준비 (세션이 살아있는 동안 계속 사용)
+    esp_http_client_config_t cfg = {
+        .url = s->url,
+        .method = HTTP_METHOD_POST,  // 전송 방식 (method에 POST)
+        .timeout_ms = 10000,         // waiting 시간
+        .keep_alive_enable = true,   // TCP keep-alive로 끊긴 연결을 빨리 감지
+        .event_handler = upload_session_event_handler,
+        .user_data = s,
+    };
 
-    if (!pic || !pic->buf || pic->len == 0)
+    s->client = esp_http_client_init(&cfg);
+    if (!s->client)
     {
-        ESP_LOGE(captureTag, "사진 촬영 실패");
-        rc = -1;
-        goto WRITE_FAIL;
+        ESP_LOGE(uploadSessionTag, "http client초기화 실패");
+        return ESP_FAIL;
     }
 
-    ESP_LOGI(captureTag, "사진이 찍혔습니다 ! / 사진 크기 : %zu", pic->len);
+    char ctype[128]; // HTTP 헤더 Content-Type에 넣을 문자열 버퍼이다
+    snprintf(ctype, sizeof(ctype), "multipart/form-data; boundary=%s", UPLOAD_BOUNDARY);
 
-    const char *boundary = "----ESP32CamBoundary1234"; // 멀티파트에서 각 파트를 구분하는 구분자 문자열
-    // 멀티파트의 앞 부분을 담음 (Boundary의 여러 정보들을 담으며 넉넉하게 확보)
-    char head[256];
-    // 멀티파트의 각 헤더로 서버가 읽을 필드명과 파일명을 지정함 (헤더와 바디 사이 빈 줄)
-    int head_len = snprintf(head, sizeof(head),
-                            "--%s\r\n"
-                            "Content-Disposition: form-data; name=\"image\"; filename=\"esp32-cam.jpg\"\r\n"
-                            "Content-Type: image/jpeg\r\n\r\n",
-                            boundary);
+    // 헤더는 핸들에 남아있으므로 한 번만 설정
+    esp_http_client_set_header(s->client, "Content-Type", ctype);
+    esp_http_client_set_header(s->client, "Accept", "application/json");
+    esp_http_client_set_header(s->client, "Accept-Encoding", "identity");
+    esp_http_client_set_header(s->client, "Connection", "keep-alive");
 
-    // 멀티파이트를 닫는 부분이라 짧음 (넉넉하게 확보)
-    char tail[64];
-    int tail_len = snprintf(tail, sizeof(tail), "\r\n--%s--\r\n", boundary);
+    return ESP_OK;
+}
 
-    if (head_len <= 0 || tail_len <= 0)
+void upload_session_deinit(upload_session_t *s)
+{
+    if (!s || !s->client)
     {
-        ESP_LOGE(sendPhotoTag, "snprintf 실패");
-        rc = -2;
-        goto WRITE_FAIL;
+        return;
     }
 
-    // 콘텐츠의 총 크기 (보내는 크기 + 사진 크기 + 보내기 종료 크기)
-    size_t content_len = (size_t)head_len + pic->len + (size_t)tail_len;
+    ESP_LOGI(uploadSessionTag, "업로드 %d회 / TCP 연결 %d회", s->uploads, s->connects);
+    esp_http_client_close(s->client);
+    esp_http_client_cleanup(s->client);
+    s->client = NULL;
+    s->connected = false;
+}
 
-    // HTTP 클라이언트 준비
-    esp_http_client_config_t cfg = {
-        .url = url,
-        .method = HTTP_METHOD_POST, // 전송 방식 (method에 POST)
-        .timeout_ms = 10000,        // waiting 시간
-        .keep_alive_enable = false, // 메모리 누수 방지용으로 끔
-    };
+// 소켓을 닫아 다음 open에서 새 TCP 연결을 맺도록 함 (핸들과 헤더는 유지)
+static void upload_session_drop(upload_session_t *s)
+{
+    esp_http_client_close(s->client);
+    s->connected = false;
+}
 
-    // HTTP Client 초기화
-    client = esp_http_client_init(&cfg);
-    if (!client)
+// 멀티파트의 앞/뒷 부분 (서버가 읽을 필드명과 파일명, 헤더와 바디 사이 빈 줄)
+static const char s_multipart_head[] = "--" UPLOAD_BOUNDARY "\r\n"
+                                       "Content-Disposition: form-data; name=\"image\"; filename=\"esp32-cam.jpg\"\r\n"
+                                       "Content-Type: image/jpeg\r\n\r\n";
+static const char s_multipart_tail[] = "\r\n--" UPLOAD_BOUNDARY "--\r\n";
+
+/*
+바디 writer
+- Content-Length를 아는 경우 받은 조각을 그대로 소켓에 쓴다
+- 모르는 경우 (chunked) 조각마다 "크기\r\n 데이터 \r\n" 으로 감싸서 쓴다
+- 데이터는 복사하지 않고 호출자의 버퍼에서 바로 보낸다
+*/
+static bool body_writer_raw(body_writer_t *w, const void *data, size_t len)
+{
+    if (len && esp_http_client_write(w->client, (const char *)data, len) != (int)len)
     {
-        ESP_LOGI(sendPhotoTag, "http client초기화 실패");
-        goto WRITE_FAIL;
-        return -3;
+        w->failed = true;
     }
+    return !w->failed;
+}
 
-    // 헤더 설정
-    esp_http_client_set_method(client, HTTP_METHOD_POST);
-    char ctype[128]; // HTTP 헤더 Content-Type에 넣을 문자열 버퍼이다
-    // (결과 문자열을 쓸 목적지 버퍼, 버퍼의 최대 크기, 출력 템플릿)
-    snprintf(ctype, sizeof(ctype), "multipart/form-data; boundary=%s", boundary);
+// 여러 조각을 하나의 chunk로 보냄 (scatter-gather)
+bool body_writer_writev(body_writer_t *w, const body_seg_t *segs, int count)
+{
+    size_t total = 0;
+    for (int i = 0; i < count; i++)
+    {
+        total += segs[i].len;
+    }
+    if (w->failed || total == 0)
+    {
+        return !w->failed;
+    }
 
-    // 서버에게 (바디가 멀티파트임을 알림, 경계값 제공, Content-Type 헤더 값) 를 넘김
-    esp_http_client_set_header(client, "Content-Type", ctype);
-    esp_http_client_set_header(client, "Accept", "application/json");
-    esp_http_client_set_header(client, "Accept-Encoding", "identity");
-    esp_http_client_set_header(client, "Connection", "close");
+    if (w->chunked)
+    {
+        char size_line[12];
+        int n = snprintf(size_line, sizeof(size_line), "%x\r\n", (unsigned)total);
+        body_writer_raw(w, size_line, n);
+    }
+    for (int i = 0; i < count && !w->failed; i++)
+    {
+        body_writer_raw(w, segs[i].data, segs[i].len);
+    }
+    if (w->chunked)
+    {
+        body_writer_raw(w, "\r\n", 2);
+    }
 
-    // 서버와 TCP 연결을 맺고, 요청 라인 헤더 정보들을 보낼 준비를 한다
-    esp_err_t err = esp_http_client_open(client, content_len);
+    if (!w->failed)
+    {
+        w->sent += total;
+    }
+    return !w->failed;
+}
+
+bool body_writer_write(body_writer_t *w, const void *data, size_t len)
+{
+    body_seg_t seg = {.data = data, .len = len};
+    return body_writer_writev(w, &seg, 1);
+}
+
+// chunked 바디의 끝 (크기 0 chunk)
+bool body_writer_finish(body_writer_t *w)
+{
+    if (w->chunked)
+    {
+        body_writer_raw(w, "0\r\n\r\n", 5);
+    }
+    return !w->failed;
+}
 
+// fmt2jpg_cb / frame2jpg_cb 용 출력 콜백 (arg는 body_writer_t). 인코더가 만든 조각을 그대로 소켓으로 보낸다
+size_t body_writer_jpg_cb(void *arg, size_t index, const void *data, size_t len)
+{
+    body_writer_t *w = (body_writer_t *)arg;
+    if (!data || len == 0) // 인코딩 끝
+    {
+        return 0;
+    }
+    return body_writer_write(w, data, len) ? len : 0;
+}
+
+/*
+한 번의 POST (연결이 살아있다면 재사용)
+1. body_len이 음수면 chunked 전송
+2. source가 멀티파트 사이의 사진 바디를 writer로 흘려보낸다
+3. 바디가 서버에 가기 전에 실패했으면 *retry = true (open 실패나 첫 write 실패만, 다시 보내도 중복 업로드가 안 됨)
+*/
+static int upload_session_post(upload_session_t *s, body_source_cb source, void *arg, int body_len,
+                               json_stream_t *resp_parser, bool *retry)
+{
+    *retry = false;
+
+    // 콘텐츠의 총 크기 (보내는 크기 + 사진 크기 + 보내기 종료 크기)
+    int content_len = -1;
+    if (body_len >= 0)
+    {
+        content_len = (int)(sizeof(s_multipart_head) - 1) + body_len + (int)(sizeof(s_multipart_tail) - 1);
+    }
+
+    if (!s->connected)
+    {
+        s->connects++;
+    }
+    s->server_close = false;
+
+    // open은 Content-Length나 Transfer-Encoding 중 하나만 설정하고 다른 하나를 지우지 않는다
+    // 같은 핸들로 두 방식을 번갈아 쓰면 두 헤더가 같이 나가므로, 이번 요청에 안 쓰는 쪽을 먼저 지운다
+    esp_http_client_delete_header(s->client, content_len < 0 ? "Content-Length" : "Transfer-Encoding");
+
+    // 연결이 없으면 TCP 연결을 맺고, 있으면 요청 라인과 헤더만 보낸다 (-1이면 Transfer-Encoding: chunked)
+    CAM_TRACE_BEGIN("http open");
+    esp_err_t err = esp_http_client_open(s->client, content_len);
+    CAM_TRACE_END("http open");
     if (err != ESP_OK)
     {
-        ESP_LOGI(sendPhotoTag, "open 실패 %s", esp_err_to_name(err));
-        goto WRITE_FAIL; // 클라이언트 핸들 정리 (소켓 닫기, 내부 버퍼, 메모리 해제)
+        ESP_LOGE(sendPhotoTag, "open 실패 %s", esp_err_to_name(err));
+        *retry = true;
         return -4;
-    } // 헤더 설정 코드 주석 & 이해 필요한 것 정리
+    }
+    s->connected = true;
 
-    if (esp_http_client_write(client, head, head_len) != head_len)
+    body_writer_t w = {
+        .client = s->client,
+        .chunked = content_len < 0,
+    };
+    CAM_TRACE_BEGIN("http write head");
+    if (!body_writer_write(&w, s_multipart_head, sizeof(s_multipart_head) - 1))
     {
-        rc = -5;
-        goto WRITE_FAIL;
+        CAM_TRACE_END("http write head");
+        *retry = true;
+        return -5;
     }
-    if (esp_http_client_write(client, (const char *)pic->buf, pic->len) != pic->len)
+    CAM_TRACE_END("http write head");
+    CAM_TRACE_BEGIN("http write body");
+    if (!w.failed && !source(&w, arg))
     {
-        rc = -5;
-        goto WRITE_FAIL;
+        w.failed = true;
     }
-    if (esp_http_client_write(client, tail, tail_len) != tail_len)
+    CAM_TRACE_END("http write body");
+    CAM_TRACE_BEGIN("http write tail");
+    body_writer_write(&w, s_multipart_tail, sizeof(s_multipart_tail) - 1);
+    bool finished = body_writer_finish(&w);
+    CAM_TRACE_END("http write tail");
+    if (!finished)
     {
-        rc = -5;
-        goto WRITE_FAIL;
+        return -5;
     }
+    s->last_body_len = w.sent;
 
-    esp_http_client_fetch_headers(client);
+    // 서버 처리 시간(OCR)이 대부분 여기서 보인다
+    CAM_TRACE_BEGIN("http fetch headers");
+    int64_t header_len = esp_http_client_fetch_headers(s->client);
+    CAM_TRACE_END("http fetch headers");
+    if (header_len < 0)
+    {
+        // 바디는 다 보냈으므로 서버가 이미 처리했을 수 있다 -> 다시 보내지 않음
+        return -6;
+    }
 
-    // 응답 바디를 resp_buf로 읽기
-    int total = 0;
+    // 응답 바디를 도착하는 대로 파서에 넘긴다 (전체 바디를 모으지 않고, 남은 부분도 끝까지 읽어 연결을 비운다)
+    char chunk[128];
+    CAM_TRACE_BEGIN("http read");
     while (1)
     {
-        int r = esp_http_client_read(client, resp_buf + total, (int)resp_buf_sz - 1 - total);
+        int r = esp_http_client_read(s->client, chunk, sizeof(chunk));
         if (r <= 0)
             break;
-        total += r;
-        if ((size_t)total >= resp_buf_sz - 1)
-            break;
+        if (resp_parser)
+            json_stream_feed(resp_parser, chunk, r);
     }
-    resp_buf[total] = '\0';
-    ESP_LOGI(sendPhotoTag, "RAW JSON (%dB): %.*s", total, total, resp_buf);
+    CAM_TRACE_END("http read");
+    if (resp_parser && !json_stream_done(resp_parser))
+    {
+        ESP_LOGW(sendPhotoTag, "응답 JSON이 완전하지 않습니다");
+    }
+
+    int status = esp_http_client_get_status_code(s->client);
+    if (!esp_http_client_is_complete_data_received(s->client) || s->server_close)
+    {
+        // 응답을 끝까지 못 읽었거나 서버가 닫겠다고 하면 다음 업로드는 새 연결로
+        upload_session_drop(s);
+    }
+
+    s->uploads++;
+    return status;
+}
 
-    parse_json_body(resp_buf, total, client);
-    rc = ESP_OK;
+/*
+세션으로 바디를 스트리밍 업로드 (chunked)
+1. 세션
+2. 사진 바디를 writer로 흘려보내는 콜백과 인자 (재연결 시 한 번 더 불릴 수 있음)
+3. 응답 JSON 파서 (NULL이면 응답은 읽고 버림)
+반환값은 HTTP status 코드 (실패 시 음수)
+*/
+int upload_session_send_stream(upload_session_t *s, body_source_cb source, void *arg,
+                               json_stream_t *resp_parser)
+{
+    return upload_session_send_body(s, source, arg, -1, resp_parser);
+}
 
-WRITE_FAIL: // 모든 설정들을 종료
-    if (client)
+int upload_session_send_body(upload_session_t *s, body_source_cb source, void *arg, int body_len,
+                             json_stream_t *resp_parser)
+{
+    if (!s || !s->client || !source)
     {
-        esp_http_client_close(client);
-        esp_http_client_cleanup(client);
+        return -1;
     }
-    if (pic)
+
+    int rc = -1;
+    for (int attempt = 0; attempt <= UPLOAD_RETRY_MAX; attempt++)
     {
-        esp_camera_fb_return(pic);
+        bool reused = s->connected;
+        bool retry;
+        rc = upload_session_post(s, source, arg, body_len, resp_parser, &retry);
+        if (rc > 0)
+        {
+            break;
+        }
+
+        // 실패한 연결은 정리하고, 재사용하던 연결이 바디를 보내기 전에 끊긴 경우에만 새 연결로 다시 보낸다
+        upload_session_drop(s);
+        if (!reused || !retry)
+        {
+            break;
+        }
+        ESP_LOGW(uploadSessionTag, "재사용 연결 끊김 (%d) -> 다시 연결", rc);
     }
     return rc;
 }
 
-void app_main(void)
+static bool seg_source(body_writer_t *w, void *arg)
 {
+    return body_writer_write(w, ((body_seg_t *)arg)->data, ((body_seg_t *)arg)->len);
+}
 
-    char resp[256];
-    int code = sendPhoto(url, resp, sizeof(resp));
+/*
+세션으로 JPEG 하나를 업로드 (크기를 알고 있으므로 Content-Length 사용)
+1. 세션
+2. JPEG 버퍼와 크기
+3. 응답 JSON 파서 (NULL이면 응답은 읽고 버림)
+반환값은 HTTP status 코드 (실패 시 음수)
+*/
+int upload_session_send(upload_session_t *s, const uint8_t *jpg, size_t jpg_len,
+                        json_stream_t *resp_parser)
+{
+    if (!jpg || jpg_len == 0)
+    {
+        return -1;
+    }
+
+    body_seg_t seg = {.data = jpg, .len = jpg_len};
+    return upload_session_send_body(s, seg_source, &seg, (int)jpg_len, resp_parser);
+}
+
+typedef struct
+{
+    camera_fb_t *fb;
+    uint8_t quality;
+} frame_source_arg_t;
+
+// JPEG가 아닌 프레임은 인코더 출력을 PSRAM에 모으지 않고 바로 소켓으로 보낸다
+// 위아래 띠로 나눠 두 코어에서 인코딩 (첫 띠는 바로 소켓으로, 나머지 띠는 끝날 때까지 버퍼에 모아 순서대로 전송)
+static bool frame_source(body_writer_t *w, void *arg)
+{
+    frame_source_arg_t *a = (frame_source_arg_t *)arg;
+    camera_fb_t *fb = a->fb;
+    jpg_encoder_config_t config = JPG_ENCODER_CONFIG_DEFAULT(a->quality);
+    config.bands = UPLOAD_JPEG_BANDS;
+    config.profile = UPLOAD_JPEG_PROFILE;
+    config.optimize_huffman = UPLOAD_JPEG_OPTIMIZE_HUFFMAN;
+    return fmt2jpg_cb_ex(fb->buf, fb->len, fb->width, fb->height, fb->format, &config, body_writer_jpg_cb, w);
+}
 
-    if (code >= 200 && code < 300)
+// 카메라 프레임 업로드 (JPEG면 그대로, 아니면 인코딩하면서 chunked로 전송)
+int upload_session_send_frame(upload_session_t *s, camera_fb_t *fb, uint8_t quality,
+                              json_stream_t *resp_parser)
+{
+    if (!fb || !fb->buf || fb->len == 0)
     {
-        ESP_LOGI(sendPhotoTag, "업로드 성공 %d", code);
+        return -1;
     }
-    else
+    if (fb->format == PIXFORMAT_JPEG)
     {
-        ESP_LOGI(sendPhotoTag, "업로드 실패 %d", code);
+        // EOI 없이 끊긴 프레임은 서버에서 디코딩할 수 없으므로 보내지 않는다
+        if (fb->partial)
+        {
+            ESP_LOGW(sendPhotoTag, "잘린 JPEG 프레임 (%zuB), 업로드 생략", fb->len);
+            return -1;
+        }
+        return upload_session_send(s, fb->buf, fb->len, resp_parser);
     }
+
+    frame_source_arg_t arg = {.fb = fb, .quality = quality};
+    return upload_session_send_stream(s, frame_source, &arg, resp_parser);
 }
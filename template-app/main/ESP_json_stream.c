@@ -0,0 +1,481 @@
+#include <string.h>
+#include <sys/param.h>
+
+#include "esp_timer.h"
+#include "ESP_json_stream.h"
+
+// OCR 서버 응답에서 꺼낼 키 (ocr_field_id_t 순서와 같음)
+static const char *const s_ocr_keys[OCR_FIELD_COUNT] = {"value", "ocr_result", "error"};
+
+const char json_bench_body[] =
+    "{\"test_value\": 1331231, \"value\": \"0012345\", \"message\": \"\\uc800\\uc7a5 \\ubc0f OCR \\uc644\\ub8cc\", "
+    "\"filename\": \"esp32-cam_20241017_101010_123456.jpg\", \"path\": \"/uploads/esp32-cam_20241017_101010_123456.jpg\", "
+    "\"meta\": {\"size\": [800, 600], \"note\": \"a \\\"quoted\\\" }\"}, \"ocr_result\": \"0012345\"}";
+
+/*
+스트리밍 JSON 키 추출기
+1. esp_http_client_read로 받은 조각을 도착하는 대로 넣는다 (전체 바디를 모으지 않음)
+2. 최상위 객체의 키 중 찾는 키의 값만 콜백으로 넘긴다 (길이 제한 없음, 동적 할당 없음)
+3. 문자열 값은 이스케이프를 풀어서, 숫자/객체/배열 값은 원문 그대로 넘긴다
+4. 키도 이스케이프를 풀어서 비교한다 ("value" 는 "value")
+5. 잘못된 이스케이프와 짝이 맞지 않는 서로게이트는 cJSON 처럼 형식 오류
+*/
+enum
+{
+    JS_START,     // '{' 대기
+    JS_OBJ,       // 첫 키의 '"' 또는 '}' 대기
+    JS_KEY_START, // ',' 뒤 키의 '"' 대기
+    JS_KEY,       // 키 문자열
+    JS_KEY_ESC,   // 키 안의 '\' 다음 글자
+    JS_KEY_U,     // 키 안의 \uXXXX 의 16진수 4자리
+    JS_COLON,     // ':' 대기
+    JS_VALUE,     // 값 시작 대기
+    JS_STR,       // 문자열 값
+    JS_STR_ESC,   // 문자열 값 안의 '\' 다음 글자
+    JS_STR_U,     // \uXXXX 의 16진수 4자리
+    JS_PRIM,      // 숫자, true, false, null
+    JS_NESTED,    // 중첩 객체/배열 (깊이만 따라감)
+    JS_NEXT,      // ',' 또는 '}' 대기
+    JS_DONE,
+    JS_ERROR,
+};
+
+static bool json_is_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+void json_stream_init(json_stream_t *js, const char *const *keys, int key_count, json_field_cb cb, void *arg)
+{
+    memset(js, 0, sizeof(*js));
+    js->keys = keys;
+    js->key_count = key_count;
+    js->cb = cb;
+    js->arg = arg;
+    js->state = JS_START;
+    js->match = -1;
+}
+
+bool json_stream_done(const json_stream_t *js)
+{
+    return js->state == JS_DONE;
+}
+
+static void json_key_push(json_stream_t *js, const char *data, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (js->key_len < JSON_KEY_MAX - 1)
+        {
+            js->key[js->key_len++] = data[i];
+        }
+        else
+        {
+            js->key_long = true; // 찾는 키보다 긴 키는 절대 일치하지 않음
+        }
+    }
+}
+
+static int json_key_match(json_stream_t *js)
+{
+    if (js->key_long)
+    {
+        return -1;
+    }
+    js->key[js->key_len] = '\0';
+    for (int i = 0; i < js->key_count; i++)
+    {
+        if (strcmp(js->key, js->keys[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 찾는 키의 값이면 [from, to) 구간을 복사 없이 넘긴다
+static void json_emit(json_stream_t *js, const char *from, const char *to)
+{
+    if (js->match >= 0 && from && to > from)
+    {
+        js->cb(js->arg, js->match, from, to - from, false);
+    }
+}
+
+static void json_value_end(json_stream_t *js)
+{
+    if (js->match >= 0)
+    {
+        js->cb(js->arg, js->match, NULL, 0, true);
+    }
+    js->state = JS_NEXT;
+}
+
+static int json_utf8(uint32_t cp, char *out)
+{
+    if (cp < 0x80)
+    {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/*
+\uXXXX 하나를 UTF-8로 (out에 *n 바이트, 형식 오류면 false)
+- 서로게이트 앞부분(D800~DBFF)은 u_high에 두고 바로 뒤의 \uDCxx 와 합쳐서 출력
+- 뒷부분 없는 앞부분, 앞부분 없는 뒷부분은 cJSON 과 같이 오류
+*/
+static bool json_codepoint(json_stream_t *js, uint32_t cp, char *out, int *n)
+{
+    *n = 0;
+    if (js->u_high)
+    {
+        if (cp < 0xDC00 || cp > 0xDFFF)
+        {
+            return false;
+        }
+        cp = 0x10000 + ((js->u_high - 0xD800) << 10) + (cp - 0xDC00);
+        js->u_high = 0;
+    }
+    else if (cp >= 0xD800 && cp <= 0xDBFF)
+    {
+        js->u_high = cp;
+        return true;
+    }
+    else if (cp >= 0xDC00 && cp <= 0xDFFF)
+    {
+        return false;
+    }
+    *n = json_utf8(cp, out);
+    return true;
+}
+
+// '\' 다음 글자 (JSON에 없는 이스케이프면 -1)
+static int json_unescape(char c)
+{
+    switch (c)
+    {
+    case '"':
+    case '\\':
+    case '/':
+        return c;
+    case 'n':
+        return '\n';
+    case 't':
+        return '\t';
+    case 'r':
+        return '\r';
+    case 'b':
+        return '\b';
+    case 'f':
+        return '\f';
+    default:
+        return -1;
+    }
+}
+
+static int json_hex(char c)
+{
+    return (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+}
+
+/*
+\uXXXX 의 16진수 한 자리 (4자리가 모이면 out에 UTF-8 *n 바이트)
+- 숫자가 아니거나 서로게이트 짝이 틀리면 false
+*/
+static bool json_u_digit(json_stream_t *js, char c, char *out, int *n)
+{
+    int d = json_hex(c);
+    *n = 0;
+    if (d < 0)
+    {
+        return false;
+    }
+    js->u_val = (js->u_val << 4) | d;
+    if (++js->u_count < 4)
+    {
+        return true;
+    }
+    js->u_count = 0;
+    return json_codepoint(js, js->u_val, out, n);
+}
+
+// 조각 하나를 처리 (형식이 틀리면 false)
+bool json_stream_feed(json_stream_t *js, const char *data, size_t len)
+{
+    // 값 중간에서 조각이 끝났으면 새 조각의 처음부터 이어서 넘긴다
+    const char *span = (js->state == JS_STR || js->state == JS_PRIM || js->state == JS_NESTED) ? data : NULL;
+    char out[4];
+    int n;
+
+    for (size_t i = 0; i < len && js->state < JS_DONE; i++)
+    {
+        char c = data[i];
+        switch (js->state)
+        {
+        case JS_START:
+            if (c == '{')
+                js->state = JS_OBJ;
+            else if (!json_is_ws(c))
+                js->state = JS_ERROR;
+            break;
+
+        case JS_OBJ:
+        case JS_KEY_START:
+            if (c == '"')
+            {
+                js->key_len = 0;
+                js->key_long = false;
+                js->state = JS_KEY;
+            }
+            else if (c == '}' && js->state == JS_OBJ)
+                js->state = JS_DONE;
+            else if (!json_is_ws(c))
+                js->state = JS_ERROR;
+            break;
+
+        case JS_KEY:
+            if (js->u_high && c != '\\')
+                js->state = JS_ERROR; // 서로게이트 뒷부분이 없음
+            else if (c == '"')
+                js->state = JS_COLON;
+            else if (c == '\\')
+                js->state = JS_KEY_ESC;
+            else
+                json_key_push(js, &c, 1);
+            break;
+
+        case JS_KEY_ESC:
+            if (c == 'u')
+            {
+                js->u_count = 0;
+                js->u_val = 0;
+                js->state = JS_KEY_U;
+            }
+            else if (js->u_high || json_unescape(c) < 0)
+                js->state = JS_ERROR;
+            else
+            {
+                c = (char)json_unescape(c);
+                json_key_push(js, &c, 1);
+                js->state = JS_KEY;
+            }
+            break;
+
+        case JS_KEY_U:
+            if (!json_u_digit(js, c, out, &n))
+                js->state = JS_ERROR;
+            else if (js->u_count == 0)
+            {
+                json_key_push(js, out, n);
+                js->state = JS_KEY;
+            }
+            break;
+
+        case JS_COLON:
+            if (c == ':')
+            {
+                js->match = json_key_match(js);
+                js->state = JS_VALUE;
+            }
+            else if (!json_is_ws(c))
+                js->state = JS_ERROR;
+            break;
+
+        case JS_VALUE:
+            if (json_is_ws(c))
+                break;
+            if (c == '"')
+            {
+                js->state = JS_STR;
+                span = data + i + 1;
+            }
+            else if (c == '{' || c == '[')
+            {
+                js->depth = 1;
+                js->in_str = false;
+                js->esc = false;
+                js->state = JS_NESTED;
+                span = data + i;
+            }
+            else if (c == ',' || c == '}' || c == ']' || c == ':')
+                js->state = JS_ERROR;
+            else
+            {
+                js->state = JS_PRIM;
+                span = data + i;
+            }
+            break;
+
+        case JS_STR:
+            if (js->u_high && c != '\\')
+                js->state = JS_ERROR; // 서로게이트 뒷부분이 없음
+            else if (c == '"')
+            {
+                json_emit(js, span, data + i);
+                span = NULL;
+                json_value_end(js);
+            }
+            else if (c == '\\')
+            {
+                json_emit(js, span, data + i);
+                span = NULL;
+                js->state = JS_STR_ESC;
+            }
+            break;
+
+        case JS_STR_ESC:
+            if (c == 'u')
+            {
+                js->u_count = 0;
+                js->u_val = 0;
+                js->state = JS_STR_U;
+                break;
+            }
+            if (js->u_high || json_unescape(c) < 0)
+            {
+                js->state = JS_ERROR;
+                break;
+            }
+            c = (char)json_unescape(c);
+            json_emit(js, &c, &c + 1);
+            js->state = JS_STR;
+            span = data + i + 1;
+            break;
+
+        case JS_STR_U:
+            if (!json_u_digit(js, c, out, &n))
+                js->state = JS_ERROR;
+            else if (js->u_count == 0)
+            {
+                json_emit(js, out, out + n);
+                js->state = JS_STR;
+                span = data + i + 1;
+            }
+            break;
+
+        case JS_PRIM:
+            if (c == ',' || c == '}' || json_is_ws(c))
+            {
+                json_emit(js, span, data + i);
+                span = NULL;
+                json_value_end(js);
+                if (c == ',')
+                    js->state = JS_KEY_START;
+                else if (c == '}')
+                    js->state = JS_DONE;
+            }
+            break;
+
+        case JS_NESTED:
+            if (js->in_str)
+            {
+                if (js->esc)
+                    js->esc = false;
+                else if (c == '\\')
+                    js->esc = true;
+                else if (c == '"')
+                    js->in_str = false;
+            }
+            else if (c == '"')
+                js->in_str = true;
+            else if (c == '{' || c == '[')
+                js->depth++;
+            else if ((c == '}' || c == ']') && --js->depth == 0)
+            {
+                json_emit(js, span, data + i + 1);
+                span = NULL;
+                json_value_end(js);
+            }
+            break;
+
+        case JS_NEXT:
+            if (c == ',')
+                js->state = JS_KEY_START;
+            else if (c == '}')
+                js->state = JS_DONE;
+            else if (!json_is_ws(c))
+                js->state = JS_ERROR;
+            break;
+        }
+    }
+
+    if (js->state == JS_STR || js->state == JS_PRIM || js->state == JS_NESTED)
+    {
+        json_emit(js, span, data + len);
+    }
+    return js->state != JS_ERROR;
+}
+
+const char *ocr_field_name(int key)
+{
+    return s_ocr_keys[key];
+}
+
+// OCR 필드 저장 (버퍼보다 긴 값은 잘라서 저장하고 len에는 전체 길이를 남김)
+void ocr_resp_field(void *arg, int key, const char *data, size_t len, bool done)
+{
+    ocr_field_t *f = &((ocr_resp_t *)arg)->fields[key];
+
+    f->found = true;
+    if (done)
+    {
+        return;
+    }
+    if (f->len < OCR_FIELD_MAX - 1)
+    {
+        size_t n = MIN(len, OCR_FIELD_MAX - 1 - f->len);
+        memcpy(f->text + f->len, data, n);
+        f->text[f->len + n] = '\0';
+    }
+    f->len += len;
+}
+
+// 응답을 받기 전에 결과와 파서를 함께 초기화
+void ocr_resp_begin(ocr_resp_t *r, json_stream_t *js)
+{
+    memset(r, 0, sizeof(*r));
+    json_stream_init(js, s_ocr_keys, OCR_FIELD_COUNT, ocr_resp_field, r);
+}
+
+/*
+스트리밍 추출기 시간 측정 (json_bench 와 호스트 벤치마크가 함께 사용)
+1. body를 esp_http_client_read 처럼 chunk 바이트씩 나눠 넣기를 iterations 번
+2. 마지막 결과는 out에 (형식 오류나 끝나지 않은 바디면 -1)
+3. 걸린 시간 (us)
+*/
+int64_t json_stream_bench(const char *body, size_t len, int iterations, size_t chunk, ocr_resp_t *out)
+{
+    json_stream_t js;
+    bool ok = true;
+
+    int64_t t0 = esp_timer_get_time();
+    for (int n = 0; n < iterations; n++)
+    {
+        ocr_resp_begin(out, &js);
+        for (size_t off = 0; off < len; off += chunk)
+        {
+            ok = json_stream_feed(&js, body + off, MIN(chunk, len - off)) && ok;
+        }
+    }
+    int64_t elapsed = esp_timer_get_time() - t0;
+    return ok && json_stream_done(&js) ? elapsed : -1;
+}
@@ -0,0 +1,71 @@
+// ESP_json_stream.h
+#ifndef ESP_JSON_STREAM_H
+#define ESP_JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_KEY_MAX 32   // 스트리밍 JSON 추출기가 비교하는 키의 최대 길이
+#define OCR_FIELD_MAX 64  // OCR 응답 필드별로 저장하는 최대 길이
+
+// 찾는 키의 값 조각을 받는 콜백 (값이 끝나면 data == NULL, done == true로 한 번 더 호출)
+typedef void (*json_field_cb)(void *arg, int key_index, const char *data, size_t len, bool done);
+
+// 스트리밍 JSON 키 추출기 상태 (ESP_json_stream.c)
+typedef struct
+{
+    const char *const *keys; // 찾을 최상위 키 목록
+    int key_count;
+    json_field_cb cb;
+    void *arg;
+    uint8_t state;
+    int8_t match;            // 지금 읽는 값의 키 번호 (-1이면 찾는 키가 아님)
+    uint8_t key_len;
+    bool key_long;           // 키가 JSON_KEY_MAX 보다 김
+    bool in_str;             // 중첩 값 안의 문자열
+    bool esc;                // 중첩 값 안의 '\'
+    uint8_t u_count;         // \uXXXX 에서 읽은 자릿수
+    uint16_t u_val;
+    uint16_t u_high;         // 서로게이트 쌍의 앞부분 (바로 뒤에 \uDCxx 가 와야 함)
+    uint16_t depth;          // 중첩 값 깊이
+    char key[JSON_KEY_MAX];
+} json_stream_t;
+
+// OCR 서버 응답에서 꺼내는 필드
+typedef enum
+{
+    OCR_FIELD_VALUE,
+    OCR_FIELD_RESULT,
+    OCR_FIELD_ERROR,
+    OCR_FIELD_COUNT,
+} ocr_field_id_t;
+
+typedef struct
+{
+    bool found;
+    size_t len;               // 값의 전체 길이 (OCR_FIELD_MAX 이상이면 text는 잘린 것)
+    char text[OCR_FIELD_MAX];
+} ocr_field_t;
+
+typedef struct
+{
+    ocr_field_t fields[OCR_FIELD_COUNT];
+} ocr_resp_t;
+
+// OCR 서버 응답과 같은 형태의 바디 (json_bench, 호스트 bench_json_stream.c)
+extern const char json_bench_body[];
+
+// 스트리밍 추출기와 OCR 필드 (ESP_json_stream.c, ESP-IDF 없이 호스트에서도 빌드)
+void json_stream_init(json_stream_t *js, const char *const *keys, int key_count, json_field_cb cb, void *arg);
+bool json_stream_feed(json_stream_t *js, const char *data, size_t len);
+bool json_stream_done(const json_stream_t *js);
+const char *ocr_field_name(int key);
+void ocr_resp_field(void *arg, int key, const char *data, size_t len, bool done);
+void ocr_resp_begin(ocr_resp_t *r, json_stream_t *js);
+int64_t json_stream_bench(const char *body, size_t len, int iterations, size_t chunk, ocr_resp_t *out);
+
+// 결과 출력 (ESP_cJson.c)
+void ocr_resp_log(const ocr_resp_t *r);
+
+#endif
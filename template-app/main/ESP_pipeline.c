@@ -0,0 +1,346 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_camera.h"
+#include "esp_camera_trace.h"
+#include "driver/ledc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "ESP_pipeline.h"
+#include "ESP_roi.h"
+
+static const char *pipelineTag = "Pipeline";
+
+#define PIPELINE_CAPTURE_STACK 4096
+#define PIPELINE_UPLOAD_STACK 8192
+#define PIPELINE_PARSE_STACK 4096
+#define PIPELINE_RESP_QUEUE_LEN 2 // 파싱 대기 응답 수
+#define PIPELINE_STATS_EVERY 10   // 몇 장마다 통계를 찍을지
+
+/*
+촬영 -> 업로드(응답 파싱 포함) -> 결과 처리를 각각의 태스크로 나눈 파이프라인
+1. capture 태스크는 프레임 슬롯(크레딧)을 얻어야만 사진을 찍는다 (back-pressure)
+2. upload 태스크가 프레임을 보내고 esp_camera_fb_return 한 뒤 슬롯을 돌려준다
+3. 그래서 N번째 사진을 업로드하는 동안 N+1번째 사진을 찍을 수 있다
+*/
+
+// upload -> parse 로 넘기는 응답 (큐에 값으로 복사됨)
+typedef struct
+{
+    int status;                     // HTTP status (실패 시 음수)
+    uint32_t seq;                   // 프레임 번호
+    ocr_resp_t ocr;                 // 업로드하면서 바로 꺼낸 OCR 필드
+} pipeline_resp_t;
+
+// capture -> upload 로 넘기는 프레임
+typedef struct
+{
+    camera_fb_t *fb;
+    uint32_t seq;
+    int64_t captured_us; // esp_camera_fb_get 이 돌아온 시점
+} pipeline_frame_t;
+
+static QueueHandle_t s_frame_q;      // capture -> upload
+static QueueHandle_t s_resp_q;       // upload -> parse
+static SemaphoreHandle_t s_slots;    // 촬영 가능한 프레임 슬롯 수 (frame 큐 길이와 같음)
+static SemaphoreHandle_t s_trigger;  // 요청된 촬영 횟수
+static upload_session_t *s_session;
+static pipeline_stats_t s_stats;
+static portMUX_TYPE s_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static camera_latency_hist_t s_queue_lat;  // 촬영 -> 업로드 시작 (프레임 큐 대기)
+static camera_latency_hist_t s_upload_lat; // 업로드 + 응답 수신
+
+static void flash_set(bool on)
+{
+    ESP_ERROR_CHECK(ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, on ? 500 : 0));
+    ESP_ERROR_CHECK(ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1));
+}
+
+static void capture_task(void *arg)
+{
+    uint32_t seq = 0;
+
+    while (1)
+    {
+        xSemaphoreTake(s_trigger, portMAX_DELAY);
+        // 업로드가 밀려 있으면 여기서 대기 (카메라 버퍼를 붙잡지 않음)
+        xSemaphoreTake(s_slots, portMAX_DELAY);
+
+        int64_t t0 = esp_timer_get_time();
+        CAM_TRACE_BEGIN("capture");
+        flash_set(true);
+        vTaskDelay(pdMS_TO_TICKS(50));
+        camera_fb_t *fb = esp_camera_fb_get();
+        flash_set(false);
+        CAM_TRACE_END("capture");
+        int64_t t1 = esp_timer_get_time();
+
+        if (!fb || !fb->buf || fb->len == 0)
+        {
+            ESP_LOGE(pipelineTag, "사진 촬영 실패");
+            if (fb)
+            {
+                esp_camera_fb_return(fb);
+            }
+            xSemaphoreGive(s_slots);
+            continue;
+        }
+
+        pipeline_frame_t frame = {
+            .fb = fb,
+            .seq = seq++,
+            .captured_us = t1,
+        };
+
+        portENTER_CRITICAL(&s_stats_mux);
+        s_stats.captured++;
+        s_stats.capture_us += t1 - t0;
+        if (s_stats.first_capture_us == 0)
+        {
+            s_stats.first_capture_us = t0;
+        }
+        portEXIT_CRITICAL(&s_stats_mux);
+
+        // 슬롯을 얻었으므로 큐에는 항상 자리가 있다
+        xQueueSend(s_frame_q, &frame, portMAX_DELAY);
+    }
+}
+
+static void upload_task(void *arg)
+{
+    pipeline_frame_t frame;
+    pipeline_resp_t resp;
+    json_stream_t parser;
+
+    while (1)
+    {
+        xQueueReceive(s_frame_q, &frame, portMAX_DELAY);
+
+        int64_t t0 = esp_timer_get_time();
+        CAM_TRACE_BEGIN("upload");
+        resp.seq = frame.seq;
+        ocr_resp_begin(&resp.ocr, &parser);
+        camera_fb_t crop;
+        camera_fb_t *send = roi_frame(frame.fb, &crop); // 소프트웨어 ROI 모드면 잘라낸 복사본
+        resp.status = upload_session_send_frame(s_session, send, UPLOAD_JPEG_QUALITY, &parser);
+        if (send == &crop)
+        {
+            roi_crop_free(&crop);
+        }
+        CAM_TRACE_END("upload");
+        int64_t t1 = esp_timer_get_time();
+        esp_camera_latency_add(&s_queue_lat, t0 - frame.captured_us);
+        esp_camera_latency_add(&s_upload_lat, t1 - t0);
+
+        ESP_LOGI(pipelineTag, "#%" PRIu32 " %zuB -> HTTP %d (%" PRId64 " ms)", frame.seq, s_session->last_body_len, resp.status, (t1 - t0) / 1000);
+
+        // 프레임을 돌려주고 다음 촬영을 허용
+        esp_camera_fb_return(frame.fb);
+        xSemaphoreGive(s_slots);
+
+        portENTER_CRITICAL(&s_stats_mux);
+        if (resp.status > 0)
+        {
+            s_stats.uploaded++;
+            s_stats.bytes += s_session->last_body_len;
+        }
+        else
+        {
+            s_stats.failed++;
+        }
+        s_stats.upload_us += t1 - t0;
+        s_stats.queue_us += t0 - frame.captured_us;
+        s_stats.last_done_us = t1;
+        portEXIT_CRITICAL(&s_stats_mux);
+
+        if (resp.status <= 0)
+        {
+            continue;
+        }
+        // 파싱이 밀리면 업로드도 멈춘다
+        xQueueSend(s_resp_q, &resp, portMAX_DELAY);
+    }
+}
+
+static void parse_task(void *arg)
+{
+    pipeline_resp_t resp;
+
+    while (1)
+    {
+        xQueueReceive(s_resp_q, &resp, portMAX_DELAY);
+        ocr_resp_log(&resp.ocr);
+
+        if ((resp.seq + 1) % PIPELINE_STATS_EVERY == 0)
+        {
+            pipeline_log_stats();
+        }
+    }
+}
+
+/*
+파이프라인 시작
+1. 업로드 세션 (upload 태스크만 사용)
+2. 촬영-업로드 사이 프레임 큐 길이 (fb_count 와 같게, 2 이상이어야 촬영과 업로드가 겹침)
+*/
+esp_err_t pipeline_start(upload_session_t *session, int frame_queue_len)
+{
+    if (!session || frame_queue_len <= 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_session = session;
+    memset(&s_stats, 0, sizeof(s_stats));
+    esp_camera_latency_reset(&s_queue_lat);
+    esp_camera_latency_reset(&s_upload_lat);
+    esp_camera_reset_latency_stats();
+
+    s_frame_q = xQueueCreate(frame_queue_len, sizeof(pipeline_frame_t));
+    s_resp_q = xQueueCreate(PIPELINE_RESP_QUEUE_LEN, sizeof(pipeline_resp_t));
+    s_slots = xSemaphoreCreateCounting(frame_queue_len, frame_queue_len);
+    s_trigger = xSemaphoreCreateCounting(UINT16_MAX, 0);
+    if (!s_frame_q || !s_resp_q || !s_slots || !s_trigger)
+    {
+        ESP_LOGE(pipelineTag, "큐 생성 실패");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 촬영과 업로드가 서로 다른 코어에서 돌도록 (Wi-Fi/lwIP는 코어 0)
+    if (xTaskCreatePinnedToCore(capture_task, "pl_capture", PIPELINE_CAPTURE_STACK, NULL, 5, NULL, 1) != pdPASS ||
+        xTaskCreatePinnedToCore(upload_task, "pl_upload", PIPELINE_UPLOAD_STACK, NULL, 5, NULL, 0) != pdPASS ||
+        xTaskCreatePinnedToCore(parse_task, "pl_parse", PIPELINE_PARSE_STACK, NULL, 4, NULL, 1) != pdPASS)
+    {
+        ESP_LOGE(pipelineTag, "태스크 생성 실패");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(pipelineTag, "파이프라인 시작 (프레임 큐 %d)", frame_queue_len);
+    return ESP_OK;
+}
+
+// 사진 count장 촬영 요청
+void pipeline_trigger(int count)
+{
+    while (count-- > 0)
+    {
+        xSemaphoreGive(s_trigger);
+    }
+}
+
+void pipeline_get_stats(pipeline_stats_t *out)
+{
+    portENTER_CRITICAL(&s_stats_mux);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_stats_mux);
+}
+
+// 단계별 평균 시간과 처리량
+void pipeline_log_stats(void)
+{
+    pipeline_stats_t st;
+    pipeline_get_stats(&st);
+
+    uint32_t done = st.uploaded + st.failed;
+    if (done == 0)
+    {
+        return;
+    }
+
+    int64_t elapsed = st.last_done_us - st.first_capture_us;
+    int64_t serial = (st.capture_us + st.upload_us) / done; // 직렬 처리였다면 한 장에 걸리는 시간
+
+    ESP_LOGI(pipelineTag, "촬영 %" PRIu32 " / 업로드 %" PRIu32 " / 실패 %" PRIu32, st.captured, st.uploaded, st.failed);
+    ESP_LOGI(pipelineTag, "평균 촬영 %" PRId64 " ms, 큐 대기 %" PRId64 " ms, 업로드 %" PRId64 " ms",
+             st.capture_us / st.captured / 1000, st.queue_us / done / 1000, st.upload_us / done / 1000);
+    if (st.uploaded)
+    {
+        ESP_LOGI(pipelineTag, "평균 업로드 크기 %" PRIu64 " B/장 (%s)", st.bytes / st.uploaded,
+                 CAPTURE_GRAYSCALE ? "흑백" : "컬러 JPEG");
+    }
+    if (elapsed > 0)
+    {
+        ESP_LOGI(pipelineTag, "처리량 %.2f장/s (직렬 예상 %.2f장/s)",
+                 done * 1000000.0f / elapsed, 1000000.0f / serial);
+    }
+
+    // JPEG 프레임 크기 분포와 프레임 버퍼 메모리 (CONFIG_CAMERA_JPEG_FB_ADAPTIVE 크기 조정 확인용)
+    camera_fb_stats_t fbs;
+    if (esp_camera_get_fb_stats(&fbs) == ESP_OK && fbs.frames)
+    {
+        ESP_LOGI(pipelineTag, "JPEG 크기 p50 %zu / p90 %zu / p99 %zu / 최대 %zu B, FB-OVF %" PRIu32 "회",
+                 fbs.p50, fbs.p90, fbs.p99, fbs.max, fbs.overflows);
+        ESP_LOGI(pipelineTag, "프레임 버퍼 %zu B, 전체 %zu B (크기 조정 %" PRIu32 "회)",
+                 fbs.fb_size, fbs.fb_total, fbs.resizes);
+    }
+
+    // 단계별 지연 (드라이버: 센서 -> esp_camera_fb_get, 앱: 큐 대기 -> 업로드)
+    static const struct
+    {
+        const char *name;
+        int stage; // 드라이버 단계, 앱 히스토그램이면 -1
+        const camera_latency_hist_t *hist;
+    } stages[] = {
+        {"촬영(VSYNC->VSYNC)", CAMERA_LATENCY_CAPTURE, NULL},
+        {"전달(VSYNC->큐)", CAMERA_LATENCY_DELIVER, NULL},
+        {"fb_get 대기", CAMERA_LATENCY_WAIT, NULL},
+        {"업로드 큐", -1, &s_queue_lat},
+        {"HTTP 업로드", -1, &s_upload_lat},
+    };
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++)
+    {
+        camera_latency_stats_t lat;
+        if (stages[i].hist)
+        {
+            esp_camera_latency_get(stages[i].hist, &lat);
+        }
+        else if (esp_camera_get_latency_stats(stages[i].stage, &lat) != ESP_OK)
+        {
+            continue;
+        }
+        if (lat.count)
+        {
+            ESP_LOGI(pipelineTag, "%s: p50 %.1f ms / p99 %.1f ms / 최대 %.1f ms (%" PRIu32 "장)", stages[i].name,
+                     lat.p50_us / 1000.0f, lat.p99_us / 1000.0f, lat.max_us / 1000.0f, lat.count);
+        }
+    }
+}
+
+static bool trace_write(void *arg, const char *data, size_t len)
+{
+    return fwrite(data, 1, len, stdout) == len;
+}
+
+/*
+트레이스 기록 시작 / 중지 (CONFIG_CAMERA_TRACE)
+1. 처음 부르면 링 버퍼를 비우고 기록을 시작
+2. 다시 부르면 기록을 멈추고 Chrome trace JSON 을 콘솔에 출력 (파일로 저장해 chrome://tracing, ui.perfetto.dev 에서 열기)
+*/
+void pipeline_trace_toggle(void)
+{
+    static bool tracing = false;
+
+    if (!tracing)
+    {
+        esp_err_t err = esp_camera_trace_start();
+        if (err != ESP_OK)
+        {
+            ESP_LOGW(pipelineTag, "트레이스 시작 실패 (CONFIG_CAMERA_TRACE 꺼짐 / 링 버퍼 메모리 부족) %s", esp_err_to_name(err));
+            return;
+        }
+        tracing = true;
+        ESP_LOGI(pipelineTag, "트레이스 기록 시작");
+        return;
+    }
+    tracing = false;
+    printf("---- trace start ----\n");
+    esp_camera_trace_export(trace_write, NULL);
+    printf("---- trace end ----\n");
+}
@@ -0,0 +1,35 @@
+// ESP_pipeline.h
+#ifndef ESP_PIPELINE_H
+#define ESP_PIPELINE_H
+
+#include <stdint.h>
+
+#include "ESP_upload.h"
+
+// 촬영/업로드 파이프라인 통계 (ESP_pipeline.c)
+typedef struct
+{
+    uint32_t captured;        // 촬영한 사진 수
+    uint32_t uploaded;        // 응답을 받은 업로드 수
+    uint32_t failed;          // 실패한 업로드 수
+    int64_t capture_us;       // 촬영(플래시 포함) 누적 시간
+    int64_t queue_us;         // 촬영 후 업로드 시작까지 누적 대기 시간
+    int64_t upload_us;        // 업로드 누적 시간
+    uint64_t bytes;           // 성공한 업로드의 바디 누적 크기
+    int64_t first_capture_us; // 첫 촬영 시작 시점
+    int64_t last_done_us;     // 마지막 업로드 완료 시점
+} pipeline_stats_t;
+
+// 카메라 프레임 버퍼 수 (camera_config.fb_count) 이자 촬영-업로드 프레임 큐 길이
+// 업로드가 N번째 버퍼를 붙잡고 있는 동안 N+1번째를 찍으려면 2 이상이어야 함
+#define PIPELINE_FB_COUNT 2
+_Static_assert(PIPELINE_FB_COUNT >= 2, "capture overlaps upload only with two or more frame buffers");
+
+// 촬영 -> 업로드 -> 결과 처리 파이프라인 (ESP_pipeline.c, 호스트 테스트 test/host/test_pipeline.c)
+esp_err_t pipeline_start(upload_session_t *session, int frame_queue_len);
+void pipeline_trigger(int count);
+void pipeline_get_stats(pipeline_stats_t *out);
+void pipeline_log_stats(void);
+void pipeline_trace_toggle(void);
+
+#endif
@@ -0,0 +1,181 @@
+#include "header.h"
+
+static const char *roiTag = "ROI";
+
+#define ROI_NVS_NAMESPACE "roi"
+#define ROI_NVS_KEY "rect"
+
+/*
+관심 영역(ROI) 모드
+1. 서버가 OCR 하는 계량기 숫자 창만 잘라서 보낸다
+2. OV2640 + 4:3 해상도면 센서 윈도우(set_res_raw)로 센서가 처음부터 ROI만 JPEG으로 출력
+3. 그 외에는 RAW 프레임(YUV/RGB/GRAY)을 소프트웨어로 잘라서 인코딩 (ESP_roi_crop.c)
+4. 사각형은 NVS에 저장되어 재부팅 후에도 유지
+*/
+
+static roi_t s_roi;
+
+const roi_t *roi_get(void)
+{
+    return &s_roi;
+}
+
+esp_err_t roi_load(void)
+{
+    nvs_handle_t nvs;
+    memset(&s_roi, 0, sizeof(s_roi));
+
+    esp_err_t err = nvs_open(ROI_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK)
+    {
+        return err; // 저장된 ROI 없음
+    }
+
+    roi_rect_t rect;
+    size_t len = sizeof(rect);
+    err = nvs_get_blob(nvs, ROI_NVS_KEY, &rect, &len);
+    nvs_close(nvs);
+    if (err == ESP_OK && len == sizeof(rect) && rect.w && rect.h)
+    {
+        s_roi.rect = rect;
+        s_roi.enabled = true;
+        ESP_LOGI(roiTag, "NVS ROI : x %u y %u w %u h %u", rect.x, rect.y, rect.w, rect.h);
+    }
+    return err;
+}
+
+// rect가 NULL이면 ROI 해제
+esp_err_t roi_save(const roi_rect_t *rect)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(ROI_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if (rect)
+    {
+        err = nvs_set_blob(nvs, ROI_NVS_KEY, rect, sizeof(*rect));
+    }
+    else
+    {
+        err = nvs_erase_key(nvs, ROI_NVS_KEY);
+        if (err == ESP_ERR_NVS_NOT_FOUND)
+        {
+            err = ESP_OK;
+        }
+    }
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err;
+}
+
+/*
+OV2640 센서 윈도우 설정 (ov2640.c set_framesize 와 같은 계산)
+- 4:3 해상도는 센서 전체(1600x1200)를 모드(UXGA/SVGA/CIF)에 맞게 줄인 창에서 출력 크기로 축소한다
+- 그 창 안에서 ROI에 해당하는 부분만 잘라 1:1로 출력하도록 한다
+*/
+static bool roi_apply_ov2640(sensor_t *s, const roi_rect_t *r)
+{
+    framesize_t fs = s->status.framesize;
+    if (resolution[fs].aspect_ratio != ASPECT_RATIO_4X3 || fs > FRAMESIZE_UXGA)
+    {
+        return false;
+    }
+
+    int mode = 0; // OV2640_MODE_UXGA
+    int div = 1;
+    if (fs <= FRAMESIZE_CIF)
+    {
+        mode = 2; // OV2640_MODE_CIF
+        div = 4;
+    }
+    else if (fs <= FRAMESIZE_SVGA)
+    {
+        mode = 1; // OV2640_MODE_SVGA
+        div = 2;
+    }
+
+    int win_w = 1600 / div;
+    int win_h = MIN(1200 / div, (mode == 2) ? 296 : 1200);
+    int fw = resolution[fs].width;
+    int fh = resolution[fs].height;
+
+    // 프레임 좌표 -> 센서 창 좌표
+    int ox = r->x * win_w / fw;
+    int oy = r->y * win_h / fh;
+    int mx = (r->w * win_w / fw) & ~3;
+    int my = (r->h * win_h / fh) & ~3;
+
+    // set_res_raw의 startX 자리에 모드를 넘긴다 (ov2640.c 참고)
+    return s->set_res_raw(s, mode, 0, 0, 0, ox, oy, mx, my, r->w, r->h, false, false) == 0;
+}
+
+/*
+ROI 적용
+1. 해제면 센서를 원래 해상도로 되돌림
+2. 가능하면 센서 윈도우, 아니면 소프트웨어 자르기 모드
+*/
+esp_err_t roi_apply(const roi_rect_t *rect)
+{
+    sensor_t *s = esp_camera_sensor_get();
+    if (!s)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (s_roi.sensor_window)
+    {
+        s->set_framesize(s, s->status.framesize); // 센서 창 복구
+    }
+    s_roi.sensor_window = false;
+    s_roi.enabled = false;
+
+    if (!rect)
+    {
+        ESP_LOGI(roiTag, "ROI 해제");
+        return ESP_OK;
+    }
+
+    roi_rect_t r = *rect;
+    framesize_t fs = s->status.framesize;
+    if (!roi_clip(&r, resolution[fs].width, resolution[fs].height))
+    {
+        ESP_LOGE(roiTag, "ROI가 프레임 밖이거나 너무 작습니다");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_roi.rect = r;
+    s_roi.enabled = true;
+    if (s->id.PID == OV2640_PID && s->pixformat == PIXFORMAT_JPEG && roi_apply_ov2640(s, &r))
+    {
+        s_roi.sensor_window = true;
+    }
+    else if (s->pixformat == PIXFORMAT_JPEG)
+    {
+        // JPEG를 자르려면 디코딩 후 재인코딩해야 하므로 하지 않음
+        ESP_LOGW(roiTag, "이 센서는 JPEG 센서 윈도우를 지원하지 않아 전체 프레임을 보냅니다");
+    }
+
+    ESP_LOGI(roiTag, "ROI x %u y %u w %u h %u (%s)", r.x, r.y, r.w, r.h,
+             s_roi.sensor_window ? "센서 윈도우" : "소프트웨어");
+    return ESP_OK;
+}
+
+/*
+업로드할 프레임 고르기
+- 소프트웨어 ROI 모드이고 RAW 프레임이면 잘라낸 복사본(tmp)을, 아니면 원본을 돌려준다
+- 돌려받은 프레임이 tmp면 업로드 후 roi_crop_free(tmp)
+*/
+camera_fb_t *roi_frame(camera_fb_t *fb, camera_fb_t *tmp)
+{
+    if (!s_roi.enabled || s_roi.sensor_window || fb->format == PIXFORMAT_JPEG)
+    {
+        return fb;
+    }
+    return roi_crop(fb, &s_roi.rect, tmp) ? tmp : fb;
+}
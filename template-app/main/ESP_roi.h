@@ -0,0 +1,43 @@
+// ESP_roi.h
+#ifndef ESP_ROI_H
+#define ESP_ROI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_camera.h"
+
+#define ROI_ALIGN 16 // JPEG MCU(16x8) 크기에 맞춤
+
+// 관심 영역 사각형 (현재 해상도의 프레임 좌표, NVS에 그대로 저장)
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} roi_rect_t;
+
+// ROI 모드 상태 (ESP_roi.c)
+typedef struct
+{
+    bool enabled;       // ROI만 업로드
+    bool sensor_window; // 센서가 ROI만 출력 (false면 RAW 프레임을 소프트웨어로 자름)
+    roi_rect_t rect;    // 정렬/클리핑된 사각형
+} roi_t;
+
+// ROI 설정과 업로드할 프레임 고르기 (ESP_roi.c)
+esp_err_t roi_load(void);
+esp_err_t roi_save(const roi_rect_t *rect);
+esp_err_t roi_apply(const roi_rect_t *rect);
+const roi_t *roi_get(void);
+camera_fb_t *roi_frame(camera_fb_t *fb, camera_fb_t *tmp);
+
+// RAW 프레임 자르기 (ESP_roi_crop.c, ESP-IDF 없이 호스트에서도 빌드)
+bool roi_clip(roi_rect_t *r, size_t frame_w, size_t frame_h);
+bool roi_crop(const camera_fb_t *src, const roi_rect_t *rect, camera_fb_t *dst);
+void roi_crop_free(camera_fb_t *dst);
+
+#endif
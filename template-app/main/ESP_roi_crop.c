@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "ESP_roi.h"
+
+static const char *roiCropTag = "ROI";
+
+/*
+RAW 프레임 소프트웨어 자르기 (ESP_roi.c 의 ROI 모드에서 사용)
+- 센서, NVS 와 무관한 부분만 모아서 호스트 테스트(test/host/test_roi_crop.c)로도 확인한다
+*/
+
+// 프레임 안으로 자르고 MCU 크기에 맞춤 (남는 영역이 없으면 false)
+bool roi_clip(roi_rect_t *r, size_t frame_w, size_t frame_h)
+{
+    if (r->x >= frame_w || r->y >= frame_h)
+    {
+        return false;
+    }
+    r->w = MIN(r->w, frame_w - r->x);
+    r->h = MIN(r->h, frame_h - r->y);
+    r->x &= ~1; // YUYV는 두 픽셀이 U/V를 공유
+    r->w = r->w / ROI_ALIGN * ROI_ALIGN;
+    r->h = r->h / ROI_ALIGN * ROI_ALIGN;
+    return r->w > 0 && r->h > 0;
+}
+
+static int roi_bytes_per_pixel(pixformat_t format)
+{
+    switch (format)
+    {
+    case PIXFORMAT_GRAYSCALE:
+        return 1;
+    case PIXFORMAT_RGB565:
+    case PIXFORMAT_YUV422:
+        return 2;
+    case PIXFORMAT_RGB888:
+        return 3;
+    default:
+        return 0; // JPEG 등 압축 포맷은 자를 수 없음
+    }
+}
+
+/*
+RAW 프레임에서 사각형만 복사
+1. 원본 프레임
+2. 자를 사각형 (프레임 좌표)
+3. 결과 프레임 (dst->buf는 roi_crop_free로 해제)
+*/
+bool roi_crop(const camera_fb_t *src, const roi_rect_t *rect, camera_fb_t *dst)
+{
+    int bpp = roi_bytes_per_pixel(src->format);
+    roi_rect_t r = *rect;
+    if (!bpp || !roi_clip(&r, src->width, src->height) || src->len < src->width * src->height * bpp)
+    {
+        return false;
+    }
+
+    size_t row = (size_t)r.w * bpp;
+    uint8_t *buf = heap_caps_malloc(row * r.h, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buf)
+    {
+        buf = malloc(row * r.h);
+    }
+    if (!buf)
+    {
+        ESP_LOGE(roiCropTag, "ROI 버퍼 할당 실패");
+        return false;
+    }
+
+    const uint8_t *p = src->buf + ((size_t)r.y * src->width + r.x) * bpp;
+    for (int y = 0; y < r.h; y++)
+    {
+        memcpy(buf + y * row, p, row);
+        p += src->width * bpp;
+    }
+
+    *dst = *src;
+    dst->buf = buf;
+    dst->len = row * r.h;
+    dst->width = r.w;
+    dst->height = r.h;
+    return true;
+}
+
+void roi_crop_free(camera_fb_t *dst)
+{
+    free(dst->buf);
+    dst->buf = NULL;
+}
@@ -0,0 +1,68 @@
+// ESP_upload.h
+#ifndef ESP_UPLOAD_H
+#define ESP_UPLOAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_camera.h"
+#include "esp_http_client.h"
+#include "ESP_json_stream.h"
+
+// keep-alive 업로드 세션 (ESP_http.c)
+typedef struct
+{
+    esp_http_client_handle_t client; // 세션 동안 유지되는 HTTP 클라이언트 핸들
+    char url[128];                   // 업로드 URL
+    bool connected;                  // TCP 연결이 살아있는지
+    bool server_close;               // 서버가 응답에 Connection: close를 보냈는지
+    int uploads;                     // 응답까지 받은 업로드 수
+    int connects;                    // 새로 맺은 TCP 연결 수
+    size_t last_body_len;            // 마지막 업로드 바디 크기 (멀티파트 헤더 포함, chunk 구분자 제외)
+} upload_session_t;
+
+#define UPLOAD_JPEG_QUALITY 80 // JPEG가 아닌 프레임을 인코딩할 때 품질 (1~100)
+#define UPLOAD_JPEG_BANDS portNUM_PROCESSORS // 인코딩을 나눠 맡을 코어 수 (1이면 한 태스크에서 인코딩)
+#define UPLOAD_JPEG_PROFILE JPG_PROFILE_OCR_TEXT // 양자화 테이블 프로필 (숫자 획의 고주파를 남기고 색차는 거칠게)
+#define UPLOAD_JPEG_OPTIMIZE_HUFFMAN 0 // 1이면 프레임마다 최적 허프만 테이블로 두 번 인코딩 (품질에 따라 2~10% 작아지지만 시간이 더 들고 한 코어에서만 인코딩)
+
+// 1이면 센서가 흑백(Y만) 프레임을 출력하고 Y 한 채널 JPEG로 업로드 (서버는 어차피 밝기만 사용)
+// 0이면 센서가 직접 만든 컬러 JPEG를 그대로 업로드
+#ifndef CAPTURE_GRAYSCALE
+#define CAPTURE_GRAYSCALE 0
+#endif
+
+// 업로드 바디 조각 (scatter-gather)
+typedef struct
+{
+    const void *data;
+    size_t len;
+} body_seg_t;
+
+// 업로드 바디 writer (chunked면 조각마다 chunk로 감싸서 보냄)
+typedef struct
+{
+    esp_http_client_handle_t client;
+    bool chunked; // Transfer-Encoding: chunked 여부
+    bool failed;  // 한 번이라도 쓰기에 실패했는지
+    size_t sent;  // 보낸 바디 바이트 수 (chunk 헤더 제외)
+} body_writer_t;
+
+// 사진 바디를 body_writer_write로 흘려보내는 콜백 (실패 시 false)
+typedef bool (*body_source_cb)(body_writer_t *w, void *arg);
+
+// 업로드 세션과 바디 writer (ESP_http.c)
+esp_err_t upload_session_init(upload_session_t *s, const char *url);
+int upload_session_send(upload_session_t *s, const uint8_t *jpg, size_t jpg_len, json_stream_t *resp_parser);
+int upload_session_send_body(upload_session_t *s, body_source_cb source, void *arg, int body_len, json_stream_t *resp_parser);
+int upload_session_send_stream(upload_session_t *s, body_source_cb source, void *arg, json_stream_t *resp_parser);
+int upload_session_send_frame(upload_session_t *s, camera_fb_t *fb, uint8_t quality, json_stream_t *resp_parser);
+void upload_session_deinit(upload_session_t *s);
+bool body_writer_write(body_writer_t *w, const void *data, size_t len);
+bool body_writer_writev(body_writer_t *w, const body_seg_t *segs, int count);
+bool body_writer_finish(body_writer_t *w);
+size_t body_writer_jpg_cb(void *arg, size_t index, const void *data, size_t len);
+
+#endif
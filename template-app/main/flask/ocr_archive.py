@@ -0,0 +1,91 @@
+"""
+업로드 이미지 비동기 보관 (ocr_server.py 에서 사용)
+
+- 요청 스레드는 받은 바이트를 큐에 넣기만 하고 바로 OCR 로 넘어간다
+- 백그라운드 스레드 하나가 파일로 저장한다
+- 큐가 가득 차면 그 이미지는 보관하지 않는다 (OCR 응답을 늦추지 않음)
+- 폴더 전체 크기가 max_bytes 를 넘으면 오래된 파일부터 지운다
+"""
+import os
+import queue
+import threading
+
+
+class UploadArchiver:
+    def __init__(self, folder, queue_size=32, max_bytes=500 * 1024 * 1024):
+        self.folder = folder
+        self.max_bytes = max_bytes
+        self.jobs = queue.Queue(maxsize=queue_size)
+
+        self.lock = threading.Lock()
+        self.stats = {"saved": 0, "dropped": 0, "deleted": 0, "errors": 0}
+
+        os.makedirs(folder, exist_ok=True)
+        self.files, self.used = self._scan()  # [(mtime, 이름, 크기)] 오래된 순, 전체 크기
+
+        self.thread = threading.Thread(target=self._worker, name="archiver", daemon=True)
+        self.thread.start()
+
+    # 요청 스레드에서 호출, 보관 대기열에 넣었으면 True
+    def submit(self, filename, data):
+        try:
+            self.jobs.put_nowait((filename, data))
+            return True
+        except queue.Full:
+            with self.lock:
+                self.stats["dropped"] += 1
+            return False
+
+    # 대기 중인 저장이 모두 끝날 때까지 기다림 (벤치마크/종료용)
+    def flush(self):
+        self.jobs.join()
+
+    def snapshot(self):
+        with self.lock:
+            s = dict(self.stats)
+            s["used_bytes"] = self.used
+            s["files"] = len(self.files)
+        s["queued"] = self.jobs.qsize()
+        s["max_bytes"] = self.max_bytes
+        return s
+
+    def _scan(self):
+        files = []
+        for entry in os.scandir(self.folder):
+            if entry.is_file():
+                st = entry.stat()
+                files.append((st.st_mtime, entry.name, st.st_size))
+        files.sort()
+        return files, sum(f[2] for f in files)
+
+    def _worker(self):
+        while True:
+            filename, data = self.jobs.get()
+            try:
+                path = os.path.join(self.folder, filename)
+                with open(path, "wb") as f:
+                    f.write(data)
+                with self.lock:
+                    self.files.append((os.path.getmtime(path), filename, len(data)))
+                    self.used += len(data)
+                    self.stats["saved"] += 1
+                self._trim()
+            except OSError:
+                with self.lock:
+                    self.stats["errors"] += 1
+            finally:
+                self.jobs.task_done()
+
+    # 디스크 사용량 제한: 오래된 파일부터 삭제
+    def _trim(self):
+        while True:
+            with self.lock:
+                if self.used <= self.max_bytes or not self.files:
+                    return
+                _, name, size = self.files.pop(0)
+                self.used -= size
+                self.stats["deleted"] += 1
+            try:
+                os.remove(os.path.join(self.folder, name))
+            except FileNotFoundError:
+                pass
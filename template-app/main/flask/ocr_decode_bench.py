@@ -0,0 +1,82 @@
+"""
+업로드 디코딩 경로 벤치마크 (OCR 제외)
+
+- 기존 : 디스크에 저장 -> 파일로 다시 열기 -> 전처리
+- 변경 : 메모리(BytesIO)에서 바로 열기 -> 전처리, 보관은 UploadArchiver 가 백그라운드에서
+- 두 방식을 같은 JPEG 들로 번갈아 돌려 요청 스레드가 기다리는 시간(p50/p99)을 비교한다
+
+사용법
+  python ocr_decode_bench.py --dir uploads -n 200
+"""
+import argparse
+import glob
+import io
+import os
+import tempfile
+import time
+
+os.environ.setdefault("OCR_POOL", "0")     # 벤치마크에는 OCR 워커/보관 스레드가 필요 없음
+os.environ.setdefault("OCR_ARCHIVE", "0")
+
+from PIL import Image
+
+from ocr_archive import UploadArchiver
+from ocr_loadgen import percentile
+from ocr_server import preprocess_for_digits
+
+
+def run_disk(data, folder, i):
+    path = os.path.join(folder, f"disk_{i}.jpg")
+    with open(path, "wb") as f:
+        f.write(data)
+    return preprocess_for_digits(Image.open(path))
+
+
+def run_memory(data, archiver, i):
+    archiver.submit(f"mem_{i}.jpg", data)
+    return preprocess_for_digits(Image.open(io.BytesIO(data)))
+
+
+def report(name, times):
+    lat = sorted(times)
+    print("{:<8} 평균 {:.2f} ms, p50 {:.2f}, p99 {:.2f}, max {:.2f}".format(
+        name, sum(lat) / len(lat) * 1000, *(percentile(lat, p) * 1000 for p in (50, 99, 100))))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--dir", default="uploads", help="JPEG 폴더")
+    parser.add_argument("-n", type=int, default=100, help="방식별 반복 횟수")
+    args = parser.parse_args()
+
+    files = sorted(glob.glob(os.path.join(args.dir, "*.jp*g")))
+    if not files:
+        raise SystemExit(f"{args.dir} 에 JPEG 파일이 없습니다")
+    images = [open(f, "rb").read() for f in files]
+
+    with tempfile.TemporaryDirectory(prefix="ocr_bench_") as tmp:
+        disk_dir = os.path.join(tmp, "disk")
+        os.makedirs(disk_dir)
+        archiver = UploadArchiver(os.path.join(tmp, "archive"))
+
+        t_disk, t_mem = [], []
+        for i in range(args.n):
+            data = images[i % len(images)]
+
+            t0 = time.perf_counter()
+            run_disk(data, disk_dir, i)
+            t_disk.append(time.perf_counter() - t0)
+
+            t0 = time.perf_counter()
+            run_memory(data, archiver, i)
+            t_mem.append(time.perf_counter() - t0)
+
+        archiver.flush()
+        print(f"이미지 {len(images)}장, 방식별 {args.n}회")
+        report("disk", t_disk)
+        report("memory", t_mem)
+        print("보관 :", archiver.snapshot())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,133 @@
+"""
+OCR 서버 부하 생성기
+
+- 저장된 JPEG(기본: uploads/)를 ESP32와 같은 multipart 형식으로 /upload 에 다시 보낸다
+- 동시 연결 수(-c)만큼 스레드가 각자 keep-alive 연결로 요청을 보낸다
+- 초당 요청 수, 지연 시간 p50/p90/p99, 상태 코드별 개수를 출력한다
+
+사용법
+  python ocr_server.py                                   # (다른 터미널) 워커 풀 모드
+  OCR_POOL=0 python ocr_server.py                        # (다른 터미널) 기존 동기 모드
+  python ocr_loadgen.py -n 200 -c 8 --dir uploads        # 두 모드에서 각각 실행해 비교
+  python ocr_loadgen.py -n 200 --gray                    # 흑백 모드(CAPTURE_GRAYSCALE)처럼 Y 한 채널 JPEG로 바꿔서 전송
+"""
+import argparse
+import glob
+import http.client
+import io
+import os
+import socket
+import threading
+import time
+from collections import Counter
+
+from upload_standin import BOUNDARY, multipart_body
+
+
+def percentile(sorted_vals, p):
+    if not sorted_vals:
+        return 0.0
+    k = min(len(sorted_vals) - 1, int(round(p / 100 * (len(sorted_vals) - 1))))
+    return sorted_vals[k]
+
+
+def to_gray_jpeg(data, quality):
+    # 장치의 흑백 모드와 같은 Y 한 채널 JPEG
+    from PIL import Image
+    out = io.BytesIO()
+    Image.open(io.BytesIO(data)).convert("L").save(out, "JPEG", quality=quality)
+    return out.getvalue()
+
+
+def load_images(path, gray=False, quality=80):
+    files = sorted(glob.glob(os.path.join(path, "*.jp*g")))
+    if not files:
+        raise SystemExit(f"{path} 에 JPEG 파일이 없습니다")
+    images = [open(f, "rb").read() for f in files]
+    if gray:
+        images = [to_gray_jpeg(d, quality) for d in images]
+    return [multipart_body(d) for d in images]
+
+
+def client_thread(host, port, bodies, counter, lock, latencies, codes):
+    conn = None
+    headers = {
+        "Content-Type": f"multipart/form-data; boundary={BOUNDARY}",
+        "Accept": "application/json",
+        "Connection": "keep-alive",
+    }
+    while True:
+        with lock:
+            i = counter[0]
+            if i >= counter[1]:
+                break
+            counter[0] += 1
+        body = bodies[i % len(bodies)]
+
+        t0 = time.perf_counter()
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(host, port, timeout=60)
+                conn.connect()
+                conn.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            conn.request("POST", "/upload", body=body, headers=headers)
+            resp = conn.getresponse()
+            resp.read()
+            code = resp.status
+            if resp.getheader("Connection", "").lower() == "close":
+                conn.close()
+                conn = None
+        except (OSError, http.client.HTTPException):
+            code = "conn-error"
+            if conn:
+                conn.close()
+            conn = None
+        dt = time.perf_counter() - t0
+
+        with lock:
+            latencies.append(dt)
+            codes[code] += 1
+
+    if conn:
+        conn.close()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=5000)
+    parser.add_argument("--dir", default="uploads", help="다시 보낼 JPEG 폴더")
+    parser.add_argument("-n", type=int, default=100, help="총 요청 수")
+    parser.add_argument("-c", type=int, default=4, help="동시 연결 수")
+    parser.add_argument("--gray", action="store_true", help="흑백 JPEG로 바꿔서 전송")
+    parser.add_argument("--quality", type=int, default=80, help="--gray 인코딩 품질 (UPLOAD_JPEG_QUALITY)")
+    args = parser.parse_args()
+
+    bodies = load_images(args.dir, args.gray, args.quality)
+    counter = [0, args.n]
+    lock = threading.Lock()
+    latencies = []
+    codes = Counter()
+
+    threads = [threading.Thread(target=client_thread,
+                                args=(args.host, args.port, bodies, counter, lock, latencies, codes))
+               for _ in range(args.c)]
+    t0 = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.perf_counter() - t0
+
+    lat = sorted(latencies)
+    ok = codes.get(200, 0)
+    print(f"이미지 {len(bodies)}장 (평균 {sum(map(len, bodies)) // len(bodies)} B/요청, {'흑백' if args.gray else '원본'}), "
+          f"요청 {len(lat)}회, 동시 {args.c}")
+    print(f"시간 {elapsed:.2f}s, 처리량 {len(lat) / elapsed:.1f} req/s (성공 {ok / elapsed:.1f} req/s)")
+    print("지연 ms : p50 {:.1f}, p90 {:.1f}, p99 {:.1f}, max {:.1f}".format(
+        *(percentile(lat, p) * 1000 for p in (50, 90, 99, 100))))
+    print("상태 코드 :", dict(codes))
+
+
+if __name__ == "__main__":
+    main()
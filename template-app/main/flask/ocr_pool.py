@@ -0,0 +1,141 @@
+"""
+OCR 워커 풀 (ocr_server.py 에서 사용)
+
+- 요청 스레드는 전처리된 이미지를 큐에 넣고 결과(Future)만 기다린다
+- 큐 크기가 정해져 있어 밀리면 바로 거절한다 (서버가 무한정 쌓지 않음)
+- 워커는 큐에서 최대 batch_max 장을 batch_wait 동안 모아 한 번에 OCR 한다 (micro-batching)
+  * tesserocr 가 있으면 워커마다 Tesseract 엔진(PyTessBaseAPI)을 한 번만 띄워 계속 재사용
+  * 없으면 tesseract CLI 한 번에 이미지 목록(.txt)을 넘겨 프로세스 생성/모델 로딩을 배치당 1회로 줄임
+"""
+import os
+import queue
+import subprocess
+import tempfile
+import threading
+import time
+from concurrent.futures import Future
+
+import pytesseract
+
+try:
+    import tesserocr  # 선택: 있으면 엔진을 프로세스 안에 계속 유지
+except ImportError:
+    tesserocr = None
+
+
+class PoolBusy(Exception):
+    """큐가 가득 차서 요청을 받을 수 없음"""
+
+
+class OcrPool:
+    def __init__(self, workers=2, queue_size=16, batch_max=8, batch_wait=0.01,
+                 lang="eng", psm=6, whitelist="0123456789"):
+        self.lang = lang
+        self.psm = psm
+        self.whitelist = whitelist
+        self.batch_max = batch_max
+        self.batch_wait = batch_wait
+        self.jobs = queue.Queue(maxsize=queue_size)
+
+        self.lock = threading.Lock()
+        self.stats = {"jobs": 0, "batches": 0, "rejected": 0, "ocr_s": 0.0}
+
+        self.threads = []
+        for i in range(workers):
+            t = threading.Thread(target=self._worker, name=f"ocr-{i}", daemon=True)
+            t.start()
+            self.threads.append(t)
+
+    # 요청 스레드에서 호출, 큐가 가득 차면 PoolBusy
+    def submit(self, pil_img):
+        fut = Future()
+        try:
+            self.jobs.put_nowait((pil_img, fut))
+        except queue.Full:
+            with self.lock:
+                self.stats["rejected"] += 1
+            raise PoolBusy()
+        return fut
+
+    def ocr(self, pil_img, timeout=30):
+        return self.submit(pil_img).result(timeout=timeout)
+
+    def snapshot(self):
+        with self.lock:
+            s = dict(self.stats)
+        s["queued"] = self.jobs.qsize()
+        s["avg_batch"] = s["jobs"] / s["batches"] if s["batches"] else 0.0
+        s["engine"] = "tesserocr" if tesserocr else "cli-batch"
+        return s
+
+    # 첫 작업은 기다리고, 그 뒤로는 batch_wait 안에 들어온 작업만 더 모은다
+    def _take_batch(self):
+        batch = [self.jobs.get()]
+        deadline = time.monotonic() + self.batch_wait
+        while len(batch) < self.batch_max:
+            remain = deadline - time.monotonic()
+            if remain <= 0:
+                break
+            try:
+                batch.append(self.jobs.get(timeout=remain))
+            except queue.Empty:
+                break
+        return batch
+
+    def _worker(self):
+        api = None
+        if tesserocr:
+            api = tesserocr.PyTessBaseAPI(lang=self.lang, psm=self.psm)
+            api.SetVariable("tessedit_char_whitelist", self.whitelist)
+
+        while True:
+            batch = self._take_batch()
+            imgs = [img for img, _ in batch]
+            t0 = time.perf_counter()
+            try:
+                texts = self._ocr_api(api, imgs) if api else self._ocr_cli(imgs)
+                for (_, fut), text in zip(batch, texts):
+                    fut.set_result(text.strip())
+            except Exception as e:
+                for _, fut in batch:
+                    if not fut.done():
+                        fut.set_exception(e)
+
+            with self.lock:
+                self.stats["jobs"] += len(batch)
+                self.stats["batches"] += 1
+                self.stats["ocr_s"] += time.perf_counter() - t0
+
+    def _ocr_api(self, api, imgs):
+        texts = []
+        for img in imgs:
+            api.SetImage(img)
+            texts.append(api.GetUTF8Text())
+        return texts
+
+    def _ocr_cli(self, imgs):
+        if len(imgs) == 1:
+            return [pytesseract.image_to_string(imgs[0], lang=self.lang, config=self._config())]
+
+        # 이미지 목록 파일을 넘기면 tesseract 한 프로세스가 모든 이미지를 처리하고 페이지마다 \f 로 구분해 출력
+        with tempfile.TemporaryDirectory(prefix="ocr_batch_") as tmp:
+            paths = []
+            for i, img in enumerate(imgs):
+                path = os.path.join(tmp, f"{i}.png")
+                img.save(path)
+                paths.append(path)
+            list_path = os.path.join(tmp, "list.txt")
+            with open(list_path, "w") as f:
+                f.write("\n".join(paths) + "\n")
+
+            cmd = [pytesseract.pytesseract.tesseract_cmd, list_path, "stdout", "-l", self.lang]
+            cmd += self._config().split()
+            out = subprocess.run(cmd, capture_output=True, check=True).stdout.decode("utf-8", "replace")
+
+        pages = out.split("\f")
+        if len(pages) < len(imgs):
+            raise RuntimeError(f"tesseract 배치 출력 페이지 수 불일치 ({len(pages)} < {len(imgs)})")
+        return pages[:len(imgs)]
+
+    def _config(self):
+        return f"--oem 3 --psm {self.psm} -c tessedit_char_whitelist={self.whitelist}"
@@ -0,0 +1,122 @@
+"""
+OCR 전처리 (ocr_server.py 의 preprocess_for_digits 에서 사용)
+
+- 기존 : convert("L") -> autocontrast -> point(lambda, 고정 임계값 180) 으로 이미지를 여러 번 훑음
+- 변경 : 회색조 변환 후 이진화를 한 번에 (전역 임계값은 히스토그램 + LUT, 지역 임계값은 NumPy 적분 영상)
+  * otsu  : 히스토그램으로 전체 임계값을 자동 결정 (플래시 밝기가 달라도 따라감)
+  * local : 주변 평균(적분 영상)보다 어두운 픽셀만 글자로 (반사/그림자처럼 밝기가 고르지 않을 때)
+  * fixed : 기존과 같은 autocontrast + 고정 임계값 (비교용)
+- deskew : 글자 픽셀의 가로 투영이 가장 날카로워지는 각도를 찾아 기울기 보정 (선택)
+- 결과는 기존과 같이 글자 0(검정), 배경 255(흰색)
+"""
+import numpy as np
+from PIL import Image, ImageOps
+
+METHODS = ("otsu", "local", "fixed")
+
+
+def preprocess_legacy(pil_img):
+    # 기존 구현 그대로 (벤치마크/정확도 비교용)
+    gray = pil_img.convert("L")
+    gray = ImageOps.autocontrast(gray)
+    return gray.point(lambda x: 255 if x > 180 else 0, mode="1")
+
+
+def otsu_threshold(hist):
+    # 클래스 간 분산이 가장 큰 임계값 (누적합으로 256개 후보를 한 번에 계산)
+    hist = np.asarray(hist, dtype=np.float64)
+    levels = np.arange(256, dtype=np.float64)
+    w0 = np.cumsum(hist)
+    m0 = np.cumsum(hist * levels)
+    total, mean_all = w0[-1], m0[-1]
+    w1 = total - w0
+    with np.errstate(divide="ignore", invalid="ignore"):
+        between = (mean_all * w0 - m0 * total) ** 2 / (w0 * w1)
+    between[~np.isfinite(between)] = 0
+    return int(np.argmax(between))
+
+
+def local_mask(gray, window=31, offset=0.15):
+    # 적분 영상으로 window x window 평균을 구하고, 평균보다 offset 만큼 어두우면 글자
+    # 세로/가로를 나눠 누적합 차이로 구함 (2048x2048 까지 int32 로 충분)
+    h, w = gray.shape
+    r = window // 2
+    y0 = np.clip(np.arange(h) - r, 0, h)
+    y1 = np.clip(np.arange(h) + r + 1, 0, h)
+    x0 = np.clip(np.arange(w) - r, 0, w)
+    x1 = np.clip(np.arange(w) + r + 1, 0, w)
+
+    cs = np.zeros((h + 1, w), dtype=np.int32)
+    np.cumsum(gray, axis=0, dtype=np.int32, out=cs[1:])
+    cols = cs[y1] - cs[y0]
+
+    cs = np.zeros((h, w + 1), dtype=np.int32)
+    np.cumsum(cols, axis=1, out=cs[:, 1:])
+    sums = cs[:, x1] - cs[:, x0]
+
+    area = ((y1 - y0)[:, None] * (x1 - x0)[None, :]).astype(np.float32)
+    return gray * area < sums * np.float32(1.0 - offset)
+
+
+def binary_lut(threshold):
+    # threshold 이하(글자)는 0, 나머지는 255
+    return [0] * (threshold + 1) + [255] * (255 - threshold)
+
+
+def fixed_threshold(gray, threshold=180):
+    # autocontrast 후 고정 임계값과 같은 결과가 나오도록 원본 밝기 기준으로 임계값을 옮김
+    # autocontrast 는 x -> int((x - lo) * 255 / (hi - lo)) 이므로
+    # 결과 > threshold  <=>  x >= lo + ceil((threshold + 1) * (hi - lo) / 255)
+    lo, hi = gray.getextrema()
+    if hi <= lo:
+        return 255 if lo <= threshold else -1
+    return min(255, lo + -(-(threshold + 1) * (hi - lo) // 255) - 1)
+
+
+def estimate_skew(mask, max_angle=10.0, step=0.5, max_points=20000):
+    # 글자 픽셀 좌표를 회전시켜 행 히스토그램의 제곱합이 최대인 각도 (이미지 자체는 돌리지 않음)
+    ys, xs = np.nonzero(mask)
+    if len(ys) < 50:
+        return 0.0
+    if len(ys) > max_points:
+        idx = np.linspace(0, len(ys) - 1, max_points).astype(np.int64)
+        ys, xs = ys[idx], xs[idx]
+    ys = ys.astype(np.float64)
+    xs = xs.astype(np.float64) - xs.mean()
+
+    best, best_score = 0.0, -1.0
+    for angle in np.arange(-max_angle, max_angle + step / 2, step):
+        t = np.deg2rad(angle)
+        rows = np.round(ys * np.cos(t) - xs * np.sin(t)).astype(np.int64)
+        counts = np.bincount(rows - rows.min())
+        score = float(np.dot(counts, counts))
+        if score > best_score:
+            best, best_score = float(angle), score
+    return best
+
+
+def preprocess(pil_img, method="otsu", deskew=False, window=31, offset=0.15):
+    """
+    OCR 용 이진 이미지 (mode "L", 글자 0 / 배경 255)
+    1. 입력 이미지 (모드 무관)
+    2. 이진화 방식 : otsu / local / fixed
+    3. 기울기 보정 여부
+    """
+    gray = pil_img if pil_img.mode == "L" else pil_img.convert("L")  # 흑백 JPEG 는 그대로
+
+    # 전역 임계값은 히스토그램(C 구현) + LUT 한 번이면 되므로 배열로 바꾸지 않는다
+    if method == "otsu":
+        out = gray.point(binary_lut(otsu_threshold(gray.histogram())))
+    elif method == "fixed":
+        out = gray.point(binary_lut(fixed_threshold(gray)))
+    elif method == "local":
+        mask = local_mask(np.asarray(gray, dtype=np.uint8), window, offset)
+        out = Image.fromarray(np.where(mask, 0, 255).astype(np.uint8), mode="L")
+    else:
+        raise ValueError(f"알 수 없는 이진화 방식: {method}")
+
+    if deskew:
+        angle = estimate_skew(np.asarray(out) == 0)
+        if angle:
+            out = out.rotate(angle, resample=Image.NEAREST, expand=True, fillcolor=255)
+    return out
@@ -0,0 +1,94 @@
+"""
+전처리 벤치마크 + 정확도 회귀 확인
+
+- uploads/ 의 JPEG 로 기존 전처리(legacy)와 ocr_preprocess 의 방식별 시간을 잰다
+- 정답 파일(기본: uploads/labels.csv, "파일명,정답숫자" 한 줄에 하나)이 있으면
+  방식별로 Tesseract 를 돌려 정답과 일치한 장수를 센다
+  (--method 방식이 legacy 보다 덜 맞으면 종료 코드 1)
+
+사용법
+  python ocr_preprocess_bench.py --dir uploads -n 20
+  python ocr_preprocess_bench.py --dir uploads --labels uploads/labels.csv --deskew
+"""
+import argparse
+import csv
+import glob
+import os
+import sys
+import time
+
+from PIL import Image
+import pytesseract
+
+from ocr_loadgen import percentile
+from ocr_preprocess import METHODS, preprocess, preprocess_legacy
+
+OCR_CONFIG = r"--oem 3 --psm 6 -c tessedit_char_whitelist=0123456789"  # ocr_server.py 와 같은 옵션
+
+
+def load_labels(path):
+    labels = {}
+    with open(path, newline="", encoding="utf-8") as f:
+        for row in csv.reader(f):
+            if len(row) >= 2 and not row[0].startswith("#"):
+                labels[row[0].strip()] = row[1].strip()
+    return labels
+
+
+def pipelines(deskew):
+    yield "legacy", preprocess_legacy
+    for m in METHODS:
+        yield m, (lambda img, m=m: preprocess(img, m, deskew))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--dir", default="uploads", help="JPEG 폴더")
+    parser.add_argument("--labels", default=None, help="정답 CSV (기본: <dir>/labels.csv)")
+    parser.add_argument("-n", type=int, default=10, help="이미지당 반복 횟수 (시간 측정)")
+    parser.add_argument("--deskew", action="store_true", help="새 방식에 기울기 보정 포함")
+    parser.add_argument("--method", default=os.environ.get("OCR_THRESH", "otsu"), choices=METHODS,
+                        help="회귀 확인할 방식 (서버 기본값과 같게)")
+    args = parser.parse_args()
+
+    files = sorted(glob.glob(os.path.join(args.dir, "*.jp*g")))
+    if not files:
+        raise SystemExit(f"{args.dir} 에 JPEG 파일이 없습니다")
+    images = {os.path.basename(f): Image.open(f).copy() for f in files}  # 디코딩은 측정에서 제외
+
+    print(f"이미지 {len(images)}장, 이미지당 {args.n}회")
+    for name, fn in pipelines(args.deskew):
+        times = []
+        for img in images.values():
+            for _ in range(args.n):
+                t0 = time.perf_counter()
+                fn(img)
+                times.append(time.perf_counter() - t0)
+        times.sort()
+        print("{:<7} 평균 {:.2f} ms, p50 {:.2f}, p99 {:.2f}".format(
+            name, sum(times) / len(times) * 1000, percentile(times, 50) * 1000, percentile(times, 99) * 1000))
+
+    label_path = args.labels or os.path.join(args.dir, "labels.csv")
+    if not os.path.exists(label_path):
+        print(f"정답 파일 {label_path} 이 없어 정확도 확인은 건너뜁니다")
+        return
+    labels = {k: v for k, v in load_labels(label_path).items() if k in images}
+    if not labels:
+        raise SystemExit("정답 파일에 있는 이미지가 폴더에 없습니다")
+
+    correct = {}
+    for name, fn in pipelines(args.deskew):
+        hits = 0
+        for fname, expected in labels.items():
+            text = pytesseract.image_to_string(fn(images[fname]), lang="eng", config=OCR_CONFIG)
+            hits += "".join(text.split()) == expected
+        correct[name] = hits
+        print(f"{name:<7} 정답 {hits}/{len(labels)}")
+
+    if correct[args.method] < correct["legacy"]:
+        print(f"{args.method} 전처리가 기존보다 정확도가 낮습니다")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
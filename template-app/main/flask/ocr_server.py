@@ -1,10 +1,15 @@
 from flask import Flask, request, jsonify, send_from_directory
 from werkzeug.exceptions import HTTPException, RequestEntityTooLarge, BadRequest
 from werkzeug.utils import secure_filename  # [NEW] secure_filename 누락 보완
-from PIL import Image, ImageOps
+from werkzeug.serving import WSGIRequestHandler
+from PIL import Image
+import io
 import os
 import pytesseract
 from datetime import datetime
+from ocr_pool import OcrPool, PoolBusy
+from ocr_archive import UploadArchiver
+from ocr_preprocess import preprocess
 
 app = Flask(__name__)
 
@@ -22,15 +27,33 @@ last_ocr_result = None
 
 pytesseract.pytesseract.tesseract_cmd = r"C:\ocr_teseract\tesseract.exe"
 
+# OCR 워커 풀 (OCR_POOL=0 이면 요청 스레드에서 바로 pytesseract 실행하는 기존 방식)
+USE_OCR_POOL = os.environ.get("OCR_POOL", "1") != "0"
+ocr_pool = OcrPool(
+    workers=int(os.environ.get("OCR_WORKERS", "2")),              # 동시에 도는 Tesseract 수
+    queue_size=int(os.environ.get("OCR_QUEUE", "16")),            # 대기 가능한 요청 수 (넘으면 503)
+    batch_max=int(os.environ.get("OCR_BATCH", "8")),              # 한 번에 OCR 할 최대 장수
+    batch_wait=float(os.environ.get("OCR_BATCH_WAIT_MS", "10")) / 1000,  # 배치를 모으는 최대 시간
+) if USE_OCR_POOL else None
+
+# 업로드 이미지 보관 (OCR_ARCHIVE=0 이면 보관하지 않음), OCR 은 메모리에서 바로 하고 저장은 백그라운드에서
+archiver = UploadArchiver(
+    UPLOAD_FOLDER,
+    queue_size=int(os.environ.get("OCR_ARCHIVE_QUEUE", "32")),                    # 저장 대기 가능한 장수 (넘으면 보관 생략)
+    max_bytes=int(os.environ.get("OCR_ARCHIVE_MAX_MB", "500")) * 1024 * 1024,    # 폴더 최대 크기 (넘으면 오래된 것부터 삭제)
+) if os.environ.get("OCR_ARCHIVE", "1") != "0" else None
+
 def allowed_file(filename) : # 파일 이름의 확장자가 허용된 것인지 확인함
     # .을 기준으로 뒤에서부터 1번만 분리하여 정확히 확장자만 분리
     return "." in filename and filename.rsplit(".", 1)[1].lower() in ALLOWED_EXTS
 
+# 전처리 방식 : otsu(자동 전역 임계값) / local(주변 평균 기준) / fixed(기존 고정 임계값 180), OCR_DESKEW=1 이면 기울기 보정
+PREPROCESS_METHOD = os.environ.get("OCR_THRESH", "otsu")
+PREPROCESS_DESKEW = os.environ.get("OCR_DESKEW", "0") == "1"
+
 def preprocess_for_digits(pil_img : Image.Image) -> Image.Image: # 타입 힌트, 입력 / 반환 pil_img, OCR전 전처리 용도
-    gray = pil_img.convert("L") # Luminance(밝기)조절로 노이즈는 줄이고 OCR 안정성을 높힘
-    gray = ImageOps.autocontrast(gray) # 가능 범위에서 글자와 배경에 대비를 줌
-    bw = gray.point(lambda x: 255 if x > 180 else 0, mode = "1") # 사진을 흑백 처리
-    return bw #이진수 이미지 반환 
+    # 회색조 변환 후 한 번에 이진화 (자세한 내용은 ocr_preprocess.py)
+    return preprocess(pil_img, PREPROCESS_METHOD, PREPROCESS_DESKEW) #이진수 이미지 반환 (글자 0, 배경 255)
 
 # [NEW] 모든 HTTP 예외를 JSON으로 반환
 @app.errorhandler(HTTPException)
@@ -76,16 +99,29 @@ def upload_image():
     # img.save(save_path) # 실제 파일을 디스크에 저장
     # return jsonify({"message" : "저장 완료", "filename" : unique, "path" : save_path}), 200 # 성공 LOG, HTTP status 코드 반환
 
-    img.save(save_path) # OCR 단계에서 열어볼 수 있도록 저장
+    data = img.read() # 디스크에 저장했다가 다시 여는 대신 요청 바디를 메모리에서 바로 디코딩
+    archived = archiver.submit(unique, data) if archiver else False # 보관은 백그라운드 스레드가 (OCR 을 기다리게 하지 않음)
 
     try:
-        pil = Image.open(save_path) # 이미지를 pillow 라이브러리로 열어서 Image 객체로 저장
+        pil = Image.open(io.BytesIO(data)) # 이미지를 pillow 라이브러리로 열어서 Image 객체로 저장
+        pil.draft("L", pil.size) # 컬러 JPEG 도 libjpeg 가 밝기(Y)만 디코딩 (흑백 JPEG 는 원래 L)
         proc = preprocess_for_digits(pil) # 사진을 함수로 넘겨 OCR용 사진으로 변화
-        custom = r"--oem 3 --psm 6 -c tessedit_char_whitelist=0123456789" #Tesseract OCR 옵션 문자열을 정의 (자세한건 모름 ㅋㅋ;;)
-        text = pytesseract.image_to_string(proc, lang="eng", config=custom) # 전처리된 이미지 proc을 OCR 실행
+        if ocr_pool:
+            text = ocr_pool.ocr(proc) # 워커 풀에 넘기고 결과만 기다림 (배치로 묶여서 처리됨)
+        else:
+            custom = r"--oem 3 --psm 6 -c tessedit_char_whitelist=0123456789" #Tesseract OCR 옵션 문자열을 정의 (자세한건 모름 ㅋㅋ;;)
+            text = pytesseract.image_to_string(proc, lang="eng", config=custom) # 전처리된 이미지 proc을 OCR 실행
 
         last_ocr_result = text.strip() 
 
+    except PoolBusy:
+        # OCR 큐가 가득 참 -> 클라이언트가 잠시 후 다시 보내도록 503
+        return jsonify({
+            "message": "저장 완료",
+            "filename": unique,
+            "error": "OCR 대기열이 가득 찼습니다. 잠시 후 다시 시도하세요."
+        }), 503, {"Retry-After": "1"}
+
     except pytesseract.TesseractNotFoundError:
         return jsonify({
             "test_value" : 1331231,
@@ -109,13 +145,27 @@ def upload_image():
         "value" : last_ocr_result,  # [NEW] 실제 OCR 결과를 value에도 반영
         "message" : "저장 및 OCR 완료",
         "filename" : unique,
-        "path" : f"/uploads/{unique}",  # [NEW] 브라우저 접근 경로로 보기 편하게
+        "path" : f"/uploads/{unique}" if archived else None,  # [NEW] 브라우저 접근 경로로 보기 편하게 (보관 안 했으면 None)
         "ocr_result" : last_ocr_result
     }), 200
 
     # (주의) 아래 코드는 도달 불가(unreachable)이므로 제거 대상이었음.
     # return jsonify({"message": "OCR 실패", "test_value": 12345}), 200
 
+@app.route("/stats")
+def ocr_stats():
+    # 워커 풀 상태 (처리한 장수, 배치 수, 평균 배치 크기, 거절 수, 대기 중인 요청 수)
+    if not ocr_pool:
+        return jsonify({"pool": False})
+    return jsonify({"pool": True, **ocr_pool.snapshot()})
+
+@app.route("/archive/stats")
+def archive_stats():
+    # 보관 상태 (저장/생략/삭제 장수, 폴더 사용량, 대기 중인 저장 수)
+    if not archiver:
+        return jsonify({"archive": False})
+    return jsonify({"archive": True, **archiver.snapshot()})
+
 @app.route("/")
 def get_result():
     # [NEW] JSON만 보내려면 루트도 JSON으로 응답
@@ -126,4 +176,7 @@ def uploaded_file(filename):
     return send_from_directory(app.config["UPLOAD_FOLDER"], filename)
 
 if __name__ == "__main__":
-    app.run(host="0.0.0.0", port = 5000, debug=True)
+    # ESP32 업로드 세션이 keep-alive로 연결을 재사용할 수 있도록 HTTP/1.1로 응답 (기본은 HTTP/1.0 -> 매번 연결 종료)
+    WSGIRequestHandler.protocol_version = "HTTP/1.1"
+    # OCR 풀과 보관 스레드는 import 시점에 뜨므로 reloader는 끈다 (켜면 감시 프로세스에도 일 안 하는 풀이 하나 더 뜸)
+    app.run(host="0.0.0.0", port = 5000, debug=True, use_reloader=False)
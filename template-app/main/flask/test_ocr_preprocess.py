@@ -0,0 +1,63 @@
+"""
+ocr_preprocess 의 fixed 방식이 기존 전처리(preprocess_legacy)와 같은 결과인지 확인
+
+- 그라데이션 (0~254, 1~255, 3~250 과 lo~hi 의 모든 조합) 과 무작위 이미지로 비교
+- 다르면 첫 번째로 다른 경우를 출력하고 종료 코드 1
+
+사용법
+  python test_ocr_preprocess.py
+"""
+import sys
+
+import numpy as np
+from PIL import Image
+
+from ocr_preprocess import preprocess, preprocess_legacy
+
+
+def same_as_legacy(gray):
+    legacy = np.asarray(preprocess_legacy(gray).convert("L"))
+    fixed = np.asarray(preprocess(gray, method="fixed"))
+    return np.array_equal(legacy, fixed)
+
+
+def gradient(lo, hi):
+    return Image.fromarray(np.arange(lo, hi + 1, dtype=np.uint8)[None, :], mode="L")
+
+
+def main():
+    failures = 0
+
+    for lo, hi in ((0, 254), (1, 255), (3, 250), (0, 255), (200, 200), (100, 100)):
+        if not same_as_legacy(gradient(lo, hi)):
+            print(f"FAIL gradient {lo}~{hi}")
+            failures += 1
+
+    # 밝기 범위가 [lo, hi] 인 모든 경우 (autocontrast 는 getextrema 만 보므로 이것으로 전부)
+    for lo in range(256):
+        for hi in range(lo, 256):
+            if not same_as_legacy(gradient(lo, hi)):
+                print(f"FAIL range {lo}~{hi}")
+                failures += 1
+                break
+
+    rng = np.random.default_rng(1)
+    for i in range(200):
+        lo, hi = sorted(rng.integers(0, 256, size=2))
+        pixels = rng.integers(lo, hi + 1, size=(48, 64), dtype=np.uint16).astype(np.uint8)
+        if not same_as_legacy(Image.fromarray(pixels, mode="L")):
+            print(f"FAIL random #{i} ({lo}~{hi})")
+            failures += 1
+
+    # 컬러 입력도 회색조 변환까지 같은 경로
+    rgb = rng.integers(0, 256, size=(48, 64, 3), dtype=np.uint16).astype(np.uint8)
+    if not same_as_legacy(Image.fromarray(rgb, mode="RGB")):
+        print("FAIL random RGB")
+        failures += 1
+
+    print(f"fixed vs legacy: {failures} failure(s)")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,152 @@
+"""
+ESP32 업로드 세션 확인용 로컬 HTTP 서버 (ocr_server.py 대용)
+
+- /upload 로 들어오는 multipart POST를 받아 OCR 없이 JSON만 돌려준다
+- TCP 연결 수와 요청 수를 세서 keep-alive 재사용 여부를 확인한다
+
+사용법
+  python upload_standin.py                    # 0.0.0.0:5000 에서 대기 (ESP32를 이 주소로 업로드)
+  python upload_standin.py --selftest -n 20   # 로컬에서 연결 재사용 / 매번 새 연결 업로드를 비교
+
+--selftest는 파이썬 http.client 로 서버와 측정 방법만 확인한다
+ESP_http.c 의 upload_session_* 와 바디 writer 는 test/host/test_upload_session.c 가
+가짜 esp_http_client 에 붙여 호스트에서 확인한다 (N회 업로드에 연결 1회, chunked 바디,
+Connection: close 후 재연결, 끊긴 재사용 연결의 재시도)
+실제 lwIP 소켓과 서버 사이의 동작은 ESP32를 이 서버에 붙여서 확인한다
+- 서버 로그의 [N conn / M req] 에서 req만 늘고 conn이 그대로면 연결 재사용
+- 서버를 재시작한 뒤 첫 업로드가 실패 없이 1 conn / 1 req 로 찍히면 재연결 재시도
+"""
+import argparse
+import http.client
+import json
+import socket
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+BOUNDARY = "----ESP32CamBoundary1234"  # ESP_http.c 와 같은 구분자
+
+stats_lock = threading.Lock()
+stats = {"connections": 0, "requests": 0}
+
+
+class UploadHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # keep-alive 허용
+    disable_nagle_algorithm = True  # 작은 응답이 delayed ACK에 묶이지 않도록
+
+    def setup(self):
+        super().setup()
+        with stats_lock:
+            stats["connections"] += 1
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        body = self.rfile.read(length)  # 요청 바디를 끝까지 읽어야 다음 요청을 같은 연결에서 받을 수 있음
+
+        with stats_lock:
+            stats["requests"] += 1
+            conns, reqs = stats["connections"], stats["requests"]
+
+        payload = json.dumps({
+            "test_value": 1331231,
+            "value": "0000",
+            "message": "stand-in",
+            "bytes": len(body),
+            "connections": conns,
+            "requests": reqs,
+        }).encode()
+
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(payload)))
+        if self.headers.get("Connection", "").lower() == "close":
+            self.send_header("Connection", "close")
+            self.close_connection = True
+        self.end_headers()
+        self.wfile.write(payload)
+
+    def log_message(self, fmt, *args):
+        print("[%d conn / %d req] %s" % (stats["connections"], stats["requests"], fmt % args))
+
+
+def multipart_body(jpg):
+    head = (
+        f"--{BOUNDARY}\r\n"
+        'Content-Disposition: form-data; name="image"; filename="esp32-cam.jpg"\r\n'
+        "Content-Type: image/jpeg\r\n\r\n"
+    ).encode()
+    tail = f"\r\n--{BOUNDARY}--\r\n".encode()
+    return head + jpg + tail
+
+
+def upload(conn, body, keep_alive):
+    headers = {
+        "Content-Type": f"multipart/form-data; boundary={BOUNDARY}",
+        "Accept": "application/json",
+        "Connection": "keep-alive" if keep_alive else "close",
+    }
+    conn.request("POST", "/upload", body=body, headers=headers)
+    resp = conn.getresponse()
+    resp.read()  # 응답을 다 읽어야 연결을 재사용할 수 있음
+    return resp.status
+
+
+def run_client(port, count, body, keep_alive):
+    with stats_lock:
+        stats["connections"] = 0
+        stats["requests"] = 0
+
+    t0 = time.perf_counter()
+    conn = None
+    for _ in range(count):
+        if conn is None:
+            conn = http.client.HTTPConnection("127.0.0.1", port, timeout=10)
+            conn.connect()
+            conn.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        assert upload(conn, body, keep_alive) == 200
+        if not keep_alive:
+            conn.close()
+            conn = None
+    if conn:
+        conn.close()
+    elapsed = time.perf_counter() - t0
+
+    with stats_lock:
+        return stats["connections"], stats["requests"], elapsed
+
+
+# 파이썬 클라이언트끼리의 비교 (ESP32 쪽 C 코드는 실행하지 않음)
+def selftest(count, size):
+    server = ThreadingHTTPServer(("127.0.0.1", 0), UploadHandler)
+    server.RequestHandlerClass.log_message = lambda *a: None
+    port = server.server_address[1]
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+
+    body = multipart_body(b"\xff\xd8" + bytes(size) + b"\xff\xd9")
+    print(f"업로드 {count}회, 사진 {size}B")
+    print("mode        , TCP 연결, 요청, 연결당 요청, 시간(ms)")
+    results = {}
+    for name, keep_alive in (("close", False), ("keep-alive", True)):
+        conns, reqs, elapsed = run_client(port, count, body, keep_alive)
+        results[name] = conns
+        print(f"{name:<12}, {conns:8d}, {reqs:4d}, {reqs / conns:11.1f}, {elapsed * 1000:8.1f}")
+    server.shutdown()
+
+    # 연결을 새로 맺을 때마다 TCP 핸드셰이크 1 RTT가 추가된다
+    assert results["keep-alive"] == 1, "keep-alive 세션이 연결을 재사용하지 못했습니다"
+    assert results["close"] == count
+    print(f"업로드당 절약한 RTT : {(results['close'] - results['keep-alive']) / count:.2f}")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--port", type=int, default=5000)
+    parser.add_argument("--selftest", action="store_true")
+    parser.add_argument("-n", type=int, default=20, help="selftest 업로드 횟수")
+    parser.add_argument("--size", type=int, default=30000, help="selftest 사진 크기(B)")
+    args = parser.parse_args()
+
+    if args.selftest:
+        selftest(args.n, args.size)
+    else:
+        ThreadingHTTPServer(("0.0.0.0", args.port), UploadHandler).serve_forever()
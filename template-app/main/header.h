@@ -10,18 +10,23 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <nvs_flash.h>
+#include <nvs.h>
 #include <unistd.h>
+#include <stdbool.h>
 
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_err.h"
 #include "esp_camera.h"
+#include "esp_camera_trace.h"
+#include "img_converters.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_mac.h"
 #include "esp_wps.h"
 #include "esp_vfs_dev.h"
 #include "esp_http_client.h"
+#include "esp_timer.h"
 
 #include "driver/uart.h"
 #include "driver/ledc.h"
@@ -30,6 +35,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
@@ -37,11 +44,16 @@
 #include "soc/soc.h"
 #include "soc/rtc_cntl_reg.h"
 
+#include "ESP_json_stream.h"
+#include "ESP_roi.h"
+#include "ESP_upload.h"
+#include "ESP_pipeline.h"
+
 // 함수 원형 선언
 void wifi_init(void);
-int sendPhoto(const char *url, char *resp_buf, size_t resp_buf_sz);
 esp_err_t init_camera(void);
 void tune_sensor_for_quality(void);
-void parse_json_body(const char *body, size_t len, esp_http_client_handle_t client);
+void parse_json_body(const char *body, size_t len, ocr_resp_t *out);
+void json_bench(int iterations, size_t chunk);
 
 #endif
\ No newline at end of file
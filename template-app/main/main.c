@@ -6,7 +6,6 @@
 // #define UART_RX_BUF (2048)
 // #define UART_TX_BUF (256)
 
-#define MAX_JSON_BODY 1024 // 서버 응답 메시지 제한
 
 // 서버 통신 설정
 static EventGroupHandle_t s_wifi_evt; // 핸들의 이벤트를 담는 변수
@@ -41,8 +40,6 @@ static const char *captureTag = "Take_Capture";
 static const char *flashTimerTag = "Flash_Timer";
 static const char *flashChannelTag = "Flash_Channel";
 static const char *WifiConfigTag = "Wifi_config";
-static const char *sendPhotoTag = "Send_Photo";
-static const char *cJsonParsingTag = "cJsonParsing";
 
 // 네트워크 ID, Password
 const char *ssid = "ORBI96";
@@ -75,10 +72,14 @@ static camera_config_t camera_config = {
     .xclk_freq_hz = 20000000, // 20 MHz
     .ledc_timer = LEDC_TIMER_0,
     .ledc_channel = LEDC_CHANNEL_0,
+#if CAPTURE_GRAYSCALE
+    .pixel_format = PIXFORMAT_GRAYSCALE, // YUV422에서 DMA가 Y만 골라 담음 -> 업로드 때 Y 한 채널 JPEG로 인코딩
+#else
     .pixel_format = PIXFORMAT_JPEG, // 웹스트리밍/스냅샷 용
+#endif
     .frame_size = FRAMESIZE_SVGA,   // SVGA, XGA
     .jpeg_quality = 8,              // 0(최고)~63(최저)
-    .fb_count = 2,                  // 더 크게 하면 프레임 안정 (2가 빨랐음)
+    .fb_count = PIPELINE_FB_COUNT,  // 업로드 중인 버퍼 + 다음 촬영 버퍼 (2가 빨랐음)
     .grab_mode = CAMERA_GRAB_LATEST,
     .fb_location = CAMERA_FB_IN_PSRAM,
 };
@@ -255,185 +256,6 @@ void wifi_init(void)
     ESP_LOGI(WifiConfigTag, "wifi_init finished. SSID:%s password:%s", wifi_config.sta.ssid, wifi_config.sta.password);
 }
 
-// 이미지 HTTP 전송
-int sendPhoto(const char *url, char *resp_buf, size_t resp_buf_sz)
-{
-    int rc = ESP_FAIL;
-    camera_fb_t *pic = NULL;
-    esp_http_client_handle_t client = NULL;
-
-    // 카메라 사진 촬영
-    ESP_ERROR_CHECK(ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, 500));
-    ESP_ERROR_CHECK(ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1));
-    vTaskDelay(pdMS_TO_TICKS(50));
-
-    pic = esp_camera_fb_get();
-
-    ESP_ERROR_CHECK(ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1, 0));
-    ESP_ERROR_CHECK(ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_1));
-
-    if (!pic || !pic->buf || pic->len == 0)
-    {
-        ESP_LOGE(captureTag, "사진 촬영 실패");
-        rc = -1;
-        goto WRITE_FAIL;
-    }
-
-    ESP_LOGI(captureTag, "사진이 찍혔습니다 ! / 사진 크기 : %zu", pic->len);
-
-    const char *boundary = "----ESP32CamBoundary1234"; // 멀티파트에서 각 파트를 구분하는 구분자 문자열
-    // 멀티파트의 앞 부분을 담음 (Boundary의 여러 정보들을 담으며 넉넉하게 확보)
-    char head[256];
-    // 멀티파트의 각 헤더로 서버가 읽을 필드명과 파일명을 지정함 (헤더와 바디 사이 빈 줄)
-    int head_len = snprintf(head, sizeof(head),
-                            "--%s\r\n"
-                            "Content-Disposition: form-data; name=\"image\"; filename=\"esp32-cam.jpg\"\r\n"
-                            "Content-Type: image/jpeg\r\n\r\n",
-                            boundary);
-
-    // 멀티파이트를 닫는 부분이라 짧음 (넉넉하게 확보)
-    char tail[64];
-    int tail_len = snprintf(tail, sizeof(tail), "\r\n--%s--\r\n", boundary);
-
-    if (head_len <= 0 || tail_len <= 0)
-    {
-        ESP_LOGE(sendPhotoTag, "snprintf 실패");
-        rc = -2;
-        goto WRITE_FAIL;
-    }
-
-    // 콘텐츠의 총 크기 (보내는 크기 + 사진 크기 + 보내기 종료 크기)
-    size_t content_len = (size_t)head_len + pic->len + (size_t)tail_len;
-
-    // HTTP 클라이언트 준비
-    esp_http_client_config_t cfg = {
-        .url = url,
-        .method = HTTP_METHOD_POST, // 전송 방식 (method에 POST)
-        .timeout_ms = 10000,        // waiting 시간
-        .keep_alive_enable = false, // 메모리 누수 방지용으로 끔
-    };
-
-    // HTTP Client 초기화
-    client = esp_http_client_init(&cfg);
-    if (!client)
-    {
-        ESP_LOGI(sendPhotoTag, "http client초기화 실패");
-        goto WRITE_FAIL;
-        return -3;
-    }
-
-    // 헤더 설정
-    esp_http_client_set_method(client, HTTP_METHOD_POST);
-    char ctype[128]; // HTTP 헤더 Content-Type에 넣을 문자열 버퍼이다
-    // (결과 문자열을 쓸 목적지 버퍼, 버퍼의 최대 크기, 출력 템플릿)
-    snprintf(ctype, sizeof(ctype), "multipart/form-data; boundary=%s", boundary);
-
-    // 서버에게 (바디가 멀티파트임을 알림, 경계값 제공, Content-Type 헤더 값) 를 넘김
-    esp_http_client_set_header(client, "Content-Type", ctype);
-    esp_http_client_set_header(client, "Accept", "application/json");
-    esp_http_client_set_header(client, "Accept-Encoding", "identity");
-    esp_http_client_set_header(client, "Connection", "close");
-
-    // 서버와 TCP 연결을 맺고, 요청 라인 헤더 정보들을 보낼 준비를 한다
-    esp_err_t err = esp_http_client_open(client, content_len);
-
-    if (err != ESP_OK)
-    {
-        ESP_LOGI(sendPhotoTag, "open 실패 %s", esp_err_to_name(err));
-        goto WRITE_FAIL; // 클라이언트 핸들 정리 (소켓 닫기, 내부 버퍼, 메모리 해제)
-        return -4;
-    } // 헤더 설정 코드 주석 & 이해 필요한 것 정리
-
-    if (esp_http_client_write(client, head, head_len) != head_len)
-    {
-        rc = -5;
-        goto WRITE_FAIL;
-    }
-    if (esp_http_client_write(client, (const char *)pic->buf, pic->len) != pic->len)
-    {
-        rc = -5;
-        goto WRITE_FAIL;
-    }
-    if (esp_http_client_write(client, tail, tail_len) != tail_len)
-    {
-        rc = -5;
-        goto WRITE_FAIL;
-    }
-
-    esp_http_client_fetch_headers(client);
-
-    // 응답 바디를 resp_buf로 읽기
-    int total = 0;
-    while (1)
-    {
-        int r = esp_http_client_read(client, resp_buf + total, (int)resp_buf_sz - 1 - total);
-        if (r <= 0)
-            break;
-        total += r;
-        if ((size_t)total >= resp_buf_sz - 1)
-            break;
-    }
-    resp_buf[total] = '\0';
-    // ESP_LOGI(sendPhotoTag, "RAW JSON (%dB): %.*s", total, total, resp_buf);
-
-    parse_json_body(resp_buf, total, client);
-    rc = ESP_OK;
-
-WRITE_FAIL: // 모든 설정들을 종료
-    if (client)
-    {
-        esp_http_client_close(client);
-        esp_http_client_cleanup(client);
-    }
-    if (pic)
-    {
-        esp_camera_fb_return(pic);
-    }
-    return rc;
-}
-
-void parse_json_body(const char *body, size_t len, esp_http_client_handle_t client)
-{
-    if (!body || len == 0 || len > MAX_JSON_BODY)
-    {
-        ESP_LOGE(cJsonParsingTag, "조건이 부합하지 않습니다. (len : %zu)", len);
-        return;
-    }
-
-    char *buffer = (char *)malloc(len + 1);
-    if (!buffer)
-    {
-        ESP_LOGE(cJsonParsingTag, "동적 메모리 할당 실패");
-        return;
-    }
-
-    memcpy(buffer, body, len);
-    buffer[len] = '\0';
-
-    cJSON *root = cJSON_Parse(buffer);
-    if (!root)
-    {
-        ESP_LOGE(cJsonParsingTag, "노드 얻어오기 실패");
-        free(buffer);
-        return;
-    }
-
-    cJSON *msg = cJSON_GetObjectItemCaseSensitive(root, "test_value");
-    if (cJSON_IsNumber(msg))
-    {
-        // int value = msg->valueint;
-        ESP_LOGI(cJsonParsingTag, "-----------------------\n valueInt : %d", msg->valueint);
-    }
-    else if (cJSON_IsString(msg))
-    {
-        // int value = atoi(msg->valueint);
-        ESP_LOGI(cJsonParsingTag, "-----------------------\n valueString : %s", msg->valuestring);
-    }
-
-    cJSON_Delete(root);
-    free(buffer);
-}
-
 void app_main(void)
 {
     uart_driver_delete(UART_NUM_0);
@@ -473,6 +295,28 @@ void app_main(void)
     }
     tune_sensor_for_quality();
 
+    // 저장된 관심 영역이 있으면 적용 (숫자 창만 업로드)
+    if (ESP_OK == roi_load() && roi_get()->enabled)
+    {
+        roi_apply(&roi_get()->rect);
+    }
+
+    // 업로드 세션은 한 번만 만들고 사진마다 같은 연결을 재사용
+    static upload_session_t session; // 태스크들이 계속 참조하므로 static
+    if (ESP_OK != upload_session_init(&session, url))
+    {
+        return;
+    }
+
+    // 촬영 / 업로드 / 파싱 태스크 시작 (프레임 큐 = fb_count)
+    // 업로드가 한 버퍼를 붙잡는 동안 capture 태스크가 남은 버퍼로 다음 사진을 찍음
+    esp_err_t err = pipeline_start(&session, camera_config.fb_count);
+    if (ESP_OK != err)
+    {
+        ESP_LOGE(captureTag, "파이프라인 시작 실패 %s", esp_err_to_name(err));
+        return;
+    }
+
     while (1)
     {
         // Flash 코드
@@ -486,16 +330,40 @@ void app_main(void)
 
             while (*str == '\r' || *str == '\n')
                 str++;
-            if (str[0] == '1')
+            // 숫자 N을 입력하면 N장을 연속으로 촬영/업로드 (촬영과 업로드가 겹쳐서 진행됨)
+            if (str[0] >= '1' && str[0] <= '9')
             {
                 xEventGroupWaitBits(s_wifi_evt, WIFI_GOTIP_BIT, false, true, portMAX_DELAY);
-
-                char resp[256];
-                esp_err_t err = sendPhoto(url, resp, sizeof(resp));
-                if (err != ESP_OK)
+                pipeline_trigger(str[0] - '0');
+            }
+            else if (str[0] == 's')
+            {
+                pipeline_log_stats();
+            }
+            else if (str[0] == 'r')
+            {
+                // "r x y w h" : ROI 설정 후 NVS 저장, "r" : ROI 해제
+                roi_rect_t rect;
+                if (sscanf(str + 1, "%hu %hu %hu %hu", &rect.x, &rect.y, &rect.w, &rect.h) == 4)
                 {
-                    ESP_LOGE(sendPhotoTag, "사진 전송 실패");
+                    if (ESP_OK == roi_apply(&rect))
+                    {
+                        roi_save(&roi_get()->rect);
+                    }
                 }
+                else
+                {
+                    roi_apply(NULL);
+                    roi_save(NULL);
+                }
+            }
+            else if (str[0] == 't')
+            {
+                pipeline_trace_toggle(); // 트레이스 시작, 한 번 더 누르면 JSON 출력
+            }
+            else if (str[0] == 'j')
+            {
+                json_bench(200, 128); // 응답 JSON 파싱 비교 (esp_http_client_read 조각 크기와 같게)
             }
         }
         else
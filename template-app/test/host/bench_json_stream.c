@@ -0,0 +1,111 @@
+/*
+ * Host benchmark for the streaming OCR response parser of the app
+ * (template-app/main/ESP_json_stream.c), the host side of json_bench().
+ *
+ * The sample OCR response is fed in pieces of 1 byte up to the whole body,
+ * through the same json_stream_bench() the device calls. With cJSON on the
+ * host, the parse_json_body() way (copy the body, build the tree, look the
+ * keys up) is timed next to it.
+ *
+ * Usage: json_stream_bench [--quick]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "ESP_json_stream.h"
+
+#ifdef HAVE_CJSON
+#include <cJSON.h>
+#endif
+
+static double s_min_ms = 200.0;
+
+/* iterations that take at least s_min_ms, in us per body (negative if the parse failed) */
+static double run_stream(const char *body, size_t len, size_t chunk, ocr_resp_t *out)
+{
+    for (int iterations = 16;; iterations *= 2) {
+        int64_t us = json_stream_bench(body, len, iterations, chunk, out);
+        if (us < 0) {
+            return -1;
+        }
+        if (us >= s_min_ms * 1000) {
+            return (double)us / iterations;
+        }
+    }
+}
+
+#ifdef HAVE_CJSON
+static double run_cjson(const char *body, size_t len, ocr_resp_t *out)
+{
+    for (int iterations = 16;; iterations *= 2) {
+        int64_t t0 = esp_timer_get_time();
+        for (int n = 0; n < iterations; n++) {
+            memset(out, 0, sizeof(*out));
+            char *copy = (char *)malloc(len + 1);
+            memcpy(copy, body, len);
+            copy[len] = '\0';
+            cJSON *root = cJSON_Parse(copy);
+            for (int i = 0; root && i < OCR_FIELD_COUNT; i++) {
+                cJSON *item = cJSON_GetObjectItemCaseSensitive(root, ocr_field_name(i));
+                if (cJSON_IsString(item)) {
+                    ocr_resp_field(out, i, item->valuestring, strlen(item->valuestring), false);
+                    ocr_resp_field(out, i, NULL, 0, true);
+                }
+            }
+            cJSON_Delete(root);
+            free(copy);
+        }
+        int64_t us = esp_timer_get_time() - t0;
+        if (us >= s_min_ms * 1000) {
+            return (double)us / iterations;
+        }
+    }
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    static const size_t chunks[] = { 1, 16, 128, 512, 0 };
+    const size_t len = strlen(json_bench_body);
+    int status = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            s_min_ms = 5;
+        } else {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    printf("OCR response %zu bytes, parser state %zu bytes\n", len, sizeof(json_stream_t));
+    printf("%-10s  %10s  %8s\n", "chunk", "us/body", "MB/s");
+    ocr_resp_t r;
+    for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        size_t chunk = chunks[c] ? chunks[c] : len;
+        double us = run_stream(json_bench_body, len, chunk, &r);
+        if (us < 0) {
+            printf("chunk %zu: parse failed\n", chunk);
+            status = 1;
+            continue;
+        }
+        printf("%-10zu  %10.3f  %8.1f\n", chunk, us, len / us);
+    }
+
+#ifdef HAVE_CJSON
+    ocr_resp_t cjson_r;
+    double us = run_cjson(json_bench_body, len, &cjson_r);
+    printf("%-10s  %10.3f  %8.1f\n", "cJSON", us, len / us);
+    for (int i = 0; i < OCR_FIELD_COUNT; i++) {
+        if (strcmp(r.fields[i].text, cjson_r.fields[i].text)) {
+            printf("\"%s\" differs from cJSON\n", ocr_field_name(i));
+            status = 1;
+        }
+    }
+#else
+    printf("(no cJSON on the host, stream parser only)\n");
+#endif
+    return status;
+}
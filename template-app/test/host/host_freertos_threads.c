@@ -0,0 +1,221 @@
+/*
+ * FreeRTOS queue/task implementation on real threads, for the camera
+ * component's host shims (components/esp32-camera/test/host/shims/freertos/,
+ * built with HOST_FREERTOS_THREADS).
+ *
+ * The component's host_freertos.c runs one task at a time on a simulated
+ * clock, which is what its cam_hal simulator needs to be deterministic. The
+ * app's capture/upload pipeline is only worth testing with its tasks
+ * overlapping, so it runs here instead: every task is a thread, queues block
+ * on a condition variable, and vTaskDelay() sleeps. Time is the monotonic
+ * clock of host_clock.c.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint8_t *items;
+    size_t len;
+    size_t item_size;
+    size_t head;
+    size_t count;
+};
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+};
+
+/* absolute CLOCK_MONOTONIC deadline, NULL for portMAX_DELAY */
+static const struct timespec *deadline(TickType_t ticks, struct timespec *ts)
+{
+    if (ticks == portMAX_DELAY) {
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    int64_t ns = ts->tv_nsec + (int64_t)ticks * portTICK_PERIOD_MS * 1000000;
+    ts->tv_sec += ns / 1000000000;
+    ts->tv_nsec = ns % 1000000000;
+    return ts;
+}
+
+/* wait for the queue to change; false once the deadline has passed */
+static bool queue_wait(QueueHandle_t q, TickType_t ticks, const struct timespec *until)
+{
+    if (ticks == 0) {
+        return false;
+    }
+    if (!until) {
+        pthread_cond_wait(&q->changed, &q->lock);
+        return true;
+    }
+    return pthread_cond_timedwait(&q->changed, &q->lock, until) != ETIMEDOUT;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size)
+{
+    QueueHandle_t q = calloc(1, sizeof(*q));
+    if (!q) {
+        return NULL;
+    }
+    q->items = calloc(len, item_size);
+    if (!q->items) {
+        free(q);
+        return NULL;
+    }
+    q->len = len;
+    q->item_size = item_size;
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&q->changed, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&q->lock, NULL);
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    if (q) {
+        pthread_cond_destroy(&q->changed);
+        pthread_mutex_destroy(&q->lock);
+        free(q->items);
+        free(q);
+    }
+}
+
+BaseType_t xQueueReset(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    q->head = 0;
+    q->count = 0;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks_to_wait)
+{
+    struct timespec ts;
+    const struct timespec *until = deadline(ticks_to_wait, &ts);
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->len) {
+        if (!queue_wait(q, ticks_to_wait, until)) {
+            pthread_mutex_unlock(&q->lock);
+            return pdFALSE;
+        }
+    }
+    memcpy(q->items + ((q->head + q->count) % q->len) * q->item_size, item, q->item_size);
+    q->count++;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    BaseType_t ok = xQueueSend(q, item, 0);
+    if (ok && woken) {
+        *woken = pdTRUE;
+    }
+    return ok;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks_to_wait)
+{
+    struct timespec ts;
+    const struct timespec *until = deadline(ticks_to_wait, &ts);
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0) {
+        if (!queue_wait(q, ticks_to_wait, until)) {
+            pthread_mutex_unlock(&q->lock);
+            return pdFALSE;
+        }
+    }
+    memcpy(item, q->items + q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->len;
+    q->count--;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t count = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return count;
+}
+
+/* ---- tasks ---- */
+
+static void *task_main(void *arg)
+{
+    struct host_task *t = arg;
+    t->fn(t->arg);
+    return NULL;
+}
+
+/* tasks run until the program exits, as they do on the chip */
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle)
+{
+    (void)name;
+    (void)stack;
+    (void)prio;
+    struct host_task *t = calloc(1, sizeof(*t));
+    if (!t) {
+        return pdFAIL;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    if (pthread_create(&t->thread, NULL, task_main, t)) {
+        free(t);
+        return pdFAIL;
+    }
+    pthread_detach(t->thread);
+    if (handle) {
+        *handle = t;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)core;
+    return xTaskCreate(fn, name, stack, arg, prio, handle);
+}
+
+/* only a task deleting itself (NULL) is supported */
+void vTaskDelete(TaskHandle_t task)
+{
+    if (!task) {
+        pthread_exit(NULL);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    int64_t ns = (int64_t)ticks * portTICK_PERIOD_MS * 1000000;
+    struct timespec ts = { ns / 1000000000, ns % 1000000000 };
+    while (nanosleep(&ts, &ts) && errno == EINTR) {
+    }
+}
@@ -0,0 +1,211 @@
+/*
+ * Host test for the streaming OCR response parser of the app
+ * (template-app/main/ESP_json_stream.c).
+ *
+ * Every body is fed split at each byte offset, and one byte at a time, the
+ * way esp_http_client_read() may hand it over. The OCR fields must come out
+ * the same as the expected values every time: escaped keys, escapes and
+ * surrogate pairs in values, nested values and numbers, and values longer
+ * than OCR_FIELD_MAX (truncated text, full length). Invalid escapes and
+ * unpaired surrogates must be rejected at every split. With cJSON on the
+ * host the expected values are also checked against cJSON_Parse, the way
+ * parse_json_body() reads them on the device.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ESP_json_stream.h"
+
+#ifdef HAVE_CJSON
+#include <cJSON.h>
+#endif
+
+static int s_failures;
+
+typedef struct {
+    const char *name;
+    const char *body;
+    bool valid;
+    const char *want[OCR_FIELD_COUNT]; // NULL if the key is missing
+} json_case_t;
+
+static const json_case_t s_cases[] = {
+    { "ocr response", json_bench_body, true, { "0012345", "0012345", NULL } },
+    { "escaped keys", "{\"val\\u0075e\": \"42\", \"ocr\\u005Fresult\": \"7\", \"err\\\\or\": \"x\", \"\\\"error\\\"\": \"y\"}",
+      true, { "42", "7", NULL } },
+    { "escapes in values", "{\"value\": \"a\\\"b\\\\c\\/d\\n\\t\\r\\b\\f\", \"error\": \"\\u0041\\u00e9\\u20AC\"}",
+      true, { "a\"b\\c/d\n\t\r\b\f", NULL, "A\xC3\xA9\xE2\x82\xAC" } },
+    { "surrogate pairs", "{\"value\": \"\\ud83d\\ude00 ok\", \"\\uD83D\\uDE00\": \"key\", \"error\": \"\\uDBFF\\uDFFF\"}",
+      true, { "\xF0\x9F\x98\x80 ok", NULL, "\xF4\x8F\xBF\xBF" } },
+    { "nested and primitive values",
+      "{\"meta\": {\"value\": \"no\", \"list\": [\"}\", \"\\\"]\"]}, \"value\": 12.5e3, \"error\": null, "
+      "\"ocr_result\":[1,{\"a\":\"]\"}]}",
+      true, { "12.5e3", "[1,{\"a\":\"]\"}]", "null" } },
+    { "long key", "{\"a_key_longer_than_json_key_max_value\": \"1\", \"value\": \"2\"}", true, { "2", NULL, NULL } },
+    { "empty object", " { } ", true, { NULL, NULL, NULL } },
+
+    { "invalid escape", "{\"value\": \"\\x41\"}", false },
+    { "invalid escape in key", "{\"va\\lue\": \"1\"}", false },
+    { "invalid escape in other key", "{\"other\": \"\\a\", \"value\": \"1\"}", false },
+    { "bad hex digit", "{\"value\": \"\\u12g4\"}", false },
+    { "lone high surrogate", "{\"value\": \"\\ud83d abc\"}", false },
+    { "high surrogate at end of string", "{\"value\": \"\\ud83d\"}", false },
+    { "high surrogate then later low", "{\"value\": \"\\ud83dx\\udc00\"}", false },
+    { "high surrogate then escape", "{\"value\": \"\\ud83d\\n\"}", false },
+    { "high surrogate then non-surrogate", "{\"value\": \"\\ud83d\\u0041\"}", false },
+    { "lone low surrogate", "{\"value\": \"\\ude00\"}", false },
+    { "lone surrogate in key", "{\"\\ud800\": 1}", false },
+    { "not an object", "[\"value\"]", false },
+};
+
+static const char *field_text(const ocr_resp_t *r, int key)
+{
+    return r->fields[key].found ? r->fields[key].text : "-";
+}
+
+/* the fields as ocr_resp_field() stores them: text cut to OCR_FIELD_MAX - 1 bytes, full length */
+static bool same_fields(const ocr_resp_t *r, const char *const *want)
+{
+    for (int i = 0; i < OCR_FIELD_COUNT; i++) {
+        const ocr_field_t *f = &r->fields[i];
+        if (!want[i]) {
+            if (f->found) {
+                return false;
+            }
+            continue;
+        }
+        size_t len = strlen(want[i]);
+        size_t kept = len < OCR_FIELD_MAX - 1 ? len : OCR_FIELD_MAX - 1;
+        if (!f->found || f->len != len || strlen(f->text) != kept || memcmp(f->text, want[i], kept)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* feed body in pieces of chunk bytes after a first piece of split bytes */
+static bool feed(const char *body, size_t len, size_t split, size_t chunk, ocr_resp_t *r)
+{
+    json_stream_t js;
+    ocr_resp_begin(r, &js);
+    bool ok = json_stream_feed(&js, body, split);
+    for (size_t off = split; off < len && ok; off += chunk) {
+        ok = json_stream_feed(&js, body + off, len - off < chunk ? len - off : chunk);
+    }
+    return ok && json_stream_done(&js);
+}
+
+#ifdef HAVE_CJSON
+/* what parse_json_body() would store: string values, and numbers as cJSON
+ * prints them, which equal the raw text's value but not always its form */
+static void check_cjson(const json_case_t *c)
+{
+    cJSON *root = cJSON_Parse(c->body);
+    if (!c->valid) {
+        if (root && cJSON_IsObject(root)) {
+            printf("FAIL %s: cJSON accepts it\n", c->name);
+            s_failures++;
+        }
+        cJSON_Delete(root);
+        return;
+    }
+    if (!root) {
+        printf("FAIL %s: cJSON rejects it\n", c->name);
+        s_failures++;
+        return;
+    }
+    for (int i = 0; i < OCR_FIELD_COUNT; i++) {
+        cJSON *item = cJSON_GetObjectItemCaseSensitive(root, ocr_field_name(i));
+        bool same = cJSON_IsString(item)   ? c->want[i] && !strcmp(item->valuestring, c->want[i])
+                    : cJSON_IsNumber(item) ? c->want[i] && strtod(c->want[i], NULL) == item->valuedouble
+                                           : (item != NULL) == (c->want[i] != NULL);
+        if (!same) {
+            printf("FAIL %s: \"%s\" differs from cJSON\n", c->name, ocr_field_name(i));
+            s_failures++;
+        }
+    }
+    cJSON_Delete(root);
+}
+#endif
+
+static void check_case(const json_case_t *c)
+{
+    size_t len = strlen(c->body);
+    ocr_resp_t r;
+
+    for (size_t split = 0; split <= len; split++) {
+        bool ok = feed(c->body, len, split, len, &r);
+        if (ok != c->valid || (ok && !same_fields(&r, c->want))) {
+            printf("FAIL %s: split at %zu: %s, value %s ocr_result %s error %s\n", c->name, split,
+                   ok ? "parsed" : "rejected", field_text(&r, 0), field_text(&r, 1), field_text(&r, 2));
+            s_failures++;
+            return;
+        }
+    }
+    bool ok = feed(c->body, len, 0, 1, &r);
+    if (ok != c->valid || (ok && !same_fields(&r, c->want))) {
+        printf("FAIL %s: one byte at a time\n", c->name);
+        s_failures++;
+    }
+#ifdef HAVE_CJSON
+    check_cjson(c);
+#endif
+}
+
+/* values longer than OCR_FIELD_MAX, with escapes and UTF-8 around the cut */
+static void check_long_values(void)
+{
+    for (size_t n = OCR_FIELD_MAX - 8; n <= 3 * OCR_FIELD_MAX; n += 7) {
+        char want[10 * OCR_FIELD_MAX];
+        char body[20 * OCR_FIELD_MAX];
+        size_t w = 0;
+        size_t b = (size_t)sprintf(body, "{\"error\": 0, \"value\": \"");
+        for (size_t i = 0; i < n; i++) {
+            switch (i % 5) {
+            case 1:
+                want[w++] = '"';
+                b += (size_t)sprintf(body + b, "\\\"");
+                break;
+            case 3:
+                memcpy(want + w, "\xEC\xA0\x80", 3); // U+C800
+                w += 3;
+                b += (size_t)sprintf(body + b, "\\uc800");
+                break;
+            default:
+                want[w++] = (char)('0' + i % 10);
+                body[b++] = (char)('0' + i % 10);
+                break;
+            }
+        }
+        want[w] = '\0';
+        char result[24];
+        snprintf(result, sizeof(result), "%zu", n);
+        sprintf(body + b, "\", \"ocr_result\": \"%s\"}", result);
+
+        char name[64];
+        snprintf(name, sizeof(name), "long value (%zu bytes)", w);
+        json_case_t c = { name, body, true, { want, result, "0" } };
+        check_case(&c);
+    }
+}
+
+int main(void)
+{
+    size_t count = sizeof(s_cases) / sizeof(s_cases[0]);
+    for (size_t i = 0; i < count; i++) {
+        check_case(&s_cases[i]);
+    }
+    check_long_values();
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+#ifdef HAVE_CJSON
+    printf("json stream: %zu bodies, every split matches the expected fields and cJSON\n", count);
+#else
+    printf("json stream: %zu bodies, every split matches the expected fields (no cJSON on the host)\n", count);
+#endif
+    return 0;
+}
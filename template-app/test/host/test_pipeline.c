@@ -0,0 +1,224 @@
+/*
+ * Host test for the app's capture -> upload -> parse pipeline
+ * (template-app/main/ESP_pipeline.c).
+ *
+ * The pipeline's tasks run on threads (host_freertos_threads.c). The camera
+ * and the HTTP upload are stubs that take fixed times: a capture is the
+ * pipeline's 50 ms flash delay plus FB_GET_MS in esp_camera_fb_get(), an
+ * upload is UPLOAD_MS and answers with a small OCR response. All frames are
+ * triggered at once and the upload is the slower stage, so:
+ *
+ *  - each frame's capture must overlap the upload of the frame before it,
+ *    judged from the times the stubs record as the stages start and end (not
+ *    from a throughput ratio, which a loaded machine can spoil);
+ *  - the capture task must be held back by the s_slots semaphore: no more
+ *    than the frame queue length of frames out of esp_camera_fb_get() and not
+ *    yet returned, and that many once the upload has fallen behind;
+ *  - every response reaches the parse task, in order.
+ *
+ * The frame queue is the shipped one: main.c sets fb_count to
+ * PIPELINE_FB_COUNT and starts the pipeline with a queue of fb_count frames.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "driver/ledc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "ESP_pipeline.h"
+#include "ESP_roi.h"
+
+#define FRAMES      10
+#define QUEUE_LEN   PIPELINE_FB_COUNT // the queue main.c starts the pipeline with
+#define FB_GET_MS   30
+#define UPLOAD_MS   100
+
+static int s_failures;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static camera_fb_t s_fbs[FRAMES];
+static uint8_t s_jpeg[1500];
+static int s_taken;
+static int s_held;     // out of esp_camera_fb_get() and not returned
+static int s_max_held;
+static int s_parsed;
+static int64_t s_capture_at[FRAMES][2]; // esp_camera_fb_get() entered, returned
+static int64_t s_upload_at[FRAMES][2];  // upload_session_send_frame() entered, returned
+
+/* ---- the camera, the upload and the app's other units, stubbed ---- */
+
+camera_fb_t *esp_camera_fb_get(void)
+{
+    int64_t t0 = esp_timer_get_time();
+    vTaskDelay(pdMS_TO_TICKS(FB_GET_MS));
+    pthread_mutex_lock(&s_lock);
+    camera_fb_t *fb = s_taken < FRAMES ? &s_fbs[s_taken++] : NULL;
+    if (fb) {
+        s_capture_at[fb - s_fbs][0] = t0;
+        s_capture_at[fb - s_fbs][1] = esp_timer_get_time();
+        fb->buf = s_jpeg;
+        fb->len = sizeof(s_jpeg);
+        fb->format = PIXFORMAT_JPEG;
+        if (++s_held > s_max_held) {
+            s_max_held = s_held;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return fb;
+}
+
+void esp_camera_fb_return(camera_fb_t *fb)
+{
+    (void)fb;
+    pthread_mutex_lock(&s_lock);
+    s_held--;
+    pthread_mutex_unlock(&s_lock);
+}
+
+esp_err_t esp_camera_get_fb_stats(camera_fb_stats_t *stats)
+{
+    (void)stats;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_camera_get_latency_stats(camera_latency_stage_t stage, camera_latency_stats_t *stats)
+{
+    (void)stage;
+    (void)stats;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void esp_camera_reset_latency_stats(void)
+{
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty)
+{
+    (void)speed_mode;
+    (void)channel;
+    (void)duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    (void)speed_mode;
+    (void)channel;
+    return ESP_OK;
+}
+
+/* no ROI: every frame goes out as captured */
+camera_fb_t *roi_frame(camera_fb_t *fb, camera_fb_t *tmp)
+{
+    (void)tmp;
+    return fb;
+}
+
+void roi_crop_free(camera_fb_t *dst)
+{
+    (void)dst;
+}
+
+/* the response names the frame, fed to the parser in two pieces */
+int upload_session_send_frame(upload_session_t *s, camera_fb_t *fb, uint8_t quality, json_stream_t *resp_parser)
+{
+    (void)quality;
+    s_upload_at[fb - s_fbs][0] = esp_timer_get_time();
+    vTaskDelay(pdMS_TO_TICKS(UPLOAD_MS));
+    char body[64];
+    int n = snprintf(body, sizeof(body), "{\"value\": \"%d\", \"error\": null}", (int)(fb - s_fbs));
+    if (!json_stream_feed(resp_parser, body, n / 2) || !json_stream_feed(resp_parser, body + n / 2, n - n / 2)) {
+        return -1;
+    }
+    s->last_body_len = fb->len;
+    s->uploads++;
+    s_upload_at[fb - s_fbs][1] = esp_timer_get_time();
+    return 200;
+}
+
+/* the parse task's output */
+void ocr_resp_log(const ocr_resp_t *r)
+{
+    pthread_mutex_lock(&s_lock);
+    char want[16];
+    snprintf(want, sizeof(want), "%d", s_parsed);
+    const ocr_field_t *f = &r->fields[OCR_FIELD_VALUE];
+    if (!f->found || strcmp(f->text, want) || !r->fields[OCR_FIELD_ERROR].found) {
+        printf("FAIL response %d: value \"%s\"\n", s_parsed, f->text);
+        s_failures++;
+    }
+    s_parsed++;
+    pthread_mutex_unlock(&s_lock);
+}
+
+/* ---- the test ---- */
+
+int main(void)
+{
+    upload_session_t session;
+    memset(&session, 0, sizeof(session));
+    if (pipeline_start(&session, QUEUE_LEN) != ESP_OK) {
+        printf("FAIL pipeline_start\n");
+        return 1;
+    }
+    pipeline_trigger(FRAMES);
+
+    // serial would take FRAMES * 180 ms
+    int parsed = 0;
+    for (int waited = 0; waited < 10000 && parsed < FRAMES; waited += 10) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        pthread_mutex_lock(&s_lock);
+        parsed = s_parsed;
+        pthread_mutex_unlock(&s_lock);
+    }
+
+    pipeline_stats_t st;
+    pipeline_get_stats(&st);
+    if (parsed != FRAMES || st.captured != FRAMES || st.uploaded != FRAMES || st.failed
+            || st.bytes != (uint64_t)FRAMES * sizeof(s_jpeg) || session.uploads != FRAMES) {
+        printf("FAIL %d parsed, %u captured, %u uploaded, %u failed, %llu bytes, want %d frames\n", parsed,
+               (unsigned)st.captured, (unsigned)st.uploaded, (unsigned)st.failed, (unsigned long long)st.bytes, FRAMES);
+        s_failures++;
+    }
+
+    double pipelined_ms = (st.last_done_us - st.first_capture_us) / 1000.0 / FRAMES;
+    double serial_ms = (st.capture_us + st.upload_us) / 1000.0 / FRAMES;
+    printf("capture %.1f ms, upload %.1f ms per frame\n", st.capture_us / 1000.0 / FRAMES,
+           st.upload_us / 1000.0 / FRAMES);
+    printf("pipelined %.1f ms per frame, serial %.1f ms: %.2fx\n", pipelined_ms, serial_ms, serial_ms / pipelined_ms);
+
+    // frame i + 1 is captured while frame i is uploaded: the two intervals intersect
+    int overlapped = 0;
+    for (int i = 0; i + 1 < FRAMES; i++) {
+        const int64_t *cap = s_capture_at[i + 1], *up = s_upload_at[i];
+        if (cap[0] < up[1] && up[0] < cap[1]) {
+            overlapped++;
+        } else {
+            printf("FAIL capture %d [%lld, %lld] us does not overlap upload %d [%lld, %lld] us\n", i + 1,
+                   (long long)(cap[0] - st.first_capture_us), (long long)(cap[1] - st.first_capture_us), i,
+                   (long long)(up[0] - st.first_capture_us), (long long)(up[1] - st.first_capture_us));
+            s_failures++;
+        }
+    }
+    printf("%d of %d captures overlap the previous upload\n", overlapped, FRAMES - 1);
+
+    pthread_mutex_lock(&s_lock);
+    int max_held = s_max_held, held = s_held;
+    pthread_mutex_unlock(&s_lock);
+    printf("at most %d frames held by the pipeline (frame queue %d)\n", max_held, QUEUE_LEN);
+    if (max_held != QUEUE_LEN || held != 0) {
+        printf("FAIL %d frames held at most, %d still held, want %d and 0\n", max_held, held, QUEUE_LEN);
+        s_failures++;
+    }
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("pipeline: uploads overlap captures, slots bound the frames in flight\n");
+    return 0;
+}
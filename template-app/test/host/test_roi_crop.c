@@ -0,0 +1,157 @@
+/*
+ * Host test for the software region-of-interest crop of the app
+ * (template-app/main/ESP_roi_crop.c).
+ *
+ * RGB565, YUV422 and grayscale frames whose pixels encode their own
+ * coordinates are cropped and compared byte for byte with the source pixels
+ * the clipped rectangle covers. The rectangles include an odd x (rounded down
+ * so YUYV pairs keep their U/V), sizes that are not multiples of 16 (rounded
+ * down to whole MCUs), a rectangle running past the frame edge (clipped
+ * first), and rectangles that leave nothing to crop.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ESP_roi.h"
+
+#define FRAME_W 100 // not a multiple of 16
+#define FRAME_H 60
+
+static int s_failures;
+
+typedef struct {
+    const char *name;
+    roi_rect_t rect;
+    bool ok;
+    roi_rect_t want; // the rectangle roi_crop must copy
+} crop_case_t;
+
+static const crop_case_t s_cases[] = {
+    { "whole frame", { 0, 0, FRAME_W, FRAME_H }, true, { 0, 0, 96, 48 } },
+    { "aligned", { 16, 8, 32, 16 }, true, { 16, 8, 32, 16 } },
+    { "odd x", { 5, 3, 40, 20 }, true, { 4, 3, 32, 16 } },
+    { "w/h not multiples of 16", { 10, 10, 50, 33 }, true, { 10, 10, 48, 32 } },
+    { "past the right/bottom edge", { 70, 20, 64, 64 }, true, { 70, 20, 16, 32 } },
+    { "odd x past the edge", { 67, 0, 200, 16 }, true, { 66, 0, 32, 16 } },
+    { "zero size", { 10, 10, 0, 0 }, false },
+    { "zero width", { 10, 10, 0, 16 }, false },
+    { "smaller than one MCU", { 0, 0, 15, 15 }, false },
+    { "clipped below one MCU", { 90, 0, 40, 40 }, false },
+    { "x outside", { FRAME_W, 0, 16, 16 }, false },
+    { "y outside", { 0, FRAME_H, 16, 16 }, false },
+};
+
+/* every byte depends on its pixel's position and its index within the pixel */
+static void fill_frame(camera_fb_t *fb, pixformat_t format, int bpp)
+{
+    memset(fb, 0, sizeof(*fb));
+    fb->width = FRAME_W;
+    fb->height = FRAME_H;
+    fb->format = format;
+    fb->len = (size_t)FRAME_W * FRAME_H * bpp;
+    fb->buf = (uint8_t *)malloc(fb->len);
+    for (int y = 0; y < FRAME_H; y++) {
+        for (int x = 0; x < FRAME_W; x++) {
+            for (int b = 0; b < bpp; b++) {
+                fb->buf[((size_t)y * FRAME_W + x) * bpp + b] = (uint8_t)(x * 7 + y * 13 + b * 101);
+            }
+        }
+    }
+}
+
+static void check_case(const char *fmt_name, const camera_fb_t *src, int bpp, const crop_case_t *c)
+{
+    camera_fb_t dst;
+    memset(&dst, 0, sizeof(dst));
+    bool ok = roi_crop(src, &c->rect, &dst);
+    if (ok != c->ok) {
+        printf("FAIL %s %s: roi_crop returned %d\n", fmt_name, c->name, ok);
+        s_failures++;
+        if (ok) {
+            roi_crop_free(&dst);
+        }
+        return;
+    }
+    if (!ok) {
+        return;
+    }
+
+    const roi_rect_t *w = &c->want;
+    if (dst.width != w->w || dst.height != w->h || dst.len != (size_t)w->w * w->h * bpp
+            || dst.format != src->format) {
+        printf("FAIL %s %s: %zux%zu %zu bytes, want %ux%u\n", fmt_name, c->name, dst.width, dst.height,
+               dst.len, w->w, w->h);
+        s_failures++;
+    } else {
+        for (int y = 0; y < w->h; y++) {
+            const uint8_t *want = src->buf + ((size_t)(w->y + y) * src->width + w->x) * bpp;
+            if (memcmp(dst.buf + (size_t)y * w->w * bpp, want, (size_t)w->w * bpp)) {
+                printf("FAIL %s %s: row %d differs from the source\n", fmt_name, c->name, y);
+                s_failures++;
+                break;
+            }
+        }
+    }
+    // the source frame is not changed, the crop owns its own buffer
+    if (dst.buf == src->buf) {
+        printf("FAIL %s %s: crop shares the source buffer\n", fmt_name, c->name);
+        s_failures++;
+    }
+    roi_crop_free(&dst);
+    if (dst.buf) {
+        printf("FAIL %s %s: roi_crop_free left the buffer\n", fmt_name, c->name);
+        s_failures++;
+    }
+}
+
+static void check_format(const char *name, pixformat_t format, int bpp)
+{
+    camera_fb_t src;
+    fill_frame(&src, format, bpp);
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        check_case(name, &src, bpp, &s_cases[i]);
+    }
+
+    // a frame shorter than width * height * bpp is refused
+    camera_fb_t dst;
+    roi_rect_t rect = { 0, 0, 16, 16 };
+    src.len--;
+    if (roi_crop(&src, &rect, &dst)) {
+        printf("FAIL %s: short frame cropped\n", name);
+        s_failures++;
+        roi_crop_free(&dst);
+    }
+    free(src.buf);
+}
+
+int main(void)
+{
+    check_format("rgb565", PIXFORMAT_RGB565, 2);
+    check_format("yuv422", PIXFORMAT_YUV422, 2);
+    check_format("grayscale", PIXFORMAT_GRAYSCALE, 1);
+
+    // compressed frames cannot be cropped
+    uint8_t jpg[64] = { 0 };
+    camera_fb_t fb = { .buf = jpg, .len = sizeof(jpg), .width = 32, .height = 32, .format = PIXFORMAT_JPEG };
+    camera_fb_t dst;
+    roi_rect_t rect = { 0, 0, 16, 16 };
+    if (roi_crop(&fb, &rect, &dst)) {
+        printf("FAIL jpeg frame cropped\n");
+        s_failures++;
+    }
+
+    // roi_clip on its own: the rectangle roi_apply stores
+    roi_rect_t r = { 5, 3, 40, 20 };
+    if (!roi_clip(&r, FRAME_W, FRAME_H) || r.x != 4 || r.y != 3 || r.w != 32 || r.h != 16) {
+        printf("FAIL roi_clip: %u,%u %ux%u\n", r.x, r.y, r.w, r.h);
+        s_failures++;
+    }
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("roi crop: %zu rectangles x 3 formats match the source pixels\n", sizeof(s_cases) / sizeof(s_cases[0]));
+    return 0;
+}
@@ -0,0 +1,435 @@
+/*
+ * Host test for the app's keep-alive upload session and body writer
+ * (template-app/main/ESP_http.c).
+ *
+ * esp_http_client is replaced by a fake with a server behind it that counts
+ * TCP connections, decodes each request body (Content-Length or chunked) and
+ * answers with a small OCR response, fed to the session's JSON parser.
+ *
+ *  - N uploads over one session must use one TCP connection, each body must be
+ *    the multipart head, the photo and the tail with the boundary the session
+ *    put in its Content-Type header;
+ *  - a frame that is not JPEG is encoded into the body as it goes, chunked;
+ *  - Content-Length and chunked uploads can take turns on one session, each
+ *    request carrying only the header of its own body mode;
+ *  - "Connection: close" in a response makes the next upload reconnect;
+ *  - a reused connection the server dropped while idle is retried once on a
+ *    new connection, a new connection that fails is not retried;
+ *  - a response lost after the whole body was sent is not retried, the server
+ *    may already have run OCR on it.
+ */
+#define _GNU_SOURCE // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_http_client.h"
+#include "img_converters.h"
+
+#include "ESP_upload.h"
+
+#define UPLOADS 8
+
+static int s_failures;
+
+#define CHECK(cond, ...) do {           \
+        if (!(cond)) {                  \
+            printf("FAIL " __VA_ARGS__); \
+            printf("\n");               \
+            s_failures++;               \
+        }                               \
+    } while (0)
+
+/* ---- the fake client and server ---- */
+
+struct esp_http_client {
+    esp_http_client_config_t cfg;
+    char content_type[128];
+    bool connected;
+    int write_len;          // of the request being sent, -1 for chunked
+    bool content_length;    // the Content-Length header is set
+    bool chunked;           // the Transfer-Encoding: chunked header is set
+    char req[8192];
+    size_t req_len;
+    char resp[64];
+    size_t resp_len, resp_pos;
+};
+
+static int s_tcp_connects;  // connections the server accepted
+static int s_connect_tries;
+static int s_requests;      // requests the server answered
+static bool s_refuse;       // the next connection attempts fail
+static bool s_idle_dropped; // the server closed the connection the client still holds
+static bool s_close_next;   // the next response says "Connection: close"
+static bool s_lose_response; // the next request is handled but its response never arrives
+static char s_body[8192];   // the last request body, de-chunked
+static size_t s_body_len;
+
+static void dispatch(esp_http_client_handle_t c, esp_http_client_event_id_t id, char *key, char *value)
+{
+    esp_http_client_event_t evt = {
+        .event_id = id, .client = c, .user_data = c->cfg.user_data, .header_key = key, .header_value = value,
+    };
+    c->cfg.event_handler(&evt);
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    esp_http_client_handle_t c = calloc(1, sizeof(*c));
+    if (c) {
+        c->cfg = *config;
+    }
+    return c;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t c, const char *key, const char *value)
+{
+    if (!strcmp(key, "Content-Type")) {
+        snprintf(c->content_type, sizeof(c->content_type), "%s", value);
+    }
+    return ESP_OK;
+}
+
+/* like esp_http_client, only the two headers open sets are tracked */
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t c, const char *key)
+{
+    if (!strcmp(key, "Content-Length")) {
+        c->content_length = false;
+    } else if (!strcmp(key, "Transfer-Encoding")) {
+        c->chunked = false;
+    }
+    return ESP_OK;
+}
+
+/* sets one of the two headers and, as esp_http_client does, never clears the other */
+esp_err_t esp_http_client_open(esp_http_client_handle_t c, int write_len)
+{
+    if (!c->connected) {
+        s_connect_tries++;
+        if (s_refuse) {
+            return ESP_FAIL;
+        }
+        s_tcp_connects++;
+        s_idle_dropped = false;
+        c->connected = true;
+    }
+    c->write_len = write_len;
+    if (write_len < 0) {
+        c->chunked = true;
+    } else {
+        c->content_length = true;
+    }
+    c->req_len = 0;
+    c->resp_len = c->resp_pos = 0;
+    return ESP_OK;
+}
+
+int esp_http_client_write(esp_http_client_handle_t c, const char *buffer, int len)
+{
+    // a connection the server dropped while idle is reset on the first write
+    if (!c->connected || s_idle_dropped || c->req_len + len > sizeof(c->req)) {
+        return -1;
+    }
+    memcpy(c->req + c->req_len, buffer, len);
+    c->req_len += len;
+    return len;
+}
+
+/* "size\r\n data \r\n" chunks up to a zero-size one; false if malformed */
+static bool dechunk(const char *p, size_t len)
+{
+    const char *end = p + len;
+    s_body_len = 0;
+    while (p < end) {
+        char *line_end;
+        unsigned long size = strtoul(p, &line_end, 16);
+        if (line_end == p || end - line_end < 2 || memcmp(line_end, "\r\n", 2)) {
+            return false;
+        }
+        p = line_end + 2;
+        if ((size_t)(end - p) < size + 2 || memcmp(p + size, "\r\n", 2)) {
+            return false;
+        }
+        if (size == 0) {
+            return p + 2 == end;
+        }
+        memcpy(s_body + s_body_len, p, size);
+        s_body_len += size;
+        p += size + 2;
+    }
+    return false;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t c)
+{
+    if (!c->connected || s_idle_dropped) {
+        return ESP_FAIL;
+    }
+    CHECK(c->content_length != c->chunked, "request %d: Content-Length %s, Transfer-Encoding %s", s_requests,
+          c->content_length ? "set" : "unset", c->chunked ? "set" : "unset");
+    if (c->write_len < 0) {
+        CHECK(dechunk(c->req, c->req_len), "request %d: malformed chunked body", s_requests);
+    } else {
+        CHECK(c->req_len == (size_t)c->write_len, "request %d: %zu bytes sent, Content-Length %d", s_requests,
+              c->req_len, c->write_len);
+        memcpy(s_body, c->req, c->req_len);
+        s_body_len = c->req_len;
+    }
+
+    if (s_lose_response) {
+        s_lose_response = false;
+        s_requests++;
+        return ESP_FAIL;
+    }
+
+    dispatch(c, HTTP_EVENT_ON_HEADER, "Content-Type", "application/json");
+    if (s_close_next) {
+        dispatch(c, HTTP_EVENT_ON_HEADER, "Connection", "close");
+        s_close_next = false;
+    }
+    c->resp_len = snprintf(c->resp, sizeof(c->resp), "{\"value\": \"%d\", \"error\": null}", s_requests);
+    s_requests++;
+    return c->resp_len;
+}
+
+int esp_http_client_read(esp_http_client_handle_t c, char *buffer, int len)
+{
+    // a few bytes at a time, as the response may arrive
+    int n = c->resp_len - c->resp_pos;
+    n = n < len ? n : len;
+    n = n < 7 ? n : 7;
+    memcpy(buffer, c->resp + c->resp_pos, n);
+    c->resp_pos += n;
+    return n;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t c)
+{
+    (void)c;
+    return 200;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t c)
+{
+    return c->resp_pos == c->resp_len;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t c)
+{
+    if (c->connected) {
+        c->connected = false;
+        dispatch(c, HTTP_EVENT_DISCONNECTED, NULL, NULL);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t c)
+{
+    free(c);
+    return ESP_OK;
+}
+
+/* the encoder: hands the frame over in uneven pieces, as fmt2jpg_cb_ex does */
+bool fmt2jpg_cb_ex(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format,
+                   const jpg_encoder_config_t *config, jpg_out_cb cb, void *arg)
+{
+    (void)width;
+    (void)height;
+    (void)format;
+    (void)config;
+    size_t index = 0;
+    for (size_t piece = 1; index < src_len; piece *= 3) {
+        size_t n = src_len - index < piece ? src_len - index : piece;
+        if (cb(arg, index, src + index, n) != n) {
+            return false;
+        }
+        index += n;
+    }
+    cb(arg, index, NULL, 0);
+    return true;
+}
+
+/* ---- checks ---- */
+
+static uint8_t s_photo[1500];
+
+/* the body is "--boundary" ... blank line, the photo, "\r\n--boundary--\r\n" */
+static void expect_body(const upload_session_t *s, const char *what)
+{
+    const char *b = strstr(s->client->content_type, "boundary=");
+    CHECK(b, "%s: no boundary in Content-Type \"%s\"", what, s->client->content_type);
+    if (!b) {
+        return;
+    }
+    char head[96], tail[96];
+    int head_len = snprintf(head, sizeof(head), "--%s\r\n", b + 9);
+    int tail_len = snprintf(tail, sizeof(tail), "\r\n--%s--\r\n", b + 9);
+    const char *blank = memmem(s_body, s_body_len, "\r\n\r\n", 4);
+    size_t photo_at = blank ? (size_t)(blank - s_body) + 4 : 0;
+
+    CHECK(s_body_len >= (size_t)head_len && !memcmp(s_body, head, head_len), "%s: body does not open with %s",
+          what, head);
+    const char *filename = memmem(s_body, s_body_len, "filename=", 9);
+    CHECK(blank && filename && filename < blank, "%s: no file part header", what);
+    CHECK(s_body_len == photo_at + sizeof(s_photo) + tail_len && !memcmp(s_body + photo_at, s_photo, sizeof(s_photo))
+          && !memcmp(s_body + photo_at + sizeof(s_photo), tail, tail_len), "%s: photo or tail mangled (%zu bytes)",
+          what, s_body_len);
+    CHECK(s->last_body_len == s_body_len, "%s: last_body_len %zu, want %zu", what, s->last_body_len, s_body_len);
+}
+
+static int upload(upload_session_t *s, ocr_resp_t *resp)
+{
+    json_stream_t parser;
+    ocr_resp_begin(resp, &parser);
+    return upload_session_send(s, s_photo, sizeof(s_photo), &parser);
+}
+
+static void expect_value(const ocr_resp_t *resp, int request, const char *what)
+{
+    char want[16];
+    snprintf(want, sizeof(want), "%d", request);
+    const ocr_field_t *f = &resp->fields[OCR_FIELD_VALUE];
+    CHECK(f->found && !strcmp(f->text, want), "%s: response value \"%s\", want \"%s\"", what, f->text, want);
+}
+
+static void test_keep_alive(void)
+{
+    upload_session_t s;
+    ocr_resp_t resp;
+    int base = s_requests;
+    CHECK(upload_session_init(&s, "http://192.168.0.2:5000/upload") == ESP_OK, "upload_session_init");
+
+    for (int i = 0; i < UPLOADS; i++) {
+        int status = upload(&s, &resp);
+        CHECK(status == 200, "keep-alive upload %d: status %d", i, status);
+        expect_body(&s, "keep-alive");
+        expect_value(&resp, base + i, "keep-alive");
+    }
+    printf("%d uploads, %d TCP connection(s)\n", s.uploads, s.connects);
+    CHECK(s.uploads == UPLOADS && s.connects == 1 && s_tcp_connects == 1,
+          "%d uploads over %d connection(s) (server saw %d), want %d over 1", s.uploads, s.connects, s_tcp_connects,
+          UPLOADS);
+    upload_session_deinit(&s);
+}
+
+static void test_chunked_frame(void)
+{
+    upload_session_t s;
+    json_stream_t parser;
+    ocr_resp_t resp;
+    int base = s_requests, tcp = s_tcp_connects;
+    upload_session_init(&s, "http://192.168.0.2:5000/upload");
+
+    camera_fb_t fb = {
+        .buf = s_photo, .len = sizeof(s_photo), .width = 30, .height = 25, .format = PIXFORMAT_RGB565,
+    };
+    for (int i = 0; i < 2; i++) {
+        ocr_resp_begin(&resp, &parser);
+        int status = upload_session_send_frame(&s, &fb, UPLOAD_JPEG_QUALITY, &parser);
+        CHECK(status == 200, "chunked frame %d: status %d", i, status);
+        expect_body(&s, "chunked");
+        expect_value(&resp, base + i, "chunked");
+    }
+    CHECK(s.connects == 1 && s_tcp_connects == tcp + 1, "chunked: %d connection(s), want 1", s.connects);
+    upload_session_deinit(&s);
+}
+
+static void test_mixed_modes(void)
+{
+    upload_session_t s;
+    json_stream_t parser;
+    ocr_resp_t resp;
+    int base = s_requests;
+    upload_session_init(&s, "http://192.168.0.2:5000/upload");
+
+    camera_fb_t fb = {
+        .buf = s_photo, .len = sizeof(s_photo), .width = 30, .height = 25, .format = PIXFORMAT_RGB565,
+    };
+    for (int i = 0; i < 4; i++) {
+        int status;
+        if (i % 2) {
+            ocr_resp_begin(&resp, &parser);
+            status = upload_session_send_frame(&s, &fb, UPLOAD_JPEG_QUALITY, &parser);
+        } else {
+            status = upload(&s, &resp);
+        }
+        CHECK(status == 200, "mixed %d (%s): status %d", i, i % 2 ? "chunked" : "Content-Length", status);
+        expect_body(&s, "mixed");
+        expect_value(&resp, base + i, "mixed");
+    }
+    CHECK(s.connects == 1, "mixed: %d connection(s), want 1", s.connects);
+    upload_session_deinit(&s);
+}
+
+static void test_reconnect(void)
+{
+    upload_session_t s;
+    ocr_resp_t resp;
+    upload_session_init(&s, "http://192.168.0.2:5000/upload");
+    upload(&s, &resp);
+
+    // the server says it closes: the next upload connects again
+    s_close_next = true;
+    CHECK(upload(&s, &resp) == 200 && s.connected == false, "Connection: close not honoured");
+    CHECK(upload(&s, &resp) == 200 && s.connects == 2, "after Connection: close: %d connection(s), want 2",
+          s.connects);
+
+    // the server dropped the idle connection: one retry on a new one
+    int requests = s_requests;
+    s_idle_dropped = true;
+    int status = upload(&s, &resp);
+    CHECK(status == 200 && s.connects == 3 && s_requests == requests + 1,
+          "dropped connection: status %d, %d connection(s), want 200 and 3", status, s.connects);
+    expect_body(&s, "retried");
+    expect_value(&resp, requests, "retried");
+
+    // dropped and the server unreachable: the retry fails, no second retry
+    s_idle_dropped = true;
+    s_refuse = true;
+    int tries = s_connect_tries;
+    status = upload(&s, &resp);
+    CHECK(status < 0 && s_connect_tries == tries + 1, "unreachable after drop: status %d, %d connect(s), want 1",
+          status, s_connect_tries - tries);
+
+    // the body went out on the reused connection, the response did not come back:
+    // the server has the photo, so it is not sent again
+    s_refuse = false;
+    CHECK(upload(&s, &resp) == 200 && s.connected, "upload after the server came back");
+    requests = s_requests;
+    tries = s_connect_tries;
+    s_lose_response = true;
+    status = upload(&s, &resp);
+    CHECK(status < 0 && s_requests == requests + 1 && s_connect_tries == tries,
+          "lost response: status %d, %d request(s), %d connect(s), want 1 request and no connect", status,
+          s_requests - requests, s_connect_tries - tries);
+
+    // no connection to reuse: a failed connect is not retried
+    s_refuse = true;
+    tries = s_connect_tries;
+    status = upload(&s, &resp);
+    CHECK(status < 0 && s_connect_tries == tries + 1, "unreachable: status %d, %d connect(s), want 1", status,
+          s_connect_tries - tries);
+
+    s_refuse = false;
+    CHECK(upload(&s, &resp) == 200, "upload after the server came back");
+    upload_session_deinit(&s);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(s_photo); i++) {
+        s_photo[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+
+    test_keep_alive();
+    test_chunked_frame();
+    test_mixed_modes();
+    test_reconnect();
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("upload session: all checks passed\n");
+    return 0;
+}